@@ -0,0 +1,695 @@
+/*
+ * @file benchmark_main.c
+ * @brief Benchmark harness for all inversion engines
+ *
+ * Runs every selected engine over a sweep of matrix sizes with warm-up and
+ * repeated runs on a monotonic clock, and reports min/median/p95 time,
+ * GFLOP/s and nominal bytes moved. The output is CSV or JSON whose first
+ * three columns follow the schema of Metrics/combined_data.csv
+ * (Matrix Size, Time (ms), Type), with Time being the median.
+ *
+ * Run with mpiexec to include the MPI engine, the shared-memory engines
+ * only run on rank 0. The out-of-core engine goes through a scratch file
+ * and only runs when selected with -engines=ooc, the tiled engine likewise
+ * with -engines=tiled, the blocks engine with -engines=blocks and the
+ * structured engine with -engines=structured (once per thread count each,
+ * the blocks engine with -kind=blocks or band to matter and the structured
+ * one with -kind=toeplitz or circulant).
+ *
+ * -precision=float|complex times the float and complex double kernels
+ * instead, their Type gets the name of the precision appended.
+ *
+ * -tune=<profile> times the serial engine and the OpenMP engine over every
+ * thread count and ownership chunk of the sweep (and the tiled, blocks and
+ * structured engines over every thread count if they are selected), and records the fastest
+ * of each size in a tuning profile (see helpers/tuning.h) that the OpenMP
+ * program reads with -tuning=, along with the time of every thread count.
+ */
+
+#include "engines.h"
+#include "matrix_inverse_mpi.h"
+#include "helpers/timer.h"
+#include "helpers/verify.h"
+#include "helpers/matrix_gen.h"
+#include "helpers/placement.h"
+#include "matrix_inversion_ooc.h"
+#include "helpers/tuning.h"
+
+#include <mpi.h>
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <math.h>
+
+#define MAX_LIST 64
+
+enum output_format
+{
+    FORMAT_CSV,
+    FORMAT_JSON
+};
+
+struct bench_options
+{
+    int sizes[MAX_LIST];
+    int nsizes;
+    int threads[MAX_LIST];
+    int nthreads;
+    int chunks[MAX_LIST]; /* Fixed ownership chunks tried besides the page-sized one */
+    int nchunks;
+    bool run_serial;
+    bool run_openmp;
+    bool run_mpi;
+    bool run_ooc;
+    bool run_tiled;
+    bool run_blocks;
+    bool run_structured;
+    int warmup;
+    int repeat;
+    struct matrix_spec spec; /* Kind and seed of the benchmark matrices */
+    enum scalar_type precision;
+    enum output_format format;
+    const char *output;
+    enum verify_mode verify;
+    const char *tune_path;
+};
+
+struct bench_stats
+{
+    double min;
+    double median;
+    double p95;
+    double mean;
+};
+
+struct bench_writer
+{
+    FILE *fp;
+    enum output_format format;
+    int rows;
+};
+
+static void print_benchmark_usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-sizes=100,200,400|100:1000:100] [-engines=serial,openmp,mpi,ooc,tiled,blocks,structured] [-threads=1,2,4]\n", prog);
+    fprintf(stderr, "          [-warmup=<runs>] [-repeat=<runs>] [-seed=<seed>] [-format=csv|json] [-output=<file>]\n");
+    fprintf(stderr, "          [-kind=uniform|dominant|spd[=cond]|cond[=cond]|blocks[=size]|band[=width]|toeplitz|circulant] [-verify[=sampled|full]]\n");
+    fprintf(stderr, "          [-pin] [-hugepages=off|thp|explicit] [-ooc-memory=<MB>] [-precision=double|float|complex]\n");
+    fprintf(stderr, "          [-chunks=8,64] [-tune=<profile>]\n");
+}
+
+/* Parse "a,b,c" where each item is a number or a start:end:step range */
+static bool parse_int_list(const char *arg, int *values, int *count)
+{
+    *count = 0;
+    const char *p = arg;
+    while (*p)
+    {
+        int start, end, step, consumed;
+        if (sscanf(p, "%d:%d:%d%n", &start, &end, &step, &consumed) == 3 && step > 0)
+        {
+            for (int v = start; v <= end && *count < MAX_LIST; v += step)
+            {
+                values[(*count)++] = v;
+            }
+        }
+        else if (sscanf(p, "%d%n", &start, &consumed) == 1 && *count < MAX_LIST)
+        {
+            values[(*count)++] = start;
+        }
+        else
+        {
+            return false;
+        }
+
+        p += consumed;
+        if (*p == ',')
+        {
+            p++;
+        }
+        else if (*p)
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < *count; i++)
+    {
+        if (values[i] < 1)
+        {
+            return false;
+        }
+    }
+    return *count > 0;
+}
+
+static bool parse_benchmark_options(int argc, char *argv[], struct bench_options *opts)
+{
+    opts->nsizes = 0;
+    parse_int_list("100,200,400", opts->sizes, &opts->nsizes);
+    opts->threads[0] = omp_get_max_threads();
+    opts->nthreads = 1;
+    opts->nchunks = 0;
+    bool sizes_set = false, threads_set = false, chunks_set = false;
+    opts->run_serial = opts->run_openmp = opts->run_mpi = true;
+    opts->run_ooc = opts->run_tiled = opts->run_blocks = opts->run_structured = false;
+    opts->warmup = 2;
+    opts->repeat = 10;
+    opts->spec.seed = 1;
+    parse_matrix_kind("dominant", &opts->spec);
+    opts->precision = SCALAR_DOUBLE;
+    opts->format = FORMAT_CSV;
+    opts->output = NULL;
+    opts->verify = VERIFY_NONE;
+    opts->tune_path = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strncmp(arg, "-sizes=", 7) == 0)
+        {
+            if (!parse_int_list(arg + 7, opts->sizes, &opts->nsizes))
+            {
+                fprintf(stderr, "Error: invalid size list %s\n", arg + 7);
+                return false;
+            }
+            sizes_set = true;
+        }
+        else if (strncmp(arg, "-threads=", 9) == 0)
+        {
+            if (!parse_int_list(arg + 9, opts->threads, &opts->nthreads))
+            {
+                fprintf(stderr, "Error: invalid thread list %s\n", arg + 9);
+                return false;
+            }
+            threads_set = true;
+        }
+        else if (strncmp(arg, "-chunks=", 8) == 0)
+        {
+            if (!parse_int_list(arg + 8, opts->chunks, &opts->nchunks))
+            {
+                fprintf(stderr, "Error: invalid chunk list %s\n", arg + 8);
+                return false;
+            }
+            chunks_set = true;
+        }
+        else if (strncmp(arg, "-tune=", 6) == 0)
+        {
+            opts->tune_path = arg + 6;
+        }
+        else if (strncmp(arg, "-engines=", 9) == 0)
+        {
+            opts->run_serial = strstr(arg + 9, "serial") != NULL;
+            opts->run_openmp = strstr(arg + 9, "openmp") != NULL;
+            opts->run_mpi = strstr(arg + 9, "mpi") != NULL;
+            opts->run_ooc = strstr(arg + 9, "ooc") != NULL;
+            opts->run_tiled = strstr(arg + 9, "tiled") != NULL;
+            opts->run_blocks = strstr(arg + 9, "blocks") != NULL;
+            opts->run_structured = strstr(arg + 9, "structured") != NULL;
+        }
+        else if (strncmp(arg, "-warmup=", 8) == 0)
+        {
+            opts->warmup = atoi(arg + 8);
+        }
+        else if (strncmp(arg, "-repeat=", 8) == 0)
+        {
+            opts->repeat = atoi(arg + 8);
+        }
+        else if (strncmp(arg, "-seed=", 6) == 0)
+        {
+            opts->spec.seed = strtoull(arg + 6, NULL, 10);
+        }
+        else if (strncmp(arg, "-kind=", 6) == 0)
+        {
+            if (!parse_matrix_kind(arg + 6, &opts->spec))
+            {
+                fprintf(stderr, "Error: unknown matrix kind %s\n", arg + 6);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "-format=csv") == 0)
+        {
+            opts->format = FORMAT_CSV;
+        }
+        else if (strcmp(arg, "-format=json") == 0)
+        {
+            opts->format = FORMAT_JSON;
+        }
+        else if (strncmp(arg, "-output=", 8) == 0)
+        {
+            opts->output = arg + 8;
+        }
+        else if (strcmp(arg, "-verify") == 0)
+        {
+            opts->verify = VERIFY_SAMPLED;
+        }
+        else if (strncmp(arg, "-verify=", 8) == 0)
+        {
+            if (!parse_verify_mode(arg + 8, &opts->verify))
+            {
+                fprintf(stderr, "Error: unknown verification mode %s\n", arg + 8);
+                return false;
+            }
+        }
+        else if (strcmp(arg, "-pin") == 0)
+        {
+            placement_set_pinning(true);
+        }
+        else if (strncmp(arg, "-hugepages=", 11) == 0)
+        {
+            enum huge_page_mode mode;
+            if (!parse_huge_page_mode(arg + 11, &mode))
+            {
+                fprintf(stderr, "Error: unknown huge page mode %s\n", arg + 11);
+                return false;
+            }
+            placement_set_huge_pages(mode);
+        }
+        else if (strncmp(arg, "-precision=", 11) == 0)
+        {
+            if (!parse_scalar_type(arg + 11, &opts->precision))
+            {
+                fprintf(stderr, "Error: unknown precision %s\n", arg + 11);
+                return false;
+            }
+        }
+        else if (strncmp(arg, "-ooc-memory=", 12) == 0)
+        {
+            double mb = atof(arg + 12);
+            if (mb <= 0)
+            {
+                fprintf(stderr, "Error: invalid out-of-core memory limit %s\n", arg + 12);
+                return false;
+            }
+            ooc_set_memory_limit((size_t)(mb * 1024 * 1024));
+        }
+        else
+        {
+            fprintf(stderr, "Error: unknown argument %s\n", arg);
+            return false;
+        }
+    }
+
+    if (opts->warmup < 0 || opts->repeat < 1)
+    {
+        fprintf(stderr, "Error: need -warmup >= 0 and -repeat >= 1\n");
+        return false;
+    }
+    if ((opts->run_ooc || opts->run_tiled || opts->run_blocks || opts->run_structured) && opts->precision != SCALAR_DOUBLE)
+    {
+        fprintf(stderr, "Error: the out-of-core, tiled, blocks and structured engines only invert double matrices\n");
+        return false;
+    }
+
+    /* Tuning picks between the shared-memory engines, over a wider grid unless one is given */
+    if (opts->tune_path)
+    {
+        opts->run_mpi = opts->run_ooc = false;
+        if (!sizes_set)
+        {
+            parse_int_list("16,32,64,128,256,512,1024", opts->sizes, &opts->nsizes);
+        }
+        if (!threads_set)
+        {
+            int max_threads = omp_get_max_threads();
+            opts->nthreads = 0;
+            for (int t = 1; t < max_threads; t *= 2)
+            {
+                opts->threads[opts->nthreads++] = t;
+            }
+            opts->threads[opts->nthreads++] = max_threads;
+        }
+        if (!chunks_set)
+        {
+            parse_int_list("8,64", opts->chunks, &opts->nchunks);
+        }
+    }
+    return true;
+}
+
+static int compare_doubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+/* Summarize the samples, they are sorted in place */
+static void compute_stats(double *samples, int count, struct bench_stats *st)
+{
+    qsort(samples, count, sizeof(double), compare_doubles);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        sum += samples[i];
+    }
+
+    st->min = samples[0];
+    st->median = (count % 2) ? samples[count / 2] : 0.5 * (samples[count / 2 - 1] + samples[count / 2]);
+    int p95_rank = (95 * count + 99) / 100; /* Nearest-rank percentile */
+    st->p95 = samples[p95_rank - 1];
+    st->mean = sum / count;
+}
+
+static void write_header(struct bench_writer *w)
+{
+    if (w->format == FORMAT_CSV)
+    {
+        fprintf(w->fp, "Matrix Size,Time (ms),Type,Min (ms),P95 (ms),Mean (ms),GFLOP/s,Bytes Moved,GB/s,Runs\n");
+    }
+    else
+    {
+        fprintf(w->fp, "[\n");
+    }
+}
+
+static void write_row(struct bench_writer *w, int n, const char *type, enum scalar_type precision, const struct bench_stats *st,
+                      int runs)
+{
+    double seconds = st->median / 1000.0;
+    double gflops = inversion_flops(n, precision) / seconds / 1e9;
+    double bytes = inversion_bytes(n, precision);
+    double gbps = bytes / seconds / 1e9;
+
+    if (w->format == FORMAT_CSV)
+    {
+        fprintf(w->fp, "%d,%.3f,%s,%.3f,%.3f,%.3f,%.3f,%.0f,%.3f,%d\n",
+                n, st->median, type, st->min, st->p95, st->mean, gflops, bytes, gbps, runs);
+    }
+    else
+    {
+        fprintf(w->fp, "%s  {\"Matrix Size\": %d, \"Time (ms)\": %.3f, \"Type\": \"%s\", \"Min (ms)\": %.3f, "
+                       "\"P95 (ms)\": %.3f, \"Mean (ms)\": %.3f, \"GFLOP/s\": %.3f, \"Bytes Moved\": %.0f, "
+                       "\"GB/s\": %.3f, \"Runs\": %d}",
+                w->rows ? ",\n" : "", n, st->median, type, st->min, st->p95, st->mean, gflops, bytes, gbps, runs);
+    }
+    fflush(w->fp);
+    w->rows++;
+}
+
+static void write_footer(struct bench_writer *w)
+{
+    if (w->format == FORMAT_JSON)
+    {
+        fprintf(w->fp, "\n]\n");
+    }
+}
+
+/* Name of a row, engine (and thread or rank count) with the precision appended unless it is double */
+static void type_label(char *buf, size_t size, const char *base, enum scalar_type precision)
+{
+    if (precision == SCALAR_DOUBLE)
+    {
+        snprintf(buf, size, "%s", base);
+    }
+    else
+    {
+        snprintf(buf, size, "%s_%s", base, scalar_type_name(precision));
+    }
+}
+
+/* Keep the faster of best and the configuration just timed */
+static void tune_candidate(struct tuning_entry *best, enum engine_kind kind, int threads, int chunk_rows, double ms)
+{
+    if (ms < best->ms)
+    {
+        snprintf(best->engine, sizeof(best->engine), "%s", engine_name(kind));
+        best->threads = threads;
+        best->chunk_rows = chunk_rows;
+        best->ms = ms;
+    }
+}
+
+/* Keep the faster time of a thread count, ms[t] belongs to opts->threads[t] */
+static void tune_scaling(double *ms, int t, double median)
+{
+    ms[t] = median < ms[t] ? median : ms[t];
+}
+
+/* Record the time of every thread count timed at size n, one thread also covers the serial engine */
+static void record_scaling(const struct bench_options *opts, int n, const double *ms, double serial_ms)
+{
+    bool serial_done = false;
+    for (int t = 0; t < opts->nthreads; t++)
+    {
+        double best = ms[t];
+        if (opts->threads[t] == 1)
+        {
+            best = serial_ms < best ? serial_ms : best;
+            serial_done = true;
+        }
+        if (best < INFINITY)
+        {
+            tuning_record_scaling(&(struct tuning_scaling){opts->precision, n, opts->threads[t], best});
+        }
+    }
+    if (!serial_done && serial_ms < INFINITY)
+    {
+        tuning_record_scaling(&(struct tuning_scaling){opts->precision, n, 1, serial_ms});
+    }
+}
+
+/* Check the inverse of the last run, the summary goes to stderr to keep the table clean */
+static void verify_engine(const char *type, int n, const void *mat, const void *mat_inv, const struct bench_options *opts)
+{
+    if (opts->verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        verify_inverse_typed(opts->precision, opts->verify, n, mat, mat_inv, &res);
+        print_verify_result(stderr, type, &res);
+    }
+}
+
+/* Time one shared-memory engine, only called on rank 0 */
+static bool time_engine(enum engine_kind kind, int n, void *mat, void *mat_inv, const struct bench_options *opts, double *samples)
+{
+    for (int run = 0; run < opts->warmup + opts->repeat; run++)
+    {
+        double start = now_ms();
+        if (!run_engine_typed(kind, opts->precision, n, mat, mat_inv))
+        {
+            fprintf(stderr, "%s inversion failed for %dx%d matrix.\n", engine_name(kind), n, n);
+            return false;
+        }
+        double end = now_ms();
+
+        if (run >= opts->warmup)
+        {
+            samples[run - opts->warmup] = end - start;
+        }
+    }
+    return true;
+}
+
+/* Time the MPI engine, called collectively on all ranks */
+static void time_mpi_engine(int n, const void *mat, void *mat_inv, const struct bench_options *opts, double *samples)
+{
+    for (int run = 0; run < opts->warmup + opts->repeat; run++)
+    {
+        MPI_Barrier(MPI_COMM_WORLD);
+        double start = now_ms();
+        inverse_matrix_mpi_typed(opts->precision, n, mat, mat_inv);
+        MPI_Barrier(MPI_COMM_WORLD);
+        double end = now_ms();
+
+        if (run >= opts->warmup)
+        {
+            samples[run - opts->warmup] = end - start;
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    MPI_Init(&argc, &argv);
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    struct bench_options opts;
+    if (!parse_benchmark_options(argc, argv, &opts))
+    {
+        if (rank == 0)
+        {
+            print_benchmark_usage(argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    struct bench_writer writer = {stdout, opts.format, 0};
+    if (rank == 0 && opts.output)
+    {
+        writer.fp = fopen(opts.output, "w");
+        if (!writer.fp)
+        {
+            perror("Error opening benchmark output");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+    if (rank == 0)
+    {
+        write_header(&writer);
+    }
+
+    /* Tuning adds to (or updates) the profile already at that path */
+    FILE *existing = opts.tune_path && rank == 0 ? fopen(opts.tune_path, "r") : NULL;
+    if (existing)
+    {
+        fclose(existing);
+        if (!tuning_load(opts.tune_path))
+        {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    double *samples = malloc(opts.repeat * sizeof(double));
+    double thread_ms[MAX_LIST];
+    char base[32], type[48];
+    struct bench_stats st;
+
+    for (int s = 0; s < opts.nsizes; s++)
+    {
+        int n = opts.sizes[s];
+        size_t bytes = (size_t)n * n * scalar_size(opts.precision);
+        void *mat = malloc(bytes);
+        void *mat_inv = malloc(bytes);
+        /* Every rank generates the same matrix, the entries only depend on the seed */
+        struct matrix_spec spec = opts.spec;
+        spec.n = n;
+        if (!mat || !mat_inv || !generate_matrix_typed(&spec, opts.precision, mat))
+        {
+            fprintf(stderr, "Not enough memory for a %dx%d matrix.\n", n, n);
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        struct tuning_entry best = {.type = opts.precision, .n = n, .ms = INFINITY};
+        double serial_ms = INFINITY;
+        for (int t = 0; t < opts.nthreads; t++)
+        {
+            thread_ms[t] = INFINITY;
+        }
+
+        if (rank == 0 && opts.run_serial && time_engine(ENGINE_SERIAL, n, mat, mat_inv, &opts, samples))
+        {
+            type_label(type, sizeof(type), engine_name(ENGINE_SERIAL), opts.precision);
+            compute_stats(samples, opts.repeat, &st);
+            write_row(&writer, n, type, opts.precision, &st, opts.repeat);
+            verify_engine(type, n, mat, mat_inv, &opts);
+            tune_candidate(&best, ENGINE_SERIAL, 1, 0, st.median);
+            serial_ms = st.median;
+        }
+
+        if (rank == 0 && opts.run_openmp)
+        {
+            int default_threads = omp_get_max_threads();
+            for (int t = 0; t < opts.nthreads; t++)
+            {
+                omp_set_num_threads(opts.threads[t]);
+                /* The page-sized default chunk (c = 0), then the fixed ones */
+                for (int c = 0; c <= opts.nchunks; c++)
+                {
+                    int chunk_rows = c ? opts.chunks[c - 1] : 0;
+                    placement_set_chunk_rows(chunk_rows);
+                    if (time_engine(ENGINE_OPENMP, n, mat, mat_inv, &opts, samples))
+                    {
+                        int len = snprintf(base, sizeof(base), "%s_%d", engine_name(ENGINE_OPENMP), opts.threads[t]);
+                        if (chunk_rows)
+                        {
+                            snprintf(base + len, sizeof(base) - len, "_chunk%d", chunk_rows);
+                        }
+                        type_label(type, sizeof(type), base, opts.precision);
+                        compute_stats(samples, opts.repeat, &st);
+                        write_row(&writer, n, type, opts.precision, &st, opts.repeat);
+                        verify_engine(type, n, mat, mat_inv, &opts);
+                        tune_candidate(&best, ENGINE_OPENMP, opts.threads[t], chunk_rows, st.median);
+                        tune_scaling(thread_ms, t, st.median);
+                    }
+                }
+            }
+            placement_set_chunk_rows(0);
+            omp_set_num_threads(default_threads);
+        }
+
+        /* The tiled, blocks and structured engines over the thread counts */
+        enum engine_kind per_thread[] = {ENGINE_TILED, ENGINE_BLOCKS, ENGINE_STRUCTURED};
+        bool selected[] = {opts.run_tiled, opts.run_blocks, opts.run_structured};
+        for (int e = 0; e < 3; e++)
+        {
+            if (rank != 0 || !selected[e])
+            {
+                continue;
+            }
+            int default_threads = omp_get_max_threads();
+            for (int t = 0; t < opts.nthreads; t++)
+            {
+                omp_set_num_threads(opts.threads[t]);
+                if (time_engine(per_thread[e], n, mat, mat_inv, &opts, samples))
+                {
+                    snprintf(type, sizeof(type), "%s_%d", engine_name(per_thread[e]), opts.threads[t]);
+                    compute_stats(samples, opts.repeat, &st);
+                    write_row(&writer, n, type, opts.precision, &st, opts.repeat);
+                    verify_engine(type, n, mat, mat_inv, &opts);
+                    tune_candidate(&best, per_thread[e], opts.threads[t], 0, st.median);
+                }
+            }
+            omp_set_num_threads(default_threads);
+        }
+
+        if (rank == 0 && opts.tune_path && best.ms < INFINITY)
+        {
+            tuning_record(&best);
+            record_scaling(&opts, n, thread_ms, serial_ms);
+            fprintf(stderr, "Tuned %dx%d: %s engine, %d threads, %d-row chunks (0: page-sized), %.3f ms\n", n, n, best.engine,
+                    best.threads, best.chunk_rows, best.ms);
+        }
+
+        if (rank == 0 && opts.run_ooc && time_engine(ENGINE_OUT_OF_CORE, n, mat, mat_inv, &opts, samples))
+        {
+            compute_stats(samples, opts.repeat, &st);
+            write_row(&writer, n, engine_name(ENGINE_OUT_OF_CORE), opts.precision, &st, opts.repeat);
+            verify_engine(engine_name(ENGINE_OUT_OF_CORE), n, mat, mat_inv, &opts);
+        }
+
+        if (opts.run_mpi)
+        {
+            time_mpi_engine(n, mat, mat_inv, &opts, samples);
+            if (rank == 0)
+            {
+                snprintf(base, sizeof(base), "MPI_%d", size);
+                type_label(type, sizeof(type), base, opts.precision);
+                compute_stats(samples, opts.repeat, &st);
+                write_row(&writer, n, type, opts.precision, &st, opts.repeat);
+                verify_engine(type, n, mat, mat_inv, &opts);
+            }
+        }
+
+        free(mat_inv);
+        free(mat);
+    }
+
+    if (rank == 0 && opts.tune_path)
+    {
+        if (!tuning_save(opts.tune_path))
+        {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        fprintf(stderr, "Tuning profile written to %s\n", opts.tune_path);
+    }
+
+    if (rank == 0)
+    {
+        write_footer(&writer);
+        if (writer.fp != stdout)
+        {
+            fclose(writer.fp);
+        }
+    }
+
+    free(samples);
+    MPI_Finalize();
+    return 0;
+}
@@ -0,0 +1,145 @@
+/*
+ * @file engines.c
+ * @brief Run-time selection of the shared-memory inversion engines
+ */
+
+#include "engines.h"
+#include "matrix_inversion.h"
+#include "matrix_inversion_parallel.h"
+#include "matrix_inversion_ooc.h"
+#include "matrix_inversion_tiled.h"
+#include "matrix_inversion_blocks.h"
+#include "matrix_inversion_structured.h"
+#include "matrix_inversion_typed.h"
+#include "helpers/placement.h"
+#include "helpers/tuning.h"
+
+#include <omp.h>
+#include <stdio.h>   /* printf */
+#include <strings.h> /* strcasecmp */
+
+static const char *engine_names[ENGINE_COUNT] = {
+    [ENGINE_SERIAL] = "Serial",
+    [ENGINE_OPENMP] = "OpenMP",
+    [ENGINE_OUT_OF_CORE] = "OutOfCore",
+    [ENGINE_TILED] = "Tiled",
+    [ENGINE_BLOCKS] = "Blocks",
+    [ENGINE_STRUCTURED] = "Structured",
+};
+
+static enum engine_kind default_engine = ENGINE_OPENMP;
+
+const char *engine_name(enum engine_kind kind)
+{
+    return (kind >= 0 && kind < ENGINE_COUNT) ? engine_names[kind] : "Unknown";
+}
+
+bool parse_engine(const char *name, enum engine_kind *kind)
+{
+    for (int k = 0; k < ENGINE_COUNT; k++)
+    {
+        if (strcasecmp(name, engine_names[k]) == 0)
+        {
+            *kind = (enum engine_kind)k;
+            return true;
+        }
+    }
+    return false;
+}
+
+enum engine_kind select_engine(enum scalar_type type, int n)
+{
+    /* Entries only override the thread count for their own inversions */
+    static int default_threads = 0;
+    if (default_threads == 0)
+    {
+        default_threads = omp_get_max_threads();
+    }
+
+    const struct tuning_entry *entry = tuning_lookup(type, n);
+    enum engine_kind kind;
+    if (!entry || !parse_engine(entry->engine, &kind) || kind == ENGINE_OUT_OF_CORE)
+    {
+        omp_set_num_threads(default_threads);
+        placement_set_chunk_rows(0);
+        return default_engine;
+    }
+
+    omp_set_num_threads(entry->threads);
+    placement_set_chunk_rows(entry->chunk_rows);
+    if (kind == ENGINE_SERIAL)
+    {
+        printf("Tuning profile: Serial engine for %dx%d (tuned at %d)\n", n, n, entry->n);
+    }
+    else if (kind == ENGINE_TILED)
+    {
+        int b = tiled_tile_size(n);
+        printf("Tuning profile: Tiled engine with %d threads and %dx%d tiles for %dx%d (tuned at %d)\n", entry->threads, b, b, n,
+               n, entry->n);
+    }
+    else if (kind == ENGINE_BLOCKS || kind == ENGINE_STRUCTURED)
+    {
+        printf("Tuning profile: %s engine with %d threads for %dx%d (tuned at %d)\n", engine_name(kind), entry->threads, n, n,
+               entry->n);
+    }
+    else
+    {
+        char chunk[32] = "page-sized";
+        if (entry->chunk_rows > 0)
+        {
+            snprintf(chunk, sizeof(chunk), "%d-row", entry->chunk_rows);
+        }
+        printf("Tuning profile: %s engine with %d threads and %s chunks for %dx%d (tuned at %d)\n", engine_name(kind),
+               entry->threads, chunk, n, n, entry->n);
+    }
+    return kind;
+}
+
+void set_default_engine(enum engine_kind kind)
+{
+    default_engine = kind;
+}
+
+bool run_engine(enum engine_kind kind, int n, double mat[n][n], double mat_inv[n][n])
+{
+    switch (kind)
+    {
+    case ENGINE_SERIAL:
+        return invert_matrix(n, n, mat, mat_inv);
+    case ENGINE_OPENMP:
+        return invert_matrix_par(n, n, mat, mat_inv);
+    case ENGINE_OUT_OF_CORE:
+        return invert_matrix_ooc_in_memory(n, mat, mat_inv);
+    case ENGINE_TILED:
+        return invert_matrix_tiled(n, mat, mat_inv);
+    case ENGINE_BLOCKS:
+        return invert_matrix_blocks(n, mat, mat_inv);
+    case ENGINE_STRUCTURED:
+        return invert_matrix_structured(n, mat, mat_inv);
+    default:
+        return false;
+    }
+}
+
+bool run_engine_typed(enum engine_kind kind, enum scalar_type type, int n, void *mat, void *mat_inv)
+{
+    switch (type)
+    {
+    case SCALAR_DOUBLE:
+        return run_engine(kind, n, mat, mat_inv);
+    default:
+        return kind != ENGINE_OUT_OF_CORE && kind != ENGINE_TILED && kind != ENGINE_BLOCKS && kind != ENGINE_STRUCTURED &&
+               invert_matrix_typed(type, kind == ENGINE_OPENMP, n, mat, mat_inv);
+    }
+}
+
+double inversion_flops(int n, enum scalar_type type)
+{
+    return 2.0 * n * n * n * scalar_flop_factor(type);
+}
+
+double inversion_bytes(int n, enum scalar_type type)
+{
+    /* n steps, each reading and writing n x 2n elements */
+    return 2.0 * scalar_size(type) * n * (2.0 * n) * n;
+}
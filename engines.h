@@ -0,0 +1,56 @@
+#ifndef ENGINES_H
+#define ENGINES_H
+
+#include <stdbool.h>
+
+#include "helpers/scalar.h"
+
+/* Shared-memory inversion engines that can be selected at run time.
+ * The MPI engine needs every rank to take part and is driven separately
+ * (see matrix_inverse_mpi.h).
+ */
+enum engine_kind
+{
+    ENGINE_SERIAL,
+    ENGINE_OPENMP,
+    ENGINE_OUT_OF_CORE,
+    ENGINE_TILED,
+    ENGINE_BLOCKS,
+    ENGINE_STRUCTURED,
+    ENGINE_COUNT
+};
+
+/* Name used on the command line and in the metrics ("Serial", "OpenMP", "OutOfCore", "Tiled", "Blocks", "Structured") */
+const char *engine_name(enum engine_kind kind);
+
+/* Case-insensitive lookup of an engine by name, returns false if unknown */
+bool parse_engine(const char *name, enum engine_kind *kind);
+
+/* Engine for an n x n matrix of the given type as the loaded tuning profile (see helpers/tuning.h)
+ * picks it: its thread count and ownership chunk are applied for the following inversions. Without
+ * a matching entry the default engine with the thread count of the run and the default chunk.
+ */
+enum engine_kind select_engine(enum scalar_type type, int n);
+
+/* Engine select_engine falls back to, ENGINE_OPENMP unless set (e.g. to ENGINE_BLOCKS by -blocks or
+ * ENGINE_STRUCTURED by -structure) */
+void set_default_engine(enum engine_kind kind);
+
+/* Invert the n x n matrix mat into mat_inv with the given engine, mat is left unchanged */
+bool run_engine(enum engine_kind kind, int n, double mat[n][n], double mat_inv[n][n]);
+
+/* The same for n x n arrays of any element type, the out-of-core, tiled, blocks and structured engines only
+ * take doubles */
+bool run_engine_typed(enum engine_kind kind, enum scalar_type type, int n, void *mat, void *mat_inv);
+
+/* Nominal cost of inverting an n x n matrix, used to report GFLOP/s and bandwidth.
+ *
+ * inversion_flops is the standard 2n^3 operation count of a matrix inverse,
+ * in real flops (four per complex multiply-add).
+ * inversion_bytes assumes each of the n pivot steps streams the n x 2n
+ * augmented matrix through memory once (one read and one write).
+ */
+double inversion_flops(int n, enum scalar_type type);
+double inversion_bytes(int n, enum scalar_type type);
+
+#endif
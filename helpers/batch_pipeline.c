@@ -0,0 +1,518 @@
+/*
+ * @file batch_pipeline.c
+ * @brief Pipelined batch processing of many matrix files
+ *
+ * A prefetch thread reads and parses the next matrices while the calling
+ * thread inverts the current one, and a write-back thread stores finished
+ * inverses. The three stages are connected by bounded queues so that memory
+ * use stays bounded by the configured depths. In concurrent mode the compute
+ * stage dispatches the matrices to lane threads with their own core sets.
+ */
+
+#include "batch_pipeline.h"
+#include "bounded_queue.h"
+#include "file_reader.h"
+#include "common.h"
+
+#include <stdio.h>     /* printf, perror, FILE */
+#include <stdlib.h>    /* malloc, free, qsort */
+#include <string.h>    /* strlen, strcmp, strrchr, memcpy */
+#include <dirent.h>    /* opendir, readdir */
+#include <sys/stat.h>  /* stat */
+#include <sys/time.h>  /* gettimeofday */
+#include <pthread.h>   /* pthread_create, pthread_join */
+#include <omp.h>       /* omp_set_num_threads */
+
+#define BATCH_MAX_PATH 4096
+
+struct batch_stage
+{
+    char **paths;
+    int count;
+    const char *out_dir;
+    struct bounded_queue *in;
+    struct bounded_queue *out;
+    int failures;
+};
+
+/* Core accounting of the concurrent compute stage */
+struct batch_scheduler
+{
+    pthread_mutex_t lock;
+    pthread_cond_t released;
+    bool *busy;     /* Per core */
+    int free_cores;
+    int failures;
+    struct bounded_queue assigned; /* Dispatched jobs waiting for a lane */
+    struct bounded_queue *inverted;
+    batch_invert_fn invert;
+    void *arg;
+};
+
+struct batch_lane
+{
+    struct batch_scheduler *sched;
+    int index;
+};
+
+static int compare_paths(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Append a copy of path to the growing list */
+static bool append_path(char ***paths, int *count, int *capacity, const char *path)
+{
+    if (*count == *capacity)
+    {
+        int new_capacity = *capacity ? 2 * *capacity : 64;
+        char **grown = (char **)realloc(*paths, new_capacity * sizeof(char *));
+        if (!grown)
+        {
+            perror("realloc (batch paths)");
+            return false;
+        }
+        *paths = grown;
+        *capacity = new_capacity;
+    }
+
+    size_t len = strlen(path) + 1;
+    (*paths)[*count] = (char *)malloc(len);
+    if (!(*paths)[*count])
+    {
+        perror("malloc (batch path)");
+        return false;
+    }
+    memcpy((*paths)[*count], path, len);
+    (*count)++;
+    return true;
+}
+
+static bool list_directory(const char *dirpath, char ***paths, int *count, int *capacity)
+{
+    DIR *dir = opendir(dirpath);
+    if (!dir)
+    {
+        perror("Error opening batch directory");
+        return false;
+    }
+
+    struct dirent *entry;
+    char path[BATCH_MAX_PATH];
+    bool ok = true;
+    while (ok && (entry = readdir(dir)) != NULL)
+    {
+        if (entry->d_name[0] == '.')
+        {
+            continue;
+        }
+
+        snprintf(path, sizeof(path), "%s/%s", dirpath, entry->d_name);
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+        {
+            ok = append_path(paths, count, capacity, path);
+        }
+    }
+    closedir(dir);
+
+    if (ok)
+    {
+        qsort(*paths, *count, sizeof(char *), compare_paths);
+    }
+    return ok;
+}
+
+static bool list_manifest(const char *manifest, char ***paths, int *count, int *capacity)
+{
+    FILE *fp = fopen(manifest, "r");
+    if (!fp)
+    {
+        perror("Error opening batch manifest");
+        return false;
+    }
+
+    char line[BATCH_MAX_PATH];
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), fp))
+    {
+        /* Strip comments and surrounding whitespace */
+        char *hash = strchr(line, '#');
+        if (hash)
+        {
+            *hash = '\0';
+        }
+
+        char *start = line;
+        while (*start == ' ' || *start == '\t')
+        {
+            start++;
+        }
+
+        size_t len = strlen(start);
+        while (len > 0 && (start[len - 1] == '\n' || start[len - 1] == '\r' || start[len - 1] == ' ' || start[len - 1] == '\t'))
+        {
+            start[--len] = '\0';
+        }
+
+        if (len > 0)
+        {
+            ok = append_path(paths, count, capacity, start);
+        }
+    }
+    fclose(fp);
+    return ok;
+}
+
+bool list_batch_files(const char *dirpath, const char *manifest, char ***paths, int *count)
+{
+    int capacity = 0;
+    *paths = NULL;
+    *count = 0;
+
+    bool ok = dirpath ? list_directory(dirpath, paths, count, &capacity)
+                      : list_manifest(manifest, paths, count, &capacity);
+    if (!ok)
+    {
+        free_batch_files(*paths, *count);
+        *paths = NULL;
+        *count = 0;
+    }
+    return ok;
+}
+
+void free_batch_files(char **paths, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        free(paths[i]);
+    }
+    free(paths);
+}
+
+bool write_batch_inverse(const char *out_dir, const char *filepath, int nrow, int ncol, double mat_inv[nrow][ncol])
+{
+    const char *fname = strrchr(filepath, '/');
+    fname = fname ? fname + 1 : filepath;
+
+    /* matrix_5x5_01.txt -> <out_dir>/matrix_5x5_01_inverse.txt */
+    const char *ext = strrchr(fname, '.');
+    int stem_len = ext ? (int)(ext - fname) : (int)strlen(fname);
+
+    char path[BATCH_MAX_PATH];
+    snprintf(path, sizeof(path), "%s/%.*s_inverse.txt", out_dir, stem_len, fname);
+    if (!write_matrix_to_file(path, nrow, ncol, mat_inv))
+    {
+        fprintf(stderr, "Failed to write inverse to %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void free_batch_job(struct batch_job *job)
+{
+    if (job->mat)
+    {
+        free_matrix(job->mat, job->nrow);
+    }
+    free(job->mat_inv);
+    free(job->cores);
+    free(job);
+}
+
+/* Prefetch stage: read and parse the matrices in order */
+static void *prefetch_worker(void *arg)
+{
+    struct batch_stage *stage = (struct batch_stage *)arg;
+
+    for (int i = 0; i < stage->count; i++)
+    {
+        struct batch_job *job = (struct batch_job *)calloc(1, sizeof(struct batch_job));
+        if (!job)
+        {
+            perror("calloc (batch job)");
+            stage->failures++;
+            continue;
+        }
+
+        job->filepath = stage->paths[i];
+        if (!read_matrix_from_file(job->filepath, &job->nrow, &job->ncol, &job->mat))
+        {
+            fprintf(stderr, "Failed to read matrix from file %s\n", job->filepath);
+            job->mat = NULL;
+            free_batch_job(job);
+            stage->failures++;
+            continue;
+        }
+
+        job->mat_inv = (double *)malloc((size_t)job->nrow * job->ncol * sizeof(double));
+        if (!job->mat_inv)
+        {
+            perror("malloc (batch inverse)");
+            free_batch_job(job);
+            stage->failures++;
+            continue;
+        }
+
+        if (!bq_push(stage->out, job))
+        {
+            free_batch_job(job);
+            break;
+        }
+    }
+
+    bq_close(stage->out);
+    return NULL;
+}
+
+/* Write-back stage: store the inverses next to each other in out_dir */
+static void *writeback_worker(void *arg)
+{
+    struct batch_stage *stage = (struct batch_stage *)arg;
+    void *item;
+
+    while (bq_pop(stage->in, &item))
+    {
+        struct batch_job *job = (struct batch_job *)item;
+
+        if (job->ok && stage->out_dir)
+        {
+            double (*mat_inv)[job->ncol] = (double (*)[job->ncol])job->mat_inv;
+            if (!write_batch_inverse(stage->out_dir, job->filepath, job->nrow, job->ncol, mat_inv))
+            {
+                stage->failures++;
+            }
+        }
+
+        free_batch_job(job);
+    }
+    return NULL;
+}
+
+/* Lane of the concurrent compute stage: invert the jobs dispatched to it with their team */
+static void *lane_worker(void *arg)
+{
+    struct batch_lane *lane = (struct batch_lane *)arg;
+    struct batch_scheduler *sched = lane->sched;
+    void *item;
+
+    while (bq_pop(&sched->assigned, &item))
+    {
+        struct batch_job *job = (struct batch_job *)item;
+        job->lane = lane->index;
+
+        /* The team size is an ICV of this thread, so every lane forks its own team */
+        omp_set_num_threads(job->threads);
+        job->ok = sched->invert(job, sched->arg);
+        if (!job->ok)
+        {
+            fprintf(stderr, "Failed to process file: %s\n", job->filepath);
+        }
+        free_matrix(job->mat, job->nrow);
+        job->mat = NULL;
+
+        pthread_mutex_lock(&sched->lock);
+        for (int t = 0; t < job->threads; t++)
+        {
+            sched->busy[job->cores[t]] = false;
+        }
+        sched->free_cores += job->threads;
+        sched->failures += !job->ok;
+        pthread_cond_signal(&sched->released);
+        pthread_mutex_unlock(&sched->lock);
+
+        bq_push(sched->inverted, job);
+    }
+    return NULL;
+}
+
+/* Concurrent compute stage: hand the jobs in order to lanes, each with a team of free cores. Returns the
+ * number of failed jobs, or -1 if the scheduler could not start, with the jobs left in loaded. */
+static int run_concurrent_compute(struct bounded_queue *loaded, struct bounded_queue *inverted, const struct batch_config *cfg,
+                                  batch_invert_fn invert, void *arg)
+{
+    int cores = cfg->cores;
+    struct batch_scheduler sched = {.free_cores = cores, .inverted = inverted, .invert = invert, .arg = arg};
+    /* At most one job per core is in flight, so a lane is always idle when cores are */
+    pthread_t *threads = malloc(cores * sizeof(pthread_t));
+    struct batch_lane *lanes = malloc(cores * sizeof(struct batch_lane));
+    sched.busy = calloc(cores, sizeof(bool));
+    if (!threads || !lanes || !sched.busy || !bq_init(&sched.assigned, cores))
+    {
+        perror("malloc (batch scheduler)");
+        free(threads);
+        free(lanes);
+        free(sched.busy);
+        return -1;
+    }
+    pthread_mutex_init(&sched.lock, NULL);
+    pthread_cond_init(&sched.released, NULL);
+
+    int started = 0;
+    for (; started < cores; started++)
+    {
+        lanes[started] = (struct batch_lane){&sched, started};
+        if (pthread_create(&threads[started], NULL, lane_worker, &lanes[started]) != 0)
+        {
+            perror("pthread_create (batch lane)");
+            break;
+        }
+    }
+
+    int failures = 0;
+    void *item;
+    while (started == cores && bq_pop(loaded, &item))
+    {
+        struct batch_job *job = (struct batch_job *)item;
+        job->cores = malloc(cores * sizeof(int));
+        if (!job->cores)
+        {
+            perror("malloc (batch team)");
+            failures++;
+            free_matrix(job->mat, job->nrow);
+            job->mat = NULL;
+            bq_push(inverted, job);
+            continue;
+        }
+
+        /* The team is sized for the cores free now rather than waiting for more */
+        int queued = 1 + bq_length(loaded);
+        pthread_mutex_lock(&sched.lock);
+        while (sched.free_cores == 0)
+        {
+            pthread_cond_wait(&sched.released, &sched.lock);
+        }
+        int want = cfg->team_size(job->nrow, sched.free_cores, queued, cfg->team_arg);
+        job->threads = want < 1 ? 1 : want > sched.free_cores ? sched.free_cores : want;
+        for (int c = 0, t = 0; t < job->threads; c++)
+        {
+            if (!sched.busy[c])
+            {
+                sched.busy[c] = true;
+                job->cores[t++] = c;
+            }
+        }
+        sched.free_cores -= job->threads;
+        pthread_mutex_unlock(&sched.lock);
+
+        bq_push(&sched.assigned, job);
+    }
+
+    bq_close(&sched.assigned);
+    for (int l = 0; l < started; l++)
+    {
+        pthread_join(threads[l], NULL);
+    }
+    failures += sched.failures;
+    if (started < cores)
+    {
+        /* Nothing was dispatched, the caller fails the queued jobs */
+        failures = -1;
+    }
+
+    pthread_cond_destroy(&sched.released);
+    pthread_mutex_destroy(&sched.lock);
+    bq_destroy(&sched.assigned);
+    free(sched.busy);
+    free(lanes);
+    free(threads);
+    return failures;
+}
+
+int run_batch_pipeline(char **paths, int count, const struct batch_config *cfg, batch_invert_fn invert, void *arg)
+{
+    struct bounded_queue loaded, inverted;
+    if (!bq_init(&loaded, cfg->prefetch_depth))
+    {
+        return count;
+    }
+    if (!bq_init(&inverted, cfg->writeback_depth))
+    {
+        bq_destroy(&loaded);
+        return count;
+    }
+
+    if (cfg->out_dir)
+    {
+        mkdir(cfg->out_dir, 0777); /* Create the folder if it doesn't exist */
+    }
+
+    struct batch_stage reader = {paths, count, NULL, NULL, &loaded, 0};
+    struct batch_stage writer = {NULL, 0, cfg->out_dir, &inverted, NULL, 0};
+    pthread_t reader_thread, writer_thread;
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+
+    if (pthread_create(&reader_thread, NULL, prefetch_worker, &reader) != 0)
+    {
+        perror("pthread_create (batch reader)");
+        bq_destroy(&inverted);
+        bq_destroy(&loaded);
+        return count;
+    }
+    if (pthread_create(&writer_thread, NULL, writeback_worker, &writer) != 0)
+    {
+        /* Stop the reader at its next push and throw away what it already queued */
+        perror("pthread_create (batch writer)");
+        bq_close(&loaded);
+        pthread_join(reader_thread, NULL);
+        void *item;
+        while (bq_pop(&loaded, &item))
+        {
+            free_batch_job((struct batch_job *)item);
+        }
+        bq_destroy(&inverted);
+        bq_destroy(&loaded);
+        return count;
+    }
+
+    /* Compute stage runs on the calling thread so it keeps the OpenMP thread pool */
+    int failures = 0;
+    void *item;
+    if (cfg->cores > 1 && cfg->team_size)
+    {
+        failures = run_concurrent_compute(&loaded, &inverted, cfg, invert, arg);
+        if (failures < 0)
+        {
+            /* No scheduler, drain the reader so it can finish */
+            failures = 0;
+            while (bq_pop(&loaded, &item))
+            {
+                free_batch_job((struct batch_job *)item);
+                failures++;
+            }
+        }
+    }
+    while (bq_pop(&loaded, &item))
+    {
+        struct batch_job *job = (struct batch_job *)item;
+        job->ok = invert(job, arg);
+        if (!job->ok)
+        {
+            fprintf(stderr, "Failed to process file: %s\n", job->filepath);
+            failures++;
+        }
+
+        /* The input is no longer needed, release it before queueing the result */
+        free_matrix(job->mat, job->nrow);
+        job->mat = NULL;
+
+        bq_push(&inverted, job);
+    }
+    bq_close(&inverted);
+
+    pthread_join(reader_thread, NULL);
+    pthread_join(writer_thread, NULL);
+
+    gettimeofday(&end, NULL);
+    double elapsed_time = (end.tv_sec - start.tv_sec) * 1000.0;
+    elapsed_time += (end.tv_usec - start.tv_usec) / 1000.0;
+
+    failures += reader.failures + writer.failures;
+    printf("Batch completed in %.3f ms: %d files, %d failed.\n", elapsed_time, count, failures);
+
+    bq_destroy(&inverted);
+    bq_destroy(&loaded);
+    return failures;
+}
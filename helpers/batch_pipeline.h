@@ -0,0 +1,76 @@
+#ifndef BATCH_PIPELINE_H
+#define BATCH_PIPELINE_H
+
+#include <stdbool.h> /* bool */
+
+/* One matrix travelling through the batch pipeline.
+ *
+ * The prefetch stage fills filepath, nrow, ncol and mat, and allocates
+ * mat_inv. The compute stage fills mat_inv and sets ok. The write-back
+ * stage stores mat_inv (if an output directory is set) and frees the job.
+ * In concurrent mode the scheduler also assigns the lane and the cores the
+ * job runs on.
+ */
+struct batch_job
+{
+    const char *filepath;
+    int nrow;
+    int ncol;
+    double **mat;    /* Input matrix as returned by read_matrix_from_file */
+    double *mat_inv; /* nrow x ncol row-major inverse */
+    bool ok;
+    int lane;        /* Concurrent mode: index of the lane thread running the job */
+    int threads;     /* Concurrent mode: OpenMP team size, already set on the lane thread */
+    int *cores;      /* Concurrent mode: the team's cores, indices into the CPUs of the process */
+};
+
+/* Compute stage callback, returns true if job->mat_inv holds the inverse */
+typedef bool (*batch_invert_fn)(struct batch_job *job, void *arg);
+
+/* Concurrent mode: threads for the next n x n matrix, free_cores (at least 1) being free and queued
+ * matrices (at least 1, this one included) waiting for them. Called by the scheduler with its lock
+ * held, so it must not block. */
+typedef int (*batch_team_fn)(int n, int free_cores, int queued, void *arg);
+
+struct batch_config
+{
+    int prefetch_depth;      /* Matrices read ahead of the one being inverted */
+    int writeback_depth;     /* Inverses waiting to be written before compute blocks */
+    const char *out_dir;     /* Where to write the inverses, NULL to discard them */
+    int cores;               /* Concurrent mode: cores shared by the inversions, below 2 for one inversion at a time */
+    batch_team_fn team_size; /* Concurrent mode: team size of each matrix */
+    void *team_arg;
+};
+
+/* Collects the matrix files of a batch.
+ *
+ * dirpath: Directory whose regular files are all taken, sorted by name.
+ * manifest: Text file with one matrix path per line, '#' starts a comment.
+ *
+ * Exactly one of dirpath and manifest should be non-NULL.
+ * Returns true on success, the list must be released with free_batch_files.
+ */
+bool list_batch_files(const char *dirpath, const char *manifest, char ***paths, int *count);
+void free_batch_files(char **paths, int count);
+
+/* Writes the inverse of the matrix in filepath where a batch puts it: matrix_5x5_01.txt becomes
+ * <out_dir>/matrix_5x5_01_inverse.txt. Returns false (after printing why) on failure. */
+bool write_batch_inverse(const char *out_dir, const char *filepath, int nrow, int ncol, double mat_inv[nrow][ncol]);
+
+/* Runs the read -> invert -> write pipeline over the given files.
+ *
+ * Reading and writing happen on their own threads, connected to the
+ * compute stage (the calling thread) by bounded queues of the configured
+ * depths. Returns the number of files that failed.
+ *
+ * Concurrent mode (cores of 2 or more and a team_size callback) runs
+ * several inversions at once instead, each on its own subset of the cores.
+ * Per-pivot synchronization grows with the team, so mid-size matrices get
+ * more done per core in small teams side by side than one after the other
+ * with every thread. The calling thread hands each matrix, in order, to a
+ * lane thread as soon as a core is free, with the team that team_size picks
+ * for the cores free at that moment and the matrices read ahead so far.
+ */
+int run_batch_pipeline(char **paths, int count, const struct batch_config *cfg, batch_invert_fn invert, void *arg);
+
+#endif /* BATCH_PIPELINE_H */
@@ -0,0 +1,388 @@
+/*
+ * @file bigint.c
+ * @brief Fixed-capacity signed big integers for the CRT reconstruction
+ */
+
+#include "bigint.h"
+
+#include <math.h>   /* ldexp, frexp */
+#include <string.h> /* memcpy */
+
+/* 64 x 64 -> 128 bit products, a GCC and Clang extension */
+__extension__ typedef unsigned __int128 uint128_t;
+
+/* Drop leading zero limbs, zero has no sign */
+static void normalize(struct bigint *x)
+{
+    while (x->len > 0 && x->limb[x->len - 1] == 0)
+    {
+        x->len--;
+    }
+    if (x->len == 0)
+    {
+        x->neg = false;
+    }
+}
+
+void bigint_init(struct bigint *x, uint64_t *limbs, int cap)
+{
+    x->limb = limbs;
+    x->cap = cap;
+    x->len = 0;
+    x->neg = false;
+}
+
+void bigint_set_u64(struct bigint *x, uint64_t v)
+{
+    x->limb[0] = v;
+    x->len = v != 0;
+    x->neg = false;
+}
+
+void bigint_copy(struct bigint *dst, const struct bigint *src)
+{
+    memcpy(dst->limb, src->limb, src->len * sizeof(uint64_t));
+    dst->len = src->len;
+    dst->neg = src->neg;
+}
+
+int bigint_bits(const struct bigint *x)
+{
+    return x->len == 0 ? 0 : 64 * x->len - __builtin_clzll(x->limb[x->len - 1]);
+}
+
+int bigint_cmp_abs(const struct bigint *x, const struct bigint *y)
+{
+    if (x->len != y->len)
+    {
+        return x->len < y->len ? -1 : 1;
+    }
+    for (int i = x->len - 1; i >= 0; i--)
+    {
+        if (x->limb[i] != y->limb[i])
+        {
+            return x->limb[i] < y->limb[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+uint64_t bigint_mod_u64(const struct bigint *x, uint64_t p)
+{
+    uint64_t r = 0;
+    for (int i = x->len - 1; i >= 0; i--)
+    {
+        r = (uint64_t)((((uint128_t)r << 64) | x->limb[i]) % p);
+    }
+    return x->neg && r != 0 ? p - r : r;
+}
+
+void bigint_mul_u64(struct bigint *x, uint64_t m)
+{
+    uint64_t carry = 0;
+    for (int i = 0; i < x->len; i++)
+    {
+        uint128_t prod = (uint128_t)x->limb[i] * m + carry;
+        x->limb[i] = (uint64_t)prod;
+        carry = (uint64_t)(prod >> 64);
+    }
+    if (carry)
+    {
+        x->limb[x->len++] = carry;
+    }
+    normalize(x);
+}
+
+uint64_t bigint_divmod_u64(struct bigint *x, uint64_t d)
+{
+    uint64_t r = 0;
+    for (int i = x->len - 1; i >= 0; i--)
+    {
+        uint128_t cur = ((uint128_t)r << 64) | x->limb[i];
+        x->limb[i] = (uint64_t)(cur / d);
+        r = (uint64_t)(cur % d);
+    }
+    normalize(x);
+    return r;
+}
+
+/* |x| += |y| */
+static void add_abs(struct bigint *x, const struct bigint *y)
+{
+    int len = x->len > y->len ? x->len : y->len;
+    uint64_t carry = 0;
+    for (int i = 0; i < len; i++)
+    {
+        uint64_t a = i < x->len ? x->limb[i] : 0;
+        uint64_t b = i < y->len ? y->limb[i] : 0;
+        uint64_t sum = a + b;
+        uint64_t c1 = sum < a;
+        x->limb[i] = sum + carry;
+        carry = c1 | (x->limb[i] < sum);
+    }
+    x->len = len;
+    if (carry)
+    {
+        x->limb[x->len++] = carry;
+    }
+}
+
+/* |x| = |a| - |b| for |a| >= |b|, x may be a or b */
+static void sub_abs(struct bigint *x, const struct bigint *a, const struct bigint *b)
+{
+    uint64_t borrow = 0;
+    int len = a->len;
+    for (int i = 0; i < len; i++)
+    {
+        uint64_t u = a->limb[i];
+        uint64_t v = i < b->len ? b->limb[i] : 0;
+        uint64_t diff = u - v;
+        uint64_t b1 = u < v;
+        x->limb[i] = diff - borrow;
+        borrow = b1 | (diff < borrow);
+    }
+    x->len = len;
+    normalize(x);
+}
+
+void bigint_addmul_i64(struct bigint *x, const struct bigint *m, int64_t t, struct bigint *scratch)
+{
+    if (t == 0 || bigint_is_zero(m))
+    {
+        return;
+    }
+    bigint_copy(scratch, m);
+    bigint_mul_u64(scratch, t < 0 ? -(uint64_t)t : (uint64_t)t);
+    scratch->neg = m->neg != (t < 0);
+
+    bool neg = bigint_is_zero(x) ? scratch->neg : x->neg;
+    if (neg == scratch->neg)
+    {
+        add_abs(x, scratch);
+    }
+    else if (bigint_cmp_abs(x, scratch) >= 0)
+    {
+        sub_abs(x, x, scratch);
+    }
+    else
+    {
+        sub_abs(x, scratch, x);
+        neg = scratch->neg;
+    }
+    x->neg = neg;
+    normalize(x);
+}
+
+/* Index of the lowest set bit of a nonzero x */
+static int trailing_zeros(const struct bigint *x)
+{
+    int i = 0;
+    while (x->limb[i] == 0)
+    {
+        i++;
+    }
+    return 64 * i + __builtin_ctzll(x->limb[i]);
+}
+
+static void shift_right(struct bigint *x, int k)
+{
+    int words = k / 64, bits = k % 64;
+    if (words >= x->len)
+    {
+        x->len = 0;
+        normalize(x);
+        return;
+    }
+    int len = x->len - words;
+    for (int i = 0; i < len; i++)
+    {
+        uint64_t lo = x->limb[i + words];
+        uint64_t hi = i + words + 1 < x->len ? x->limb[i + words + 1] : 0;
+        x->limb[i] = bits ? lo >> bits | hi << (64 - bits) : lo;
+    }
+    x->len = len;
+    normalize(x);
+}
+
+static void shift_left(struct bigint *x, int k)
+{
+    int words = k / 64, bits = k % 64;
+    if (x->len == 0 || k == 0)
+    {
+        return;
+    }
+    int len = x->len + words + 1;
+    for (int i = len - 1; i >= words; i--)
+    {
+        int src = i - words;
+        uint64_t hi = src < x->len ? x->limb[src] : 0;
+        uint64_t lo = src >= 1 && src - 1 < x->len ? x->limb[src - 1] : 0;
+        x->limb[i] = bits ? hi << bits | lo >> (64 - bits) : hi;
+    }
+    for (int i = 0; i < words; i++)
+    {
+        x->limb[i] = 0;
+    }
+    x->len = len;
+    normalize(x);
+}
+
+/* Binary GCD on the magnitudes, switching to machine words once either fits in one */
+void bigint_gcd(struct bigint *g, const struct bigint *x, struct bigint *scratch)
+{
+    g->neg = false;
+    if (bigint_is_zero(x))
+    {
+        return;
+    }
+    if (bigint_is_zero(g))
+    {
+        bigint_copy(g, x);
+        g->neg = false;
+        return;
+    }
+
+    struct bigint *s = scratch;
+    bigint_copy(s, x);
+    s->neg = false;
+    int tg = trailing_zeros(g), ts = trailing_zeros(s);
+    int common = tg < ts ? tg : ts;
+    shift_right(g, tg);
+    shift_right(s, ts);
+
+    /* Both odd from here on */
+    for (;;)
+    {
+        if (g->len == 1 || s->len == 1)
+        {
+            uint64_t a = g->len == 1 ? g->limb[0] : s->limb[0];
+            uint64_t b = bigint_mod_u64(g->len == 1 ? s : g, a);
+            while (b != 0)
+            {
+                uint64_t r = a % b;
+                a = b;
+                b = r;
+            }
+            bigint_set_u64(g, a);
+            break;
+        }
+
+        int c = bigint_cmp_abs(g, s);
+        if (c == 0)
+        {
+            break;
+        }
+        struct bigint *big = c > 0 ? g : s;
+        sub_abs(big, big, c > 0 ? s : g);
+        shift_right(big, trailing_zeros(big));
+    }
+    shift_left(g, common);
+}
+
+/* Exact division from the low limbs up (Jebelean): with d odd, each quotient limb is the lowest
+ * remaining limb times d^-1 mod 2^64, and subtracting it times d clears that limb */
+void bigint_divexact(struct bigint *x, const struct bigint *d, struct bigint *scratch)
+{
+    bool neg = x->neg != d->neg;
+    struct bigint *s = scratch;
+    bigint_copy(s, d);
+    s->neg = false;
+    int twos = trailing_zeros(s);
+    shift_right(s, twos);
+    shift_right(x, twos);
+
+    if (s->len == 1)
+    {
+        bigint_divmod_u64(x, s->limb[0]);
+    }
+    else if (x->len >= s->len)
+    {
+        uint64_t inv = s->limb[0];
+        for (int k = 0; k < 5; k++)
+        {
+            inv *= 2 - s->limb[0] * inv;
+        }
+
+        int qlen = x->len - s->len + 1;
+        for (int i = 0; i < qlen; i++)
+        {
+            uint64_t q = x->limb[i] * inv;
+            uint64_t carry = 0, borrow = 0;
+            for (int j = i; j < x->len; j++)
+            {
+                uint64_t sub = carry;
+                if (j - i < s->len)
+                {
+                    uint128_t prod = (uint128_t)q * s->limb[j - i] + carry;
+                    sub = (uint64_t)prod;
+                    carry = (uint64_t)(prod >> 64);
+                }
+                else
+                {
+                    carry = 0;
+                }
+                uint64_t v = x->limb[j];
+                uint64_t diff = v - sub;
+                uint64_t b1 = v < sub;
+                x->limb[j] = diff - borrow;
+                borrow = b1 | (diff < borrow);
+                if (j - i >= s->len && carry == 0 && borrow == 0)
+                {
+                    break;
+                }
+            }
+            x->limb[i] = q;
+        }
+        x->len = qlen;
+    }
+    else
+    {
+        x->len = 0;
+    }
+    x->neg = neg;
+    normalize(x);
+}
+
+double bigint_frexp(const struct bigint *x, int *exp)
+{
+    if (x->len == 0)
+    {
+        *exp = 0;
+        return 0.0;
+    }
+    int low = x->len >= 2 ? x->len - 2 : 0;
+    double m = 0.0;
+    for (int i = x->len - 1; i >= low; i--)
+    {
+        m = ldexp(m, 64) + (double)x->limb[i];
+    }
+    int e;
+    m = frexp(m, &e);
+    *exp = e + 64 * low;
+    return x->neg ? -m : m;
+}
+
+void bigint_fprint(FILE *fp, const struct bigint *x, struct bigint *scratch)
+{
+    if (x->len == 0)
+    {
+        fputs("0", fp);
+        return;
+    }
+
+    /* Groups of 19 digits, least significant first */
+    const uint64_t group = 10000000000000000000ULL;
+    uint64_t digits[2 * x->len + 1];
+    int count = 0;
+    bigint_copy(scratch, x);
+    while (!bigint_is_zero(scratch))
+    {
+        digits[count++] = bigint_divmod_u64(scratch, group);
+    }
+
+    fprintf(fp, "%s%llu", x->neg ? "-" : "", (unsigned long long)digits[count - 1]);
+    for (int i = count - 2; i >= 0; i--)
+    {
+        fprintf(fp, "%019llu", (unsigned long long)digits[i]);
+    }
+}
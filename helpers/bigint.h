@@ -0,0 +1,66 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <stdbool.h> /* bool */
+#include <stdint.h>  /* uint64_t, int64_t */
+#include <stdio.h>   /* FILE */
+
+/* Signed integers of a few thousand bits, for the exact inversion.
+ *
+ * The magnitude is stored as len little-endian 64-bit limbs in a buffer
+ * of cap limbs owned by the caller, so a whole matrix of them can share
+ * one allocation. Nothing here allocates: results must fit in the cap of
+ * their destination, and the operations that need room for intermediate
+ * values take a scratch bigint of at least the same cap. Only the
+ * operations the CRT reconstruction needs are provided.
+ */
+struct bigint
+{
+    uint64_t *limb;
+    int len; /* Limbs in use, 0 for zero, limb[len - 1] != 0 */
+    int cap;
+    bool neg;
+};
+
+/* x = 0 on the cap limbs at limbs */
+void bigint_init(struct bigint *x, uint64_t *limbs, int cap);
+
+void bigint_set_u64(struct bigint *x, uint64_t v);
+void bigint_copy(struct bigint *dst, const struct bigint *src);
+
+static inline bool bigint_is_zero(const struct bigint *x)
+{
+    return x->len == 0;
+}
+
+/* Bits of |x|, 0 for zero */
+int bigint_bits(const struct bigint *x);
+
+/* Compare |x| with |y| */
+int bigint_cmp_abs(const struct bigint *x, const struct bigint *y);
+
+/* x mod p in [0, p), with the sign of x taken into account */
+uint64_t bigint_mod_u64(const struct bigint *x, uint64_t p);
+
+/* x *= m */
+void bigint_mul_u64(struct bigint *x, uint64_t m);
+
+/* |x| /= d, returns the remainder of |x| */
+uint64_t bigint_divmod_u64(struct bigint *x, uint64_t d);
+
+/* x += m·t */
+void bigint_addmul_i64(struct bigint *x, const struct bigint *m, int64_t t, struct bigint *scratch);
+
+/* g = gcd(|g|, |x|) */
+void bigint_gcd(struct bigint *g, const struct bigint *x, struct bigint *scratch);
+
+/* x /= d for a d that divides x exactly, d != 0 */
+void bigint_divexact(struct bigint *x, const struct bigint *d, struct bigint *scratch);
+
+/* x as mantissa·2^exp with the mantissa in [0.5, 1), like frexp, for magnitudes beyond the double range */
+double bigint_frexp(const struct bigint *x, int *exp);
+
+/* Print x in decimal */
+void bigint_fprint(FILE *fp, const struct bigint *x, struct bigint *scratch);
+
+#endif /* BIGINT_H */
@@ -0,0 +1,103 @@
+#include "bounded_queue.h"
+#include <stdio.h>   /* perror */
+#include <stdlib.h>  /* malloc, free */
+
+bool bq_init(struct bounded_queue *q, int capacity)
+{
+    if (capacity < 1)
+    {
+        capacity = 1;
+    }
+
+    q->items = (void **)malloc(capacity * sizeof(void *));
+    if (!q->items)
+    {
+        perror("malloc (queue)");
+        return false;
+    }
+
+    q->capacity = capacity;
+    q->head = 0;
+    q->count = 0;
+    q->closed = false;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->not_empty, NULL);
+    pthread_cond_init(&q->not_full, NULL);
+    return true;
+}
+
+void bq_destroy(struct bounded_queue *q)
+{
+    pthread_cond_destroy(&q->not_full);
+    pthread_cond_destroy(&q->not_empty);
+    pthread_mutex_destroy(&q->lock);
+    free(q->items);
+    q->items = NULL;
+}
+
+/* Append an item, the caller must hold the lock and have checked for space */
+static void bq_append_locked(struct bounded_queue *q, void *item)
+{
+    q->items[(q->head + q->count) % q->capacity] = item;
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+}
+
+bool bq_push(struct bounded_queue *q, void *item)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->capacity && !q->closed)
+    {
+        pthread_cond_wait(&q->not_full, &q->lock);
+    }
+
+    if (q->closed)
+    {
+        pthread_mutex_unlock(&q->lock);
+        return false;
+    }
+
+    bq_append_locked(q, item);
+    pthread_mutex_unlock(&q->lock);
+    return true;
+}
+
+bool bq_pop(struct bounded_queue *q, void **item)
+{
+    pthread_mutex_lock(&q->lock);
+    while (q->count == 0 && !q->closed)
+    {
+        pthread_cond_wait(&q->not_empty, &q->lock);
+    }
+
+    if (q->count == 0)
+    {
+        /* Closed and drained */
+        pthread_mutex_unlock(&q->lock);
+        return false;
+    }
+
+    *item = q->items[q->head];
+    q->head = (q->head + 1) % q->capacity;
+    q->count--;
+    pthread_cond_signal(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return true;
+}
+
+void bq_close(struct bounded_queue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->closed = true;
+    pthread_cond_broadcast(&q->not_empty);
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+}
+
+int bq_length(struct bounded_queue *q)
+{
+    pthread_mutex_lock(&q->lock);
+    int count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
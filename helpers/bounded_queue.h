@@ -0,0 +1,40 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <stdbool.h>  /* bool */
+#include <pthread.h>  /* pthread_mutex_t, pthread_cond_t */
+
+/* Fixed-capacity FIFO of pointers shared between threads.
+ *
+ * bq_push blocks while the queue is full and bq_pop blocks while it is empty,
+ * so the capacity bounds how far a producer can run ahead of its consumer.
+ * Once the queue is closed, bq_pop drains the remaining items and then
+ * returns false.
+ */
+struct bounded_queue
+{
+    void **items;
+    int capacity;
+    int head;
+    int count;
+    bool closed;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+};
+
+bool bq_init(struct bounded_queue *q, int capacity);
+void bq_destroy(struct bounded_queue *q);
+
+/* Returns false if the queue was closed before the item could be added. */
+bool bq_push(struct bounded_queue *q, void *item);
+
+/* Returns false once the queue is closed and empty. */
+bool bq_pop(struct bounded_queue *q, void **item);
+
+void bq_close(struct bounded_queue *q);
+
+/* Number of items queued right now, a snapshot that producers and consumers may change at once. */
+int bq_length(struct bounded_queue *q);
+
+#endif /* BOUNDED_QUEUE_H */
@@ -0,0 +1,328 @@
+#include "cli_options.h"
+#include <stdio.h>  /* printf, fprintf */
+#include <stdlib.h> /* atoi, strtod */
+#include <string.h> /* strncmp, strcmp, strlen */
+
+#define DEFAULT_PREFETCH_DEPTH 2
+#define DEFAULT_WRITEBACK_DEPTH 2
+
+void init_cli_options(struct cli_options *opts)
+{
+    opts->filepath = NULL;
+    opts->dirpath = NULL;
+    opts->manifest = NULL;
+    opts->generate = false;
+    opts->out_dir = NULL;
+    opts->prefetch_depth = DEFAULT_PREFETCH_DEPTH;
+    opts->writeback_depth = DEFAULT_WRITEBACK_DEPTH;
+    opts->concurrent_cores = 0;
+    opts->team_ranks = 0;
+    opts->profile = false;
+    opts->profile_counters = false;
+    opts->mpi_profile = false;
+    opts->mpi_profile_sync = false;
+    opts->trace_path = NULL;
+    opts->verify = VERIFY_NONE;
+    opts->cond_limit = 0.0;
+    opts->pin = false;
+    opts->huge_pages = HUGE_PAGES_THP;
+    opts->precision = SCALAR_DOUBLE;
+    opts->ooc_memory_mb = 0.0;
+    opts->ooc_dir = NULL;
+    opts->ooc_out = NULL;
+    opts->stream = false;
+    opts->exact = false;
+    opts->exact_out = NULL;
+    opts->blocks = false;
+    opts->structure = NULL;
+    opts->diagonal = false;
+    opts->diagonal_out = NULL;
+    opts->tuning_path = NULL;
+}
+
+void print_usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s -path=<file_path>|-generate=<N>,<seed>,<uniform|dominant|spd[=cond]|cond[=cond]|blocks[=size]|band[=width]|toeplitz|circulant>\n", prog);
+    fprintf(stderr, "       %s -dir=<directory>|-manifest=<file> [-out=<directory>] [-prefetch=<depth>] [-writeback=<depth>]\n", prog);
+    fprintf(stderr, "       %*s [-concurrent[=<cores>]] [-team=<ranks>]\n", (int)strlen(prog), "");
+    fprintf(stderr, "Options: -profile[=counters] -mpi-profile[=sync] -trace=<file> -verify[=sampled|full] -cond-limit=<value>\n");
+    fprintf(stderr, "         -pin -hugepages=off|thp|explicit -precision=double|float|complex -tuning=<file>\n");
+    fprintf(stderr, "         -ooc=<MB> [-ooc-dir=<directory>] [-ooc-out=<file.bin>] -stream -exact [-exact-out=<file>] -blocks\n");
+    fprintf(stderr, "         -structure=auto|general|toeplitz|circulant -diagonal [-diagonal-out=<file>]\n");
+}
+
+/* Returns the value of argument arg if it starts with name, NULL otherwise */
+static const char *option_value(const char *arg, const char *name)
+{
+    size_t len = strlen(name);
+    return strncmp(arg, name, len) == 0 ? arg + len : NULL;
+}
+
+bool parse_cli_options(int argc, char *argv[], struct cli_options *opts)
+{
+    const char *value;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if ((value = option_value(argv[i], "-path=")))
+        {
+            opts->filepath = value;
+        }
+        else if ((value = option_value(argv[i], "-dir=")))
+        {
+            opts->dirpath = value;
+        }
+        else if ((value = option_value(argv[i], "-manifest=")))
+        {
+            opts->manifest = value;
+        }
+        else if ((value = option_value(argv[i], "-generate=")))
+        {
+            if (!parse_matrix_spec(value, &opts->generate_spec))
+            {
+                fprintf(stderr, "Error: invalid matrix specification %s, use -generate=N,seed,kind.\n", value);
+                return false;
+            }
+            opts->generate = true;
+        }
+        else if ((value = option_value(argv[i], "-out=")))
+        {
+            opts->out_dir = value;
+        }
+        else if ((value = option_value(argv[i], "-prefetch=")))
+        {
+            opts->prefetch_depth = atoi(value);
+        }
+        else if ((value = option_value(argv[i], "-writeback=")))
+        {
+            opts->writeback_depth = atoi(value);
+        }
+        else if (strcmp(argv[i], "-profile") == 0 || strcmp(argv[i], "-profile=counters") == 0)
+        {
+            opts->profile = true;
+            opts->profile_counters = strcmp(argv[i], "-profile=counters") == 0;
+        }
+        else if (strcmp(argv[i], "-mpi-profile") == 0 || strcmp(argv[i], "-mpi-profile=sync") == 0)
+        {
+            opts->mpi_profile = true;
+            opts->mpi_profile_sync = strcmp(argv[i], "-mpi-profile=sync") == 0;
+        }
+        else if ((value = option_value(argv[i], "-trace=")))
+        {
+            opts->trace_path = value;
+        }
+        else if (strcmp(argv[i], "-verify") == 0)
+        {
+            opts->verify = VERIFY_SAMPLED;
+        }
+        else if ((value = option_value(argv[i], "-verify=")))
+        {
+            if (!parse_verify_mode(value, &opts->verify))
+            {
+                fprintf(stderr, "Error: unknown verification mode %s, use sampled or full.\n", value);
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-concurrent") == 0)
+        {
+            opts->concurrent_cores = -1;
+        }
+        else if ((value = option_value(argv[i], "-concurrent=")))
+        {
+            opts->concurrent_cores = atoi(value);
+            if (opts->concurrent_cores < 1)
+            {
+                fprintf(stderr, "Error: -concurrent needs a positive number of cores.\n");
+                return false;
+            }
+        }
+        else if ((value = option_value(argv[i], "-team=")))
+        {
+            opts->team_ranks = atoi(value);
+            if (opts->team_ranks < 1)
+            {
+                fprintf(stderr, "Error: -team needs a positive number of ranks.\n");
+                return false;
+            }
+        }
+        else if ((value = option_value(argv[i], "-cond-limit=")))
+        {
+            opts->cond_limit = strtod(value, NULL);
+        }
+        else if (strcmp(argv[i], "-pin") == 0)
+        {
+            opts->pin = true;
+        }
+        else if ((value = option_value(argv[i], "-hugepages=")))
+        {
+            if (!parse_huge_page_mode(value, &opts->huge_pages))
+            {
+                fprintf(stderr, "Error: unknown huge page mode %s, use off, thp or explicit.\n", value);
+                return false;
+            }
+        }
+        else if ((value = option_value(argv[i], "-precision=")))
+        {
+            if (!parse_scalar_type(value, &opts->precision))
+            {
+                fprintf(stderr, "Error: unknown precision %s, use double, float or complex.\n", value);
+                return false;
+            }
+        }
+        else if ((value = option_value(argv[i], "-ooc=")))
+        {
+            opts->ooc_memory_mb = strtod(value, NULL);
+            if (opts->ooc_memory_mb <= 0.0)
+            {
+                fprintf(stderr, "Error: -ooc needs a positive memory limit in MB.\n");
+                return false;
+            }
+        }
+        else if ((value = option_value(argv[i], "-ooc-dir=")))
+        {
+            opts->ooc_dir = value;
+        }
+        else if ((value = option_value(argv[i], "-ooc-out=")))
+        {
+            opts->ooc_out = value;
+        }
+        else if (strcmp(argv[i], "-stream") == 0)
+        {
+            opts->stream = true;
+        }
+        else if (strcmp(argv[i], "-exact") == 0)
+        {
+            opts->exact = true;
+        }
+        else if ((value = option_value(argv[i], "-exact-out=")))
+        {
+            opts->exact = true;
+            opts->exact_out = value;
+        }
+        else if (strcmp(argv[i], "-blocks") == 0)
+        {
+            opts->blocks = true;
+        }
+        else if ((value = option_value(argv[i], "-structure=")))
+        {
+            opts->structure = value;
+        }
+        else if (strcmp(argv[i], "-diagonal") == 0)
+        {
+            opts->diagonal = true;
+        }
+        else if ((value = option_value(argv[i], "-diagonal-out=")))
+        {
+            opts->diagonal = true;
+            opts->diagonal_out = value;
+        }
+        else if ((value = option_value(argv[i], "-tuning=")))
+        {
+            opts->tuning_path = value;
+        }
+        else
+        {
+            fprintf(stderr, "Warning: ignoring unknown argument %s\n", argv[i]);
+        }
+    }
+
+    int sources = (opts->filepath != NULL) + (opts->dirpath != NULL) + (opts->manifest != NULL) + opts->generate;
+    if (sources == 0)
+    {
+        fprintf(stderr, "Error: File path not specified. Use -path=<file_path>, -dir=<directory>, -manifest=<file> or -generate=<spec>.\n");
+        return false;
+    }
+    if (sources > 1)
+    {
+        fprintf(stderr, "Error: -path, -dir, -manifest and -generate are mutually exclusive.\n");
+        return false;
+    }
+
+    if (opts->ooc_memory_mb > 0.0 && (opts->dirpath || opts->manifest))
+    {
+        fprintf(stderr, "Error: -ooc inverts a single matrix, use -path= or -generate=.\n");
+        return false;
+    }
+
+    if (opts->stream && (is_batch_mode(opts) || opts->ooc_memory_mb > 0.0))
+    {
+        fprintf(stderr, "Error: -stream inverts a single in-core matrix, use -path= or -generate=.\n");
+        return false;
+    }
+
+    if (opts->exact && (is_batch_mode(opts) || opts->ooc_memory_mb > 0.0 || opts->stream || opts->precision != SCALAR_DOUBLE))
+    {
+        fprintf(stderr, "Error: -exact inverts a single double matrix in memory, use -path= or -generate= alone.\n");
+        return false;
+    }
+
+    if (opts->blocks && (opts->ooc_memory_mb > 0.0 || opts->stream || opts->exact || opts->precision != SCALAR_DOUBLE))
+    {
+        fprintf(stderr, "Error: -blocks inverts double matrices in memory, it does not combine with -ooc, -stream, -exact or -precision.\n");
+        return false;
+    }
+
+    if (opts->blocks && opts->concurrent_cores != 0)
+    {
+        fprintf(stderr, "Error: -blocks already inverts the blocks of each matrix side by side, drop -concurrent.\n");
+        return false;
+    }
+
+    if (opts->structure && (opts->blocks || opts->ooc_memory_mb > 0.0 || opts->stream || opts->exact || opts->precision != SCALAR_DOUBLE))
+    {
+        fprintf(stderr, "Error: -structure inverts double matrices in memory, it does not combine with -blocks, -ooc, -stream, -exact or -precision.\n");
+        return false;
+    }
+
+    if (opts->structure && opts->concurrent_cores != 0)
+    {
+        fprintf(stderr, "Error: -structure spreads each inversion over all threads, drop -concurrent.\n");
+        return false;
+    }
+
+    if (opts->diagonal && (is_batch_mode(opts) || opts->ooc_memory_mb > 0.0 || opts->stream || opts->exact || opts->blocks ||
+                           opts->structure || opts->precision != SCALAR_DOUBLE))
+    {
+        fprintf(stderr, "Error: -diagonal inverts a single double matrix in memory, use -path= or -generate= alone.\n");
+        return false;
+    }
+
+    if (opts->stream && opts->precision != SCALAR_DOUBLE)
+    {
+        fprintf(stderr, "Error: -stream inverts double matrices only.\n");
+        return false;
+    }
+
+    if (opts->precision != SCALAR_DOUBLE && (is_batch_mode(opts) || opts->ooc_memory_mb > 0.0))
+    {
+        fprintf(stderr, "Error: -precision=%s inverts a single in-core matrix, use -path= or -generate=.\n",
+                scalar_type_name(opts->precision));
+        return false;
+    }
+
+    if (opts->cond_limit < 0.0)
+    {
+        fprintf(stderr, "Error: -cond-limit must be positive.\n");
+        return false;
+    }
+
+    if (opts->concurrent_cores != 0 && !is_batch_mode(opts))
+    {
+        fprintf(stderr, "Error: -concurrent schedules the matrices of a batch, use -dir= or -manifest=.\n");
+        return false;
+    }
+
+    if (opts->team_ranks != 0 && !is_batch_mode(opts))
+    {
+        fprintf(stderr, "Error: -team splits the ranks over the matrices of a batch, use -dir= or -manifest=.\n");
+        return false;
+    }
+
+    if (opts->prefetch_depth < 1 || opts->writeback_depth < 1)
+    {
+        fprintf(stderr, "Error: -prefetch and -writeback depths must be at least 1.\n");
+        return false;
+    }
+
+    return true;
+}
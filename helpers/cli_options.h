@@ -0,0 +1,116 @@
+#ifndef CLI_OPTIONS_H
+#define CLI_OPTIONS_H
+
+#include <stdbool.h> /* bool */
+
+#include "matrix_gen.h"
+#include "placement.h"
+#include "scalar.h"
+#include "verify.h"
+
+/* Command-line options shared by the driver programs.
+ *
+ * -path=<file>        Invert a single matrix file.
+ * -dir=<directory>    Invert every matrix file in a directory (batch mode).
+ * -manifest=<file>    Invert the files listed in a manifest (batch mode).
+ * -generate=N,seed,kind Invert a matrix generated in memory instead of read
+ *                     from disk, kind is uniform, dominant, spd[=cond] or
+ *                     cond[=cond] (see matrix_gen.h).
+ * -out=<directory>    Batch mode: write the inverses into this directory.
+ * -prefetch=<depth>   Batch mode: number of matrices read ahead of compute.
+ * -writeback=<depth>  Batch mode: number of inverses queued for writing.
+ * -concurrent[=cores] Batch mode: invert several matrices at once, each on
+ *                     its own subset of the cores (all OpenMP threads by
+ *                     default), see batch_pipeline.h.
+ * -team=<ranks>       MPI program, batch mode: ranks inverting each matrix
+ *                     together, sized per matrix by default (see
+ *                     mpi_farm.h).
+ * -profile[=counters] Print a per-phase time breakdown, optionally with
+ *                     hardware counters (needs a -DENABLE_PROFILING build).
+ * -mpi-profile[=sync] MPI program: report per-collective and per-rank
+ *                     communication costs, sync separates wait from transfer.
+ * -trace=<file>       Write a per-thread (and per-rank) timeline of the
+ *                     profiled phases as Chrome trace-event JSON.
+ * -verify[=sampled|full] Check every inverse through ||A·X - I||, sampled
+ *                     (the default) costs O(n^2), full the exact 2n^3 product.
+ * -cond-limit=<value> Abort an inversion whose 1-norm condition number
+ *                     estimate exceeds value.
+ * -pin                OpenMP engine: pin thread t to the t-th allowed CPU
+ *                     (unless OMP_PROC_BIND is set).
+ * -hugepages=<mode>   OpenMP engine: back the augmented matrix with off,
+ *                     thp (transparent, the default) or explicit huge pages.
+ * -precision=<type>   Element type of a single inversion: double (the
+ *                     default), float or complex (double complex).
+ * -ooc=<MB>           OpenMP program: invert out of core, keeping at most MB
+ *                     megabytes of the matrix in memory. The input must be a
+ *                     .bin file or -generate=.
+ * -ooc-dir=<directory> Out-of-core: where to create the scratch file.
+ * -ooc-out=<file.bin> Out-of-core: write the inverse to this binary file.
+ * -stream             OpenMP program: start eliminating while the matrix is
+ *                     still being read (see matrix_inversion_stream.h).
+ * -exact              OpenMP program: invert a single matrix exactly over the
+ *                     rationals (see matrix_inversion_exact.h).
+ * -exact-out=<file>   Exact: write the denominator and the numerators.
+ * -blocks             OpenMP program: invert the independent diagonal blocks
+ *                     of a permuted block-diagonal matrix separately, and
+ *                     banded blocks by band elimination (see
+ *                     matrix_inversion_blocks.h).
+ * -structure=<s>      OpenMP program: invert Toeplitz matrices in O(n^2) and
+ *                     circulant ones by FFT, auto (detect them), general,
+ *                     toeplitz or circulant (trust the hint and read only the
+ *                     first row and column, see matrix_inversion_structured.h).
+ * -diagonal           OpenMP program: compute only the diagonal of the inverse
+ *                     of a single matrix (see matrix_inversion_selected.h).
+ * -diagonal-out=<file> Diagonal: write it, one entry per line.
+ * -tuning=<file>      OpenMP program: run each inversion with the engine,
+ *                     thread count and chunk size a tuning profile (written
+ *                     by benchmark_program -tune=) gives for its size.
+ */
+struct cli_options
+{
+    const char *filepath;
+    const char *dirpath;
+    const char *manifest;
+    bool generate;
+    struct matrix_spec generate_spec;
+    const char *out_dir;
+    int prefetch_depth;
+    int writeback_depth;
+    int concurrent_cores; /* 0 one matrix at a time, -1 all threads */
+    int team_ranks;       /* 0 sizes the team of every matrix from its work */
+    bool profile;
+    bool profile_counters;
+    bool mpi_profile;
+    bool mpi_profile_sync;
+    const char *trace_path;
+    enum verify_mode verify;
+    double cond_limit;
+    bool pin;
+    enum huge_page_mode huge_pages;
+    enum scalar_type precision;
+    double ooc_memory_mb;
+    const char *ooc_dir;
+    const char *ooc_out;
+    bool stream;
+    bool exact;
+    const char *exact_out;
+    bool blocks;
+    const char *structure; /* NULL unless -structure= */
+    bool diagonal;
+    const char *diagonal_out;
+    const char *tuning_path;
+};
+
+void init_cli_options(struct cli_options *opts);
+
+/* Parses argv into opts, returns false (after printing why) if the options are unusable */
+bool parse_cli_options(int argc, char *argv[], struct cli_options *opts);
+
+void print_usage(const char *prog);
+
+static inline bool is_batch_mode(const struct cli_options *opts)
+{
+    return opts->dirpath || opts->manifest;
+}
+
+#endif /* CLI_OPTIONS_H */
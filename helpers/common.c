@@ -97,51 +97,6 @@ bool compare_matrices(int nrow, int ncol, double mat1[nrow][ncol], double mat2[n
     }
     return true;
 }
-bool check_inverse(int nrow, int ncol, double m1[nrow][ncol], double m2[nrow][ncol])
-{
-    if (nrow != ncol)
-    {
-        printf("Error: Matrices must be square to check for inverses.\n");
-        return false;
-    }
-
-    bool success = true;
-    double mat_res[nrow][ncol];
-    double tolerance = 1e-9;
-    int i, j, k;
-
-    // Initialize mat_res to zero and compute the product of m1 and m2
-    for (i = 0; i < nrow; i++)
-    {
-        for (j = 0; j < ncol; j++)
-        {
-            mat_res[i][j] = 0;
-
-            for (k = 0; k < nrow; k++)
-            {
-                mat_res[i][j] += m1[i][k] * m2[k][j];
-            }
-
-            // Check identity matrix conditions
-            if (i == j && fabs(1.0 - mat_res[i][j]) > tolerance)
-            {
-                printf("Diagonal element at (%d, %d) is not 1. Value: %f\n", i, j, mat_res[i][j]);
-                success = false;
-            }
-            else if (i != j && fabs(mat_res[i][j]) > tolerance)
-            {
-                printf("Off-diagonal element at (%d, %d) is not 0. Value: %f\n", i, j, mat_res[i][j]);
-                success = false;
-            }
-        }
-    }
-
-    printf("####check_inverse: original matrix and its inverse multiplication:\n");
-    print_mat(nrow, ncol, mat_res);
-
-    return success;
-}
-
 void compare_inversions(const char *fname, int nrow, int ncol, double mat_inv_serial[nrow][ncol], double mat_inv_parallel[nrow][ncol])
 {
     if (compare_matrices(nrow, ncol, mat_inv_serial, mat_inv_parallel))
@@ -0,0 +1,332 @@
+/*
+ * @file condition.c
+ * @brief Hager/Higham 1-norm condition estimate from the forward elimination or an LU factorization
+ */
+
+#include "condition.h"
+
+#include <float.h>  /* DBL_EPSILON */
+#include <math.h>   /* fabs, isfinite */
+#include <stdlib.h> /* malloc */
+
+#define COND_MAX_ITERATIONS 5
+
+/* Columns summed per pass of cond_norm1, the partial sums stay on the stack */
+#define COND_NORM_BLOCK 256
+
+static double cond_limit = 0.0;
+static double cond_last = -1.0;
+
+void cond_set_limit(double limit)
+{
+    cond_limit = limit;
+}
+
+double cond_get_limit(void)
+{
+    return cond_limit;
+}
+
+double cond_norm1(int n, int ncol, const double mat[n][ncol], int col0)
+{
+    double norm = 0.0;
+    for (int jb = 0; jb < n; jb += COND_NORM_BLOCK)
+    {
+        int width = n - jb < COND_NORM_BLOCK ? n - jb : COND_NORM_BLOCK;
+        double sums[COND_NORM_BLOCK] = {0.0};
+
+        /* Row by row to stream through memory */
+        for (int i = 0; i < n; i++)
+        {
+            const double *row = mat[i] + col0 + jb;
+            for (int j = 0; j < width; j++)
+            {
+                sums[j] += fabs(row[j]);
+            }
+        }
+
+        for (int j = 0; j < width; j++)
+        {
+            norm = sums[j] > norm ? sums[j] : norm;
+        }
+    }
+    return norm;
+}
+
+double cond_pivot_tolerance(int n, int ncol, const double mat[n][ncol])
+{
+    return DBL_EPSILON * cond_norm1(n, ncol, mat, 0);
+}
+
+/* y = A^-1·x = U^-1·(M·x), row i of [U | M] is stored in row perm[i] and column perm[j] of M in
+ * column n + j (the identity is placed in pivot order, see matrix_inversion_generic.h) */
+static void apply_inverse(int n, int ncol, const double aug[n][ncol], const int perm[n], const double *x, double *y)
+{
+    for (int i = 0; i < n; i++)
+    {
+        const double *row = aug[perm[i]];
+        double sum = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            sum += row[n + j] * x[perm[j]];
+        }
+        y[i] = sum;
+    }
+
+    /* Back substitution, U has a unit diagonal */
+    for (int i = n - 1; i >= 0; i--)
+    {
+        const double *row = aug[perm[i]];
+        double sum = y[i];
+        for (int j = i + 1; j < n; j++)
+        {
+            sum -= row[j] * y[j];
+        }
+        y[i] = sum;
+    }
+}
+
+/* z = A^-T·x = M^T·(U^-T·x), w is scratch */
+static void apply_inverse_transpose(int n, int ncol, const double aug[n][ncol], const int perm[n], const double *x, double *z, double *w)
+{
+    for (int i = 0; i < n; i++)
+    {
+        w[i] = x[i];
+        z[i] = 0.0;
+    }
+
+    /* Forward substitution with U^T, row oriented: w[i] is final once reached */
+    for (int i = 0; i < n; i++)
+    {
+        const double *row = aug[perm[i]];
+        for (int j = i + 1; j < n; j++)
+        {
+            w[j] -= row[j] * w[i];
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        const double *row = aug[perm[i]];
+        for (int j = 0; j < n; j++)
+        {
+            z[perm[j]] += row[n + j] * w[i];
+        }
+    }
+}
+
+/* y = A^-1·x = U^-1·L^-1·P·x from the LU factors, row i of L\U is stored in row perm[i] with the
+ * unit diagonal of L implied (see invert_selected_ws) */
+static void apply_inverse_lu(int n, int ncol, const double lu[n][ncol], const int perm[n], const double *x, double *y)
+{
+    for (int i = 0; i < n; i++)
+    {
+        const double *row = lu[perm[i]];
+        double sum = x[perm[i]];
+        for (int j = 0; j < i; j++)
+        {
+            sum -= row[j] * y[j];
+        }
+        y[i] = sum;
+    }
+
+    for (int i = n - 1; i >= 0; i--)
+    {
+        const double *row = lu[perm[i]];
+        double sum = y[i];
+        for (int j = i + 1; j < n; j++)
+        {
+            sum -= row[j] * y[j];
+        }
+        y[i] = sum / row[i];
+    }
+}
+
+/* z = A^-T·x = P^T·L^-T·U^-T·x, w is scratch */
+static void apply_inverse_transpose_lu(int n, int ncol, const double lu[n][ncol], const int perm[n], const double *x, double *z, double *w)
+{
+    for (int i = 0; i < n; i++)
+    {
+        w[i] = x[i];
+    }
+
+    /* Forward substitution with U^T, row oriented: w[i] is final once divided */
+    for (int i = 0; i < n; i++)
+    {
+        const double *row = lu[perm[i]];
+        w[i] /= row[i];
+        for (int j = i + 1; j < n; j++)
+        {
+            w[j] -= row[j] * w[i];
+        }
+    }
+
+    /* Back substitution with the unit L^T, w[i] is final once reached */
+    for (int i = n - 1; i > 0; i--)
+    {
+        const double *row = lu[perm[i]];
+        for (int j = 0; j < i; j++)
+        {
+            w[j] -= row[j] * w[i];
+        }
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        z[perm[i]] = w[i];
+    }
+}
+
+static double vector_norm1(int n, const double *v)
+{
+    double sum = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        sum += fabs(v[i]);
+    }
+    return sum;
+}
+
+double cond_estimate_ge(int n, int ncol, const double aug[n][ncol], const int perm[n])
+{
+    double *work = malloc(4 * n * sizeof(double));
+    if (!work)
+    {
+        return INFINITY;
+    }
+    double estimate = cond_estimate_ge_work(n, ncol, aug, perm, work);
+    free(work);
+    return estimate;
+}
+
+/* A^-1·x and A^-T·x from either layout, [U | M] or the LU factors */
+static void apply_either(bool lu, int n, int ncol, const double aug[n][ncol], const int perm[n], const double *x, double *y)
+{
+    if (lu)
+    {
+        apply_inverse_lu(n, ncol, aug, perm, x, y);
+    }
+    else
+    {
+        apply_inverse(n, ncol, aug, perm, x, y);
+    }
+}
+
+static void apply_either_transpose(bool lu, int n, int ncol, const double aug[n][ncol], const int perm[n], const double *x, double *z,
+                                   double *w)
+{
+    if (lu)
+    {
+        apply_inverse_transpose_lu(n, ncol, aug, perm, x, z, w);
+    }
+    else
+    {
+        apply_inverse_transpose(n, ncol, aug, perm, x, z, w);
+    }
+}
+
+/* Hager/Higham estimate of ||A^-1||_1 from either layout */
+static double estimate_inverse_norm1(bool lu, int n, int ncol, const double aug[n][ncol], const int perm[n], double work[4 * n])
+{
+    double *x = work, *y = work + n, *z = work + 2 * n, *w = work + 3 * n;
+
+    /* Hager's iteration: maximize ||A^-1·x||_1 over the unit 1-norm ball, starting from its centre */
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = 1.0 / n;
+    }
+
+    double estimate = 0.0;
+    int last = -1;
+    for (int iter = 0; iter < COND_MAX_ITERATIONS; iter++)
+    {
+        apply_either(lu, n, ncol, aug, perm, x, y);
+        estimate = vector_norm1(n, y);
+
+        for (int i = 0; i < n; i++)
+        {
+            x[i] = y[i] >= 0.0 ? 1.0 : -1.0;
+        }
+        apply_either_transpose(lu, n, ncol, aug, perm, x, z, w);
+
+        /* z^T·x for the x used in this iteration: the uniform start or e_last */
+        int j = 0;
+        double ztx = iter == 0 ? 0.0 : z[last];
+        for (int i = 0; i < n; i++)
+        {
+            j = fabs(z[i]) > fabs(z[j]) ? i : j;
+            ztx += iter == 0 ? z[i] / n : 0.0;
+        }
+
+        /* Converged when no unit vector improves on the current gradient */
+        if (fabs(z[j]) <= ztx || j == last)
+        {
+            break;
+        }
+
+        last = j;
+        for (int i = 0; i < n; i++)
+        {
+            x[i] = 0.0;
+        }
+        x[j] = 1.0;
+    }
+
+    /* Higham's alternating test vector guards against the worst cases of the iteration */
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = (i % 2 ? -1.0 : 1.0) * (1.0 + (n > 1 ? (double)i / (n - 1) : 0.0));
+    }
+    apply_either(lu, n, ncol, aug, perm, x, y);
+    double alternative = 2.0 * vector_norm1(n, y) / (3.0 * n);
+    return alternative > estimate ? alternative : estimate;
+}
+
+double cond_estimate_ge_work(int n, int ncol, const double aug[n][ncol], const int perm[n], double work[4 * n])
+{
+    return estimate_inverse_norm1(false, n, ncol, aug, perm, work);
+}
+
+double cond_estimate_lu_work(int n, int ncol, const double lu[n][ncol], const int perm[n], double work[4 * n])
+{
+    return estimate_inverse_norm1(true, n, ncol, lu, perm, work);
+}
+
+bool cond_accept(double cond)
+{
+    cond_record(cond);
+    return cond_check(cond, cond_limit);
+}
+
+void cond_record(double cond)
+{
+    cond_last = cond;
+}
+
+bool cond_check(double cond, double limit)
+{
+    if (!isfinite(cond))
+    {
+        printf("Condition number estimate is not finite, the matrix is numerically singular.\n");
+        return false;
+    }
+    if (limit > 0.0 && cond > limit)
+    {
+        printf("Condition number estimate %.3e exceeds the limit %.3e, rejecting the matrix.\n", cond, limit);
+        return false;
+    }
+    return true;
+}
+
+void cond_report(FILE *fp)
+{
+    if (cond_last >= 0.0)
+    {
+        fprintf(fp, "Condition number estimate (1-norm): %.3e\n", cond_last);
+    }
+}
+
+double cond_last_recorded(void)
+{
+    return cond_last;
+}
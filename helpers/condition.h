@@ -0,0 +1,64 @@
+#ifndef CONDITION_H
+#define CONDITION_H
+
+#include <stdbool.h> /* bool */
+#include <stdio.h>   /* FILE */
+
+/* Condition number checks of the inversion engines.
+ *
+ * After the forward elimination the augmented matrix [A | I] has become
+ * [U | M] with U unit upper triangular and M·A = U, so A^-1 = U^-1·M.
+ * The engines place the identity in pivot order, so the columns of M are
+ * permuted like its rows.
+ * cond_estimate_ge runs the Hager/Higham 1-norm estimator on that pair:
+ * each iteration applies A^-1 and A^-T through one matrix-vector product
+ * and one triangular solve, O(n^2) work, so it costs little next to the
+ * O(n^3) elimination and runs before the back substitution. An input that
+ * exceeds the limit set with cond_set_limit is rejected at that point
+ * instead of spending the rest of the inversion on a useless result.
+ */
+
+/* Reject matrices whose estimated condition number exceeds limit (0 disables) */
+void cond_set_limit(double limit);
+double cond_get_limit(void);
+
+/* 1-norm (max column sum) of the n x n block of mat starting at column col0 */
+double cond_norm1(int n, int ncol, const double mat[n][ncol], int col0);
+
+/* Relative pivot threshold, pivots at or below it make the matrix numerically singular */
+double cond_pivot_tolerance(int n, int ncol, const double mat[n][ncol]);
+
+/* Estimate ||A^-1||_1 from the eliminated n x 2n augmented matrix [U | M],
+ * whose row i is stored in row perm[i] and column perm[j] of M in column
+ * n + j (perm being the pivot order of the elimination)
+ */
+double cond_estimate_ge(int n, int ncol, const double aug[n][ncol], const int perm[n]);
+
+/* The same with the caller's scratch space of 4n doubles, allocation-free */
+double cond_estimate_ge_work(int n, int ncol, const double aug[n][ncol], const int perm[n], double work[4 * n]);
+
+/* The same from an LU factorization with partial pivoting kept in the n x n
+ * block of lu: row i of L\U is stored in row perm[i], L has a unit diagonal
+ * that is not stored and U the pivots. Allocation-free as well.
+ */
+double cond_estimate_lu_work(int n, int ncol, const double lu[n][ncol], const int perm[n], double work[4 * n]);
+
+/* Record the condition number of the matrix being inverted. Returns false
+ * (after printing why) if it exceeds the limit or is not finite.
+ */
+bool cond_accept(double cond);
+
+/* The two halves of cond_accept for callers that keep their own limit and
+ * result (see matinv.h): record cond for cond_report, and check it against
+ * limit without touching any shared state.
+ */
+void cond_record(double cond);
+bool cond_check(double cond, double limit);
+
+/* Print the last recorded condition number */
+void cond_report(FILE *fp);
+
+/* The last recorded condition number, negative if none */
+double cond_last_recorded(void);
+
+#endif /* CONDITION_H */
@@ -0,0 +1,142 @@
+/*
+ * @file fft.c
+ * @brief Radix-2 and Bluestein discrete Fourier transforms
+ */
+
+#include "fft.h"
+
+#include <math.h>   /* cos, sin */
+#include <stdio.h>  /* perror */
+#include <stdlib.h> /* malloc, free */
+
+#define PI 3.14159265358979323846
+
+static bool is_power_of_two(int n)
+{
+    return (n & (n - 1)) == 0;
+}
+
+/* In-place radix-2 transform of the power of two m, sign -1 forward and +1 backward, unscaled */
+static bool fft_radix2(int m, double complex *x, int sign)
+{
+    if (m < 2)
+    {
+        return true;
+    }
+    double complex *twiddle = malloc((m / 2) * sizeof(double complex));
+    if (!twiddle)
+    {
+        perror("malloc (fft twiddles)");
+        return false;
+    }
+    for (int k = 0; k < m / 2; k++)
+    {
+        double angle = sign * 2.0 * PI * k / m;
+        twiddle[k] = cos(angle) + I * sin(angle);
+    }
+
+    /* Bit-reversal permutation */
+    for (int i = 1, j = 0; i < m; i++)
+    {
+        int bit = m >> 1;
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j)
+        {
+            double complex tmp = x[i];
+            x[i] = x[j];
+            x[j] = tmp;
+        }
+    }
+
+    for (int len = 2; len <= m; len <<= 1)
+    {
+        int half = len / 2, stride = m / len;
+        for (int start = 0; start < m; start += len)
+        {
+            for (int k = 0; k < half; k++)
+            {
+                double complex t = twiddle[k * stride] * x[start + k + half];
+                x[start + k + half] = x[start + k] - t;
+                x[start + k] += t;
+            }
+        }
+    }
+
+    free(twiddle);
+    return true;
+}
+
+/* Bluestein: with jk = (j^2 + k^2 - (k - j)^2) / 2, X_k = w_k · sum_j (x_j w_j) conj(w_(k-j)) for the chirp w_k = e^(sign pi i k^2 / n) */
+static bool fft_bluestein(int n, double complex *x, int sign)
+{
+    int m = 1;
+    while (m < 2 * n - 1)
+    {
+        m <<= 1;
+    }
+    double complex *chirp = malloc(n * sizeof(double complex));
+    double complex *a = calloc(m, sizeof(double complex));
+    double complex *b = calloc(m, sizeof(double complex));
+    bool ok = chirp && a && b;
+    if (!ok)
+    {
+        perror("malloc (fft buffers)");
+    }
+
+    if (ok)
+    {
+        for (int k = 0; k < n; k++)
+        {
+            /* k^2 mod 2n keeps the angle small, and exact */
+            long long k2 = (long long)k * k % (2LL * n);
+            double angle = sign * PI * (double)k2 / n;
+            chirp[k] = cos(angle) + I * sin(angle);
+            a[k] = x[k] * chirp[k];
+        }
+        b[0] = conj(chirp[0]);
+        for (int k = 1; k < n; k++)
+        {
+            b[k] = b[m - k] = conj(chirp[k]);
+        }
+
+        ok = fft_radix2(m, a, -1) && fft_radix2(m, b, -1);
+        if (ok)
+        {
+            for (int k = 0; k < m; k++)
+            {
+                a[k] *= b[k];
+            }
+            ok = fft_radix2(m, a, 1);
+        }
+        if (ok)
+        {
+            for (int k = 0; k < n; k++)
+            {
+                x[k] = chirp[k] * a[k] / m;
+            }
+        }
+    }
+
+    free(b);
+    free(a);
+    free(chirp);
+    return ok;
+}
+
+bool fft(int n, double complex *x, bool inverse)
+{
+    int sign = inverse ? 1 : -1;
+    bool ok = is_power_of_two(n) ? fft_radix2(n, x, sign) : fft_bluestein(n, x, sign);
+    if (ok && inverse)
+    {
+        for (int k = 0; k < n; k++)
+        {
+            x[k] /= n;
+        }
+    }
+    return ok;
+}
@@ -0,0 +1,21 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex.h> /* double complex */
+#include <stdbool.h> /* bool */
+
+/* Discrete Fourier transforms of any length.
+ *
+ * Powers of two run an iterative radix-2 transform with a table of
+ * twiddle factors computed directly (not by repeated multiplication), so
+ * the error stays at O(log n) rounding errors. Other lengths go through
+ * Bluestein's chirp-z algorithm, which writes the transform as a
+ * convolution and evaluates it with power-of-two transforms of at least
+ * 2n - 1 points.
+ */
+
+/* x_k <- sum_j x_j e^(-2 pi i jk / n), or with e^(+2 pi i jk / n) and divided by n if inverse.
+ * Returns false if out of memory. */
+bool fft(int n, double complex *x, bool inverse);
+
+#endif /* FFT_H */
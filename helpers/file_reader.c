@@ -1,9 +1,25 @@
 #include "file_reader.h"
+#include "cli_options.h"
+#include "matrix_gen.h"
+#include "profiler.h"
+#include <complex.h> /* double complex, creal, cimag, I */
 #include <stdio.h>   /* printf, perror, FILE, fopen, fscanf */
 #include <stdlib.h>  /* malloc, free */
-#include <string.h>  /* strlen, strcpy, strcat */
+#include <string.h>  /* strlen, strcmp, memcmp */
 #include <stdbool.h> /* bool, true, false */
 #include <stddef.h>
+#include <stdint.h>  /* int64_t */
+
+/* Binary matrix files: this magic, int64 nrow and ncol (BINARY_MATRIX_DATA_OFFSET bytes in all), then the rows as native doubles */
+#define BINARY_MAGIC "MATBIN01"
+#define BINARY_MAGIC_LEN 8
+
+/* Magic of each element type, the double one is BINARY_MAGIC */
+static const char *binary_magics[SCALAR_TYPE_COUNT] = {
+    [SCALAR_FLOAT] = "MATBINF1",
+    [SCALAR_DOUBLE] = BINARY_MAGIC,
+    [SCALAR_COMPLEX] = "MATBINZ1",
+};
 
 /* Helper function to free the matrix */
 void free_matrix_file_reader(double **mat, int nrow)
@@ -18,10 +34,119 @@ void free_matrix_file_reader(double **mat, int nrow)
     }
 }
 
-/* A method to read a matrix from a file */
-bool read_matrix_from_file(const char *filepath, int *nrow, int *ncol, double ***mat)
+/* True if filepath names a binary matrix file */
+static bool is_binary_path(const char *filepath)
+{
+    size_t len = strlen(filepath);
+    return len > 4 && strcmp(filepath + len - 4, ".bin") == 0;
+}
+
+/* Allocate nrow rows of ncol doubles */
+static bool allocate_rows(int nrow, int ncol, double ***mat)
+{
+    *mat = (double **)malloc(nrow * sizeof(double *));
+    if (!*mat)
+    {
+        perror("malloc (matrix rows)");
+        return false;
+    }
+
+    for (int i = 0; i < nrow; ++i)
+    {
+        (*mat)[i] = (double *)malloc(ncol * sizeof(double));
+        if (!(*mat)[i])
+        {
+            perror("malloc (matrix columns)");
+            free_matrix_file_reader(*mat, i); // Free already allocated rows
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Read the header of a binary matrix file of any element type, leaving fp at the first row */
+static bool read_typed_binary_header(FILE *fp, const char *filepath, enum scalar_type *type, int *nrow, int *ncol)
+{
+    char magic[BINARY_MAGIC_LEN];
+    int64_t dims[2];
+    int t = SCALAR_TYPE_COUNT;
+    if (fread(magic, 1, BINARY_MAGIC_LEN, fp) == BINARY_MAGIC_LEN)
+    {
+        for (t = 0; t < SCALAR_TYPE_COUNT && memcmp(magic, binary_magics[t], BINARY_MAGIC_LEN) != 0; t++)
+        {
+        }
+    }
+    if (t == SCALAR_TYPE_COUNT || fread(dims, sizeof(int64_t), 2, fp) != 2 || dims[0] < 1 || dims[1] < 1 ||
+        dims[0] > INT32_MAX || dims[1] > INT32_MAX)
+    {
+        printf("Invalid binary matrix header in file: %s\n", filepath);
+        return false;
+    }
+    *type = (enum scalar_type)t;
+    *nrow = (int)dims[0];
+    *ncol = (int)dims[1];
+    return true;
+}
+
+/* Read the header of a binary matrix file of doubles, leaving fp at the first row */
+static bool read_binary_header(FILE *fp, const char *filepath, int *nrow, int *ncol)
+{
+    enum scalar_type type;
+    if (!read_typed_binary_header(fp, filepath, &type, nrow, ncol))
+    {
+        return false;
+    }
+    if (type != SCALAR_DOUBLE)
+    {
+        printf("File %s holds %s entries, use -precision=%s.\n", filepath, scalar_type_name(type), scalar_type_name(type));
+        return false;
+    }
+    return true;
+}
+
+static bool write_typed_binary_header(FILE *fp, enum scalar_type type, int nrow, int ncol)
+{
+    int64_t dims[2] = {nrow, ncol};
+    return fwrite(binary_magics[type], 1, BINARY_MAGIC_LEN, fp) == BINARY_MAGIC_LEN && fwrite(dims, sizeof(int64_t), 2, fp) == 2;
+}
+
+static bool write_binary_header(FILE *fp, int nrow, int ncol)
+{
+    return write_typed_binary_header(fp, SCALAR_DOUBLE, nrow, ncol);
+}
+
+bool read_binary_matrix_header(const char *filepath, int *nrow, int *ncol)
+{
+    FILE *fp = fopen(filepath, "rb");
+    if (!fp)
+    {
+        perror("Error opening file");
+        return false;
+    }
+    bool ok = read_binary_header(fp, filepath, nrow, ncol);
+    fclose(fp);
+    return ok;
+}
+
+bool create_binary_matrix_file(const char *filepath, int nrow, int ncol)
+{
+    FILE *fp = fopen(filepath, "wb");
+    if (!fp)
+    {
+        perror("Error opening output file");
+        return false;
+    }
+    bool ok = write_binary_header(fp, nrow, ncol);
+    if (!ok)
+    {
+        perror("Error writing output file");
+    }
+    return fclose(fp) == 0 && ok;
+}
+
+/* Dimensions of a text matrix file, from its name matrix_<rows>x<cols>_<index>.txt */
+static bool text_matrix_dimensions(const char *filepath, int *nrow, int *ncol)
 {
-    /* Extract dimensions from the filename */
     int index;
     const char *fname = strrchr(filepath, '/'); // Extract filename from path
     if (!fname)
@@ -34,53 +159,415 @@ bool read_matrix_from_file(const char *filepath, int *nrow, int *ncol, double **
         printf("Skipping invalid filename: %s\n", fname);
         return false;
     }
+    return true;
+}
 
-    printf("Reading %dx%d matrix from %s\n", *nrow, *ncol, filepath);
+bool read_matrix_dimensions(const char *filepath, int *nrow, int *ncol)
+{
+    return is_binary_path(filepath) ? read_binary_matrix_header(filepath, nrow, ncol)
+                                    : text_matrix_dimensions(filepath, nrow, ncol);
+}
 
-    /* Open the file */
-    FILE *fp = fopen(filepath, "r");
-    if (!fp)
+bool matrix_stream_open(struct matrix_stream *stream, const char *filepath)
+{
+    stream->filepath = filepath;
+    stream->binary = is_binary_path(filepath);
+    stream->next = 0;
+    stream->fp = NULL;
+    if (!stream->binary && !text_matrix_dimensions(filepath, &stream->nrow, &stream->ncol))
+    {
+        return false;
+    }
+
+    stream->fp = fopen(filepath, stream->binary ? "rb" : "r");
+    if (!stream->fp)
     {
         perror("Error opening file");
         return false;
     }
+    if (stream->binary && !read_binary_header(stream->fp, filepath, &stream->nrow, &stream->ncol))
+    {
+        matrix_stream_close(stream);
+        return false;
+    }
+
+    printf("Reading %dx%d matrix from %s\n", stream->nrow, stream->ncol, filepath);
+    return true;
+}
+
+bool matrix_stream_read(struct matrix_stream *stream, int nrows, double *rows)
+{
+    int ncol = stream->ncol;
+    if (nrows > stream->nrow - stream->next)
+    {
+        printf("Only %d rows left in file: %s\n", stream->nrow - stream->next, stream->filepath);
+        return false;
+    }
+
+    for (int r = 0; r < nrows; ++r, ++stream->next)
+    {
+        double *row = rows + (size_t)r * ncol;
+        if (stream->binary)
+        {
+            if (fread(row, sizeof(double), ncol, stream->fp) != (size_t)ncol)
+            {
+                printf("Error reading matrix row %d in file: %s\n", stream->next, stream->filepath);
+                return false;
+            }
+            continue;
+        }
+        for (int j = 0; j < ncol; ++j)
+        {
+            if (fscanf(stream->fp, "%lf", &row[j]) != 1)
+            {
+                printf("Error reading matrix value at [%d][%d] in file: %s\n", stream->next, j, stream->filepath);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void matrix_stream_close(struct matrix_stream *stream)
+{
+    if (stream->fp)
+    {
+        fclose(stream->fp);
+        stream->fp = NULL;
+    }
+}
+
+/* Parse the matrix file, see read_matrix_from_file */
+static bool parse_matrix_file(const char *filepath, int *nrow, int *ncol, double ***mat)
+{
+    struct matrix_stream stream;
+    if (!matrix_stream_open(&stream, filepath))
+    {
+        return false;
+    }
+    *nrow = stream.nrow;
+    *ncol = stream.ncol;
 
     /* Allocate memory for the matrix */
-    *mat = (double **)malloc(*nrow * sizeof(double *));
-    if (!*mat)
+    if (!allocate_rows(*nrow, *ncol, mat))
     {
-        perror("malloc (matrix rows)");
-        fclose(fp);
+        matrix_stream_close(&stream);
         return false;
     }
 
+    /* Scan the file and read the matrix */
     for (int i = 0; i < *nrow; ++i)
     {
-        (*mat)[i] = (double *)malloc(*ncol * sizeof(double));
-        if (!(*mat)[i])
+        if (!matrix_stream_read(&stream, 1, (*mat)[i]))
         {
-            perror("malloc (matrix columns)");
-            free_matrix_file_reader(*mat, i); // Free already allocated rows
-            fclose(fp);
+            free_matrix_file_reader(*mat, *nrow);
+            matrix_stream_close(&stream);
             return false;
         }
     }
 
-    /* Scan the file and read the matrix */
-    for (int i = 0; i < *nrow; ++i)
+    matrix_stream_close(&stream);
+    return true;
+}
+
+/* A method to read a matrix from a file */
+bool read_matrix_from_file(const char *filepath, int *nrow, int *ncol, double ***mat)
+{
+    PROF_BEGIN(PHASE_READ);
+    bool ok = parse_matrix_file(filepath, nrow, ncol, mat);
+    PROF_END(PHASE_READ);
+    return ok;
+}
+
+/* A method to write a matrix to a file, one row per line (or binary for .bin paths) */
+bool write_matrix_to_file(const char *filepath, int nrow, int ncol, double mat[nrow][ncol])
+{
+    bool binary = is_binary_path(filepath);
+    FILE *fp = fopen(filepath, binary ? "wb" : "w");
+    if (!fp)
     {
-        for (int j = 0; j < *ncol; ++j)
+        perror("Error opening output file");
+        return false;
+    }
+
+    bool ok = true;
+    if (binary)
+    {
+        ok = write_binary_header(fp, nrow, ncol) &&
+             fwrite(mat, sizeof(double), (size_t)nrow * ncol, fp) == (size_t)nrow * ncol;
+    }
+    else
+    {
+        for (int i = 0; i < nrow; ++i)
+        {
+            for (int j = 0; j < ncol; ++j)
+            {
+                fprintf(fp, "%.17g ", mat[i][j]);
+            }
+            fprintf(fp, "\n");
+        }
+    }
+    if (!ok)
+    {
+        perror("Error writing output file");
+    }
+
+    if (fclose(fp) != 0)
+    {
+        perror("Error closing output file");
+        return false;
+    }
+    return ok;
+}
+
+/* Read one text entry into element i of mat. A complex entry is re+imi or re-imi without spaces,
+ * a plain real number has imaginary part 0. */
+static bool read_text_entry(FILE *fp, enum scalar_type type, void *mat, size_t i)
+{
+    double re, im = 0.0;
+    if (fscanf(fp, "%lf", &re) != 1)
+    {
+        return false;
+    }
+
+    switch (type)
+    {
+    case SCALAR_FLOAT:
+        ((float *)mat)[i] = (float)re;
+        return true;
+    case SCALAR_COMPLEX:
+    {
+        int c = getc(fp);
+        if (c == '+' || c == '-')
         {
-            if (fscanf(fp, "%lf", &(*mat)[i][j]) != 1)
+            ungetc(c, fp);
+            if (fscanf(fp, "%lf", &im) != 1 || getc(fp) != 'i')
             {
-                printf("Error reading matrix value at [%d][%d] in file: %s\n", i, j, filepath);
-                free_matrix_file_reader(*mat, *nrow);
-                fclose(fp);
                 return false;
             }
         }
+        else if (c != EOF)
+        {
+            ungetc(c, fp);
+        }
+        ((double complex *)mat)[i] = re + im * I;
+        return true;
     }
+    default:
+        ((double *)mat)[i] = re;
+        return true;
+    }
+}
 
-    fclose(fp);
-    return true;
+static void write_text_entry(FILE *fp, enum scalar_type type, const void *mat, size_t i)
+{
+    switch (type)
+    {
+    case SCALAR_FLOAT:
+        fprintf(fp, "%.9g ", ((const float *)mat)[i]);
+        break;
+    case SCALAR_COMPLEX:
+    {
+        double complex z = ((const double complex *)mat)[i];
+        fprintf(fp, "%.17g%+.17gi ", creal(z), cimag(z));
+        break;
+    }
+    default:
+        fprintf(fp, "%.17g ", ((const double *)mat)[i]);
+        break;
+    }
+}
+
+/* Rows of a binary file into mat, converting from the stored element type */
+static bool read_typed_binary_rows(FILE *fp, const char *filepath, enum scalar_type stored, enum scalar_type type, int nrow,
+                                   int ncol, void *mat)
+{
+    size_t count = (size_t)nrow * ncol;
+    if (stored == type)
+    {
+        if (fread(mat, scalar_size(type), count, fp) != count)
+        {
+            printf("Error reading matrix data in file: %s\n", filepath);
+            return false;
+        }
+        return true;
+    }
+
+    /* Only widening conversions from double are allowed, everything else would lose information silently */
+    if (stored != SCALAR_DOUBLE)
+    {
+        printf("File %s holds %s entries, use -precision=%s.\n", filepath, scalar_type_name(stored), scalar_type_name(stored));
+        return false;
+    }
+
+    double *row = malloc(ncol * sizeof(double));
+    if (!row)
+    {
+        perror("malloc (matrix row)");
+        return false;
+    }
+    bool ok = true;
+    for (int i = 0; i < nrow && ok; i++)
+    {
+        ok = fread(row, sizeof(double), ncol, fp) == (size_t)ncol;
+        for (int j = 0; j < ncol && ok; j++)
+        {
+            size_t k = (size_t)i * ncol + j;
+            if (type == SCALAR_FLOAT)
+            {
+                ((float *)mat)[k] = (float)row[j];
+            }
+            else
+            {
+                ((double complex *)mat)[k] = row[j];
+            }
+        }
+    }
+    if (!ok)
+    {
+        printf("Error reading matrix data in file: %s\n", filepath);
+    }
+    free(row);
+    return ok;
+}
+
+bool read_matrix_typed(const char *filepath, enum scalar_type type, int *nrow, int *ncol, void **mat)
+{
+    PROF_BEGIN(PHASE_READ);
+    bool binary = is_binary_path(filepath);
+    enum scalar_type stored = type;
+    bool ok = true;
+
+    FILE *fp = fopen(filepath, binary ? "rb" : "r");
+    if (!fp)
+    {
+        perror("Error opening file");
+        ok = false;
+    }
+    else if (binary)
+    {
+        ok = read_typed_binary_header(fp, filepath, &stored, nrow, ncol);
+    }
+    else
+    {
+        ok = text_matrix_dimensions(filepath, nrow, ncol);
+    }
+
+    *mat = NULL;
+    if (ok)
+    {
+        printf("Reading %dx%d %s matrix from %s\n", *nrow, *ncol, scalar_type_name(type), filepath);
+        *mat = malloc((size_t)*nrow * *ncol * scalar_size(type));
+        if (!*mat)
+        {
+            perror("malloc (matrix)");
+            ok = false;
+        }
+    }
+
+    if (ok && binary)
+    {
+        ok = read_typed_binary_rows(fp, filepath, stored, type, *nrow, *ncol, *mat);
+    }
+    else if (ok)
+    {
+        size_t count = (size_t)*nrow * *ncol;
+        for (size_t k = 0; k < count && ok; k++)
+        {
+            ok = read_text_entry(fp, type, *mat, k);
+            if (!ok)
+            {
+                printf("Error reading matrix value at [%zu][%zu] in file: %s\n", k / *ncol, k % *ncol, filepath);
+            }
+        }
+    }
+
+    if (fp)
+    {
+        fclose(fp);
+    }
+    if (!ok)
+    {
+        free(*mat);
+        *mat = NULL;
+    }
+    PROF_END(PHASE_READ);
+    return ok;
+}
+
+bool write_matrix_typed(const char *filepath, enum scalar_type type, int nrow, int ncol, const void *mat)
+{
+    bool binary = is_binary_path(filepath);
+    FILE *fp = fopen(filepath, binary ? "wb" : "w");
+    if (!fp)
+    {
+        perror("Error opening output file");
+        return false;
+    }
+
+    bool ok = true;
+    size_t count = (size_t)nrow * ncol;
+    if (binary)
+    {
+        ok = write_typed_binary_header(fp, type, nrow, ncol) && fwrite(mat, scalar_size(type), count, fp) == count;
+    }
+    else
+    {
+        for (size_t k = 0; k < count; k++)
+        {
+            write_text_entry(fp, type, mat, k);
+            if ((k + 1) % ncol == 0)
+            {
+                fprintf(fp, "\n");
+            }
+        }
+    }
+    if (!ok)
+    {
+        perror("Error writing output file");
+    }
+
+    if (fclose(fp) != 0)
+    {
+        perror("Error closing output file");
+        return false;
+    }
+    return ok;
+}
+
+void *load_typed_input_matrix(const struct cli_options *opts, int *n)
+{
+    enum scalar_type type = opts->precision;
+    *n = 0;
+    if (!opts->generate)
+    {
+        int nrow, ncol;
+        void *mat;
+        if (!read_matrix_typed(opts->filepath, type, &nrow, &ncol, &mat))
+        {
+            fprintf(stderr, "Failed to read matrix from file %s\n", opts->filepath);
+            return NULL;
+        }
+        if (nrow != ncol)
+        {
+            fprintf(stderr, "Matrix in %s is not square (%dx%d).\n", opts->filepath, nrow, ncol);
+            free(mat);
+            return NULL;
+        }
+        *n = nrow;
+        return mat;
+    }
+
+    int size = opts->generate_spec.n;
+    printf("Generating %dx%d %s %s matrix with seed %llu\n", size, size, scalar_type_name(type),
+           matrix_kind_name(opts->generate_spec.kind), (unsigned long long)opts->generate_spec.seed);
+    void *mat = malloc((size_t)size * size * scalar_size(type));
+    if (!mat || !generate_matrix_typed(&opts->generate_spec, type, mat))
+    {
+        fprintf(stderr, "Failed to generate the matrix\n");
+        free(mat);
+        return NULL;
+    }
+    *n = size;
+    return mat;
 }
@@ -2,8 +2,15 @@
 #define FILE_READER_H
 
 #include <stdbool.h> /* bool */
+#include <stdio.h>   /* FILE */
+
+#include "scalar.h"
 
 /* Reads a matrix from a file.
+ *
+ * Text files must be named matrix_<rows>x<cols>_<index>.txt. Files ending in
+ * .bin are binary: the 8 byte magic "MATBIN01", the number of rows and
+ * columns as int64, then the rows as native doubles.
  *
  * dir: Directory path to the file.
  * fname: Name of the file.
@@ -15,4 +22,75 @@
  */
 bool read_matrix_from_file(const char *filepath, int *nrow, int *ncol, double ***mat);
 
+/* A text or binary matrix file read a few rows at a time, for consumers
+ * that start working before the whole file is parsed. The files are the
+ * ones read_matrix_from_file accepts.
+ */
+struct matrix_stream
+{
+    FILE *fp;
+    const char *filepath;
+    bool binary;
+    int nrow;
+    int ncol;
+    int next; /* Index of the next row to read */
+};
+
+/* Opens filepath and reads its dimensions into stream->nrow and stream->ncol */
+bool matrix_stream_open(struct matrix_stream *stream, const char *filepath);
+
+/* Reads the next nrows rows into rows, row-major with stream->ncol columns */
+bool matrix_stream_read(struct matrix_stream *stream, int nrows, double *rows);
+
+void matrix_stream_close(struct matrix_stream *stream);
+
+/* Writes a matrix to a file in the same whitespace separated text format,
+ * or in the binary format if filepath ends in .bin.
+ *
+ * filepath: Path of the file to create or overwrite.
+ * nrow, ncol: Dimensions of the matrix.
+ * mat: The matrix to write.
+ *
+ * Returns true on success, false on failure.
+ */
+bool write_matrix_to_file(const char *filepath, int nrow, int ncol, double mat[nrow][ncol]);
+
+/* Binary files accessed in place, for matrices too large to load at once:
+ * row i starts at byte BINARY_MATRIX_DATA_OFFSET + i * ncol * sizeof(double).
+ */
+#define BINARY_MATRIX_DATA_OFFSET 24
+
+/* Reads only the dimensions of a binary matrix file */
+bool read_binary_matrix_header(const char *filepath, int *nrow, int *ncol);
+
+/* Dimensions of any matrix file without reading its entries: the header of a binary file, the name of a text one */
+bool read_matrix_dimensions(const char *filepath, int *nrow, int *ncol);
+
+/* Creates (or truncates) a binary matrix file holding just the header for nrow x ncol */
+bool create_binary_matrix_file(const char *filepath, int nrow, int ncol);
+
+/* Reads a matrix of the given element type into one contiguous row-major
+ * array (release with free).
+ *
+ * Text files are named like the double ones. Float entries are written
+ * the same way, complex entries as re+imi or re-imi without spaces (a
+ * plain real number is accepted too). Binary files start with the magic
+ * "MATBINF1" for float and "MATBINZ1" for complex entries. A double file
+ * can be read as float or complex, other conversions are refused.
+ *
+ * Returns true on success, false on failure.
+ */
+bool read_matrix_typed(const char *filepath, enum scalar_type type, int *nrow, int *ncol, void **mat);
+
+/* Writes a contiguous matrix of the given element type, binary if filepath ends in .bin */
+bool write_matrix_typed(const char *filepath, enum scalar_type type, int nrow, int ncol, const void *mat);
+
+/* The input of a typed inversion of the drivers as one contiguous n x n
+ * array of opts->precision (release with free): generated with -generate=,
+ * read with read_matrix_typed from -path= otherwise. Returns NULL with *n
+ * set to 0 (after printing why) on failure or if the matrix is not square.
+ */
+struct cli_options;
+void *load_typed_input_matrix(const struct cli_options *opts, int *n);
+
 #endif /* FILE_READER_H */
@@ -0,0 +1,475 @@
+/*
+ * @file matrix_gen.c
+ * @brief Counter-based, multithreaded generation of structured test matrices
+ */
+
+#include "matrix_gen.h"
+
+#include <complex.h> /* double complex, cexp, I */
+#include <math.h>    /* fabs, pow, sqrt */
+#include <stdio.h>   /* perror */
+#include <stdlib.h>  /* malloc, strtod, strtol, strtoull, abs */
+#include <string.h>  /* strcmp, strncmp, strchr, memset */
+
+#define DEFAULT_SPD_COND 1e2
+#define DEFAULT_CONDITIONED_COND 1e6
+#define DEFAULT_BLOCK_SIZE 64
+#define DEFAULT_HALF_BANDWIDTH 8
+#define PI 3.14159265358979323846
+
+/* Independent streams of the counter-based generator */
+enum gen_stream
+{
+    STREAM_ENTRIES,
+    STREAM_U,
+    STREAM_V,
+    STREAM_SPECTRUM,
+    STREAM_PHASE
+};
+
+static const char *kind_names[MATRIX_KIND_COUNT] = {
+    [MATRIX_UNIFORM] = "uniform",
+    [MATRIX_DOMINANT] = "dominant",
+    [MATRIX_SPD] = "spd",
+    [MATRIX_CONDITIONED] = "cond",
+    [MATRIX_BLOCKS] = "blocks",
+    [MATRIX_BANDED] = "band",
+    [MATRIX_TOEPLITZ] = "toeplitz",
+    [MATRIX_CIRCULANT] = "circulant",
+};
+
+/* Vectors of the Householder construction, A = (I - 2uu^T)·D·(I - 2vv^T) */
+struct gen_state
+{
+    const struct matrix_spec *spec;
+    double *u;
+    double *v;
+    double *d;
+    double *du; /* d[j]·u[j] */
+    double s;   /* sum of d[k]·u[k]·v[k] */
+    int64_t perm_a, perm_a_inv, perm_c; /* MATRIX_BLOCKS: i -> (a·i + c) mod n and its inverse */
+    double diagonal;                    /* MATRIX_TOEPLITZ and MATRIX_CIRCULANT: 1 + sum of the other |t(k)| */
+};
+
+const char *matrix_kind_name(enum matrix_kind kind)
+{
+    return (kind >= 0 && kind < MATRIX_KIND_COUNT) ? kind_names[kind] : "unknown";
+}
+
+bool parse_matrix_kind(const char *text, struct matrix_spec *spec)
+{
+    const char *eq = strchr(text, '=');
+    size_t len = eq ? (size_t)(eq - text) : strlen(text);
+
+    for (int k = 0; k < MATRIX_KIND_COUNT; k++)
+    {
+        if (strlen(kind_names[k]) == len && strncmp(text, kind_names[k], len) == 0)
+        {
+            spec->kind = (enum matrix_kind)k;
+            spec->cond = k == MATRIX_SPD ? DEFAULT_SPD_COND : DEFAULT_CONDITIONED_COND;
+            spec->width = k == MATRIX_BLOCKS ? DEFAULT_BLOCK_SIZE : DEFAULT_HALF_BANDWIDTH;
+            if (!eq)
+            {
+                return true;
+            }
+            if (k == MATRIX_SPD || k == MATRIX_CONDITIONED)
+            {
+                spec->cond = strtod(eq + 1, NULL);
+                return spec->cond >= 1.0;
+            }
+            if (k == MATRIX_BLOCKS || k == MATRIX_BANDED)
+            {
+                long width = strtol(eq + 1, NULL, 10);
+                spec->width = (int)width;
+                return width >= (k == MATRIX_BLOCKS) && width <= 1000000;
+            }
+            return false;
+        }
+    }
+    return false;
+}
+
+bool parse_matrix_spec(const char *text, struct matrix_spec *spec)
+{
+    char *end;
+    long n = strtol(text, &end, 10);
+    if (end == text || *end != ',' || n < 1 || n > 1000000)
+    {
+        return false;
+    }
+
+    const char *seed_text = end + 1;
+    unsigned long long seed = strtoull(seed_text, &end, 10);
+    if (end == seed_text || *end != ',')
+    {
+        return false;
+    }
+
+    spec->n = (int)n;
+    spec->seed = seed;
+    return parse_matrix_kind(end + 1, spec);
+}
+
+/* SplitMix64 finalizer */
+static uint64_t mix64(uint64_t z)
+{
+    z += 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Uniform in [-1, 1), a pure function of its arguments */
+static double counter_uniform(uint64_t seed, enum gen_stream stream, uint64_t index)
+{
+    uint64_t z = mix64(seed ^ mix64(((uint64_t)stream << 56) ^ index));
+    return (double)(z >> 11) * 0x1.0p-52 - 1.0;
+}
+
+static void random_unit_vector(uint64_t seed, enum gen_stream stream, int n, double *x)
+{
+    double norm = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        x[i] = counter_uniform(seed, stream, i);
+        norm += x[i] * x[i];
+    }
+    norm = sqrt(norm);
+    for (int i = 0; i < n; i++)
+    {
+        x[i] /= norm;
+    }
+}
+
+static int64_t gcd64(int64_t a, int64_t b)
+{
+    while (b != 0)
+    {
+        int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+/* Inverse of a modulo n for gcd(a, n) = 1, by the extended Euclidean algorithm */
+static int64_t inverse_mod(int64_t a, int64_t n)
+{
+    int64_t r0 = n, r1 = a, t0 = 0, t1 = 1;
+    while (r1 != 0)
+    {
+        int64_t q = r0 / r1, tmp;
+        tmp = r0 - q * r1;
+        r0 = r1;
+        r1 = tmp;
+        tmp = t0 - q * t1;
+        t0 = t1;
+        t1 = tmp;
+    }
+    return ((t0 % n) + n) % n;
+}
+
+static void free_gen_state(struct gen_state *st)
+{
+    free(st->u);
+}
+
+static bool init_gen_state(struct gen_state *st, const struct matrix_spec *spec)
+{
+    int n = spec->n;
+    st->spec = spec;
+    st->u = st->v = st->d = st->du = NULL;
+    st->s = 0.0;
+    if (spec->kind == MATRIX_BLOCKS)
+    {
+        /* A multiplier coprime with n makes the affine map a permutation */
+        st->perm_a = n > 1 ? (int64_t)(mix64(spec->seed ^ 0xB10C) % n) | 1 : 1;
+        while (gcd64(st->perm_a, n) != 1)
+        {
+            st->perm_a = (st->perm_a + 2) % n;
+        }
+        st->perm_a_inv = inverse_mod(st->perm_a, n);
+        st->perm_c = (int64_t)(mix64(spec->seed ^ 0xC0FF) % n);
+        return true;
+    }
+    if (spec->kind == MATRIX_TOEPLITZ || spec->kind == MATRIX_CIRCULANT)
+    {
+        /* Every row holds at most all of the off-diagonal t(k) once */
+        st->diagonal = 1.0;
+        for (int k = -(n - 1); k < n; k++)
+        {
+            bool used = k != 0 && (spec->kind == MATRIX_TOEPLITZ || k > 0);
+            st->diagonal += used ? fabs(counter_uniform(spec->seed, STREAM_ENTRIES, (uint64_t)(k + n - 1))) : 0.0;
+        }
+        return true;
+    }
+    if (spec->kind != MATRIX_SPD && spec->kind != MATRIX_CONDITIONED)
+    {
+        return true;
+    }
+
+    st->u = malloc(4 * (size_t)n * sizeof(double));
+    if (!st->u)
+    {
+        perror("malloc (generator vectors)");
+        return false;
+    }
+    st->v = st->u + n;
+    st->d = st->u + 2 * n;
+    st->du = st->u + 3 * n;
+
+    random_unit_vector(spec->seed, STREAM_U, n, st->u);
+    if (spec->kind == MATRIX_SPD)
+    {
+        /* The same reflection on both sides keeps the matrix symmetric */
+        memcpy(st->v, st->u, n * sizeof(double));
+    }
+    else
+    {
+        random_unit_vector(spec->seed, STREAM_V, n, st->v);
+    }
+
+    /* Spectrum log-uniform in [1/cond, 1], with both ends present so the condition number is exact */
+    for (int i = 0; i < n; i++)
+    {
+        double t = i == 0 ? 0.0 : (i == 1 ? 1.0 : 0.5 * (counter_uniform(spec->seed, STREAM_SPECTRUM, i) + 1.0));
+        st->d[i] = pow(spec->cond, -t);
+        st->du[i] = st->d[i] * st->u[i];
+        st->s += st->du[i] * st->v[i];
+    }
+    return true;
+}
+
+static void generate_row(const struct gen_state *st, int i, double *row)
+{
+    const struct matrix_spec *spec = st->spec;
+    int n = spec->n;
+    uint64_t base = (uint64_t)i * n;
+
+    switch (spec->kind)
+    {
+    case MATRIX_UNIFORM:
+        for (int j = 0; j < n; j++)
+        {
+            row[j] = 50.0 * (counter_uniform(spec->seed, STREAM_ENTRIES, base + j) + 1.0);
+        }
+        break;
+    case MATRIX_DOMINANT:
+    {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            row[j] = counter_uniform(spec->seed, STREAM_ENTRIES, base + j);
+            sum += j == i ? 0.0 : fabs(row[j]);
+        }
+        row[i] = sum + 1.0;
+        break;
+    }
+    case MATRIX_BANDED:
+    {
+        int w = spec->width;
+        double sum = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            row[j] = j != i && abs(j - i) <= w ? counter_uniform(spec->seed, STREAM_ENTRIES, base + j) : 0.0;
+            sum += fabs(row[j]);
+        }
+        row[i] = sum + 1.0;
+        break;
+    }
+    case MATRIX_BLOCKS:
+    {
+        /* Row i is row u of the block-diagonal matrix, its entry (u, v) lands in column a·v + c */
+        int64_t u = (st->perm_a_inv * ((i - st->perm_c + n) % n)) % n;
+        int64_t b0 = u / spec->width * spec->width, b1 = b0 + spec->width < n ? b0 + spec->width : n;
+        double sum = 0.0;
+        memset(row, 0, n * sizeof(double));
+        for (int64_t v = b0; v < b1; v++)
+        {
+            if (v != u)
+            {
+                double x = counter_uniform(spec->seed, STREAM_ENTRIES, (uint64_t)u * n + v);
+                row[(st->perm_a * v + st->perm_c) % n] = x;
+                sum += fabs(x);
+            }
+        }
+        row[i] = sum + 1.0;
+        break;
+    }
+    case MATRIX_TOEPLITZ:
+    case MATRIX_CIRCULANT:
+    {
+        /* Entry (i, j) is t(i - j), taken modulo n for a circulant */
+        for (int j = 0; j < n; j++)
+        {
+            int k = i - j;
+            if (spec->kind == MATRIX_CIRCULANT && k < 0)
+            {
+                k += n;
+            }
+            row[j] = k == 0 ? st->diagonal : counter_uniform(spec->seed, STREAM_ENTRIES, (uint64_t)(k + n - 1));
+        }
+        break;
+    }
+    default:
+    {
+        /* Row i of D - 2u(D·u)^T - 2(D·v)v^T + 4s·uv^T */
+        double ui = st->u[i], dvi = st->d[i] * st->v[i];
+        for (int j = 0; j < n; j++)
+        {
+            row[j] = -2.0 * ui * st->du[j] - 2.0 * dvi * st->v[j] + 4.0 * st->s * ui * st->v[j];
+        }
+        row[i] += st->d[i];
+        break;
+    }
+    }
+}
+
+bool generate_matrix(const struct matrix_spec *spec, int n, double mat[n][n])
+{
+    struct gen_state st;
+    if (n != spec->n || !init_gen_state(&st, spec))
+    {
+        return false;
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++)
+    {
+        generate_row(&st, i, mat[i]);
+    }
+
+    free_gen_state(&st);
+    return true;
+}
+
+bool generate_matrix_block(const struct matrix_spec *spec, int row0, int nrows, double *rows)
+{
+    struct gen_state st;
+    if (row0 < 0 || row0 + nrows > spec->n || !init_gen_state(&st, spec))
+    {
+        return false;
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < nrows; i++)
+    {
+        generate_row(&st, row0 + i, rows + (size_t)i * spec->n);
+    }
+
+    free_gen_state(&st);
+    return true;
+}
+
+bool generate_matrix_rows(const struct matrix_spec *spec, double ***mat)
+{
+    int n = spec->n;
+    struct gen_state st;
+    if (!init_gen_state(&st, spec))
+    {
+        return false;
+    }
+
+    double **rows = malloc(n * sizeof(double *));
+    if (!rows)
+    {
+        perror("malloc (matrix rows)");
+        free_gen_state(&st);
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 0; i < n; i++)
+    {
+        rows[i] = malloc(n * sizeof(double));
+        if (!rows[i])
+        {
+            perror("malloc (matrix columns)");
+            for (int r = 0; r < i; r++)
+            {
+                free(rows[r]);
+            }
+            free(rows);
+            ok = false;
+            break;
+        }
+    }
+
+    if (ok)
+    {
+        /* Each thread fills (and so first touches) its own rows */
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++)
+        {
+            generate_row(&st, i, rows[i]);
+        }
+        *mat = rows;
+    }
+
+    free_gen_state(&st);
+    return ok;
+}
+
+bool generate_matrix_typed(const struct matrix_spec *spec, enum scalar_type type, void *mat)
+{
+    int n = spec->n;
+    if (type == SCALAR_DOUBLE)
+    {
+        return generate_matrix(spec, n, mat);
+    }
+
+    struct gen_state st;
+    if (!init_gen_state(&st, spec))
+    {
+        return false;
+    }
+
+    bool failed = false;
+#pragma omp parallel
+    {
+        double *row = malloc(n * sizeof(double));
+        if (!row)
+        {
+#pragma omp atomic write
+            failed = true;
+        }
+
+#pragma omp for schedule(static)
+        for (int i = 0; i < n; i++)
+        {
+            if (!row)
+            {
+                continue;
+            }
+            generate_row(&st, i, row);
+
+            if (type == SCALAR_FLOAT)
+            {
+                float *out = (float *)mat + (size_t)i * n;
+                for (int j = 0; j < n; j++)
+                {
+                    out[j] = (float)row[j];
+                }
+            }
+            else
+            {
+                /* diag(e^{i·a})·A·diag(e^{i·b}) with phases in [-pi, pi) */
+                double complex *out = (double complex *)mat + (size_t)i * n;
+                double a = PI * counter_uniform(spec->seed, STREAM_PHASE, i);
+                for (int j = 0; j < n; j++)
+                {
+                    double b = PI * counter_uniform(spec->seed, STREAM_PHASE, (uint64_t)n + j);
+                    out[j] = row[j] * cexp(I * (a + b));
+                }
+            }
+        }
+        free(row);
+    }
+
+    free_gen_state(&st);
+    if (failed)
+    {
+        perror("malloc (generator row)");
+    }
+    return !failed;
+}
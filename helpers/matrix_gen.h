@@ -0,0 +1,82 @@
+#ifndef MATRIX_GEN_H
+#define MATRIX_GEN_H
+
+#include <stdbool.h> /* bool */
+#include <stdint.h>  /* uint64_t */
+
+#include "scalar.h"
+
+/* Reproducible test matrices with known properties.
+ *
+ * Every entry is a pure function of (seed, row, column) through a
+ * counter-based generator, so the rows can be filled by any number of
+ * threads (or ranks) and the result never depends on the thread count.
+ *
+ * MATRIX_UNIFORM      Entries uniform in [0, 100), like the old generator.
+ * MATRIX_DOMINANT     Strictly diagonally dominant, hence invertible
+ *                     without pivoting.
+ * MATRIX_SPD          H·D·H with a Householder reflection H and positive
+ *                     eigenvalues D in [1/cond, 1]: symmetric positive
+ *                     definite with 2-norm condition number cond.
+ * MATRIX_CONDITIONED  H1·D·H2 with two Householder reflections and singular
+ *                     values in [1/cond, 1]: 2-norm condition number cond.
+ * MATRIX_BLOCKS       Diagonally dominant blocks of width rows on the
+ *                     diagonal, with rows and columns shuffled by the same
+ *                     affine permutation i -> (a·i + c) mod n.
+ * MATRIX_BANDED       Diagonally dominant with nonzeros only within width
+ *                     of the diagonal.
+ * MATRIX_TOEPLITZ     Diagonally dominant and constant along each diagonal.
+ * MATRIX_CIRCULANT    Diagonally dominant Toeplitz whose diagonals wrap
+ *                     around: each row is the one above shifted right.
+ *
+ * The reflections make each entry computable in O(1) from three length-n
+ * vectors, so even a 20000 x 20000 matrix takes O(n^2) work to build.
+ *
+ * Float matrices are the double ones rounded. Complex matrices are
+ * diag(e^{i·a})·A·diag(e^{i·b}) with random phases a and b: every entry is
+ * complex, while the magnitudes, the diagonal dominance and the singular
+ * values (so the condition number) of A are kept.
+ */
+enum matrix_kind
+{
+    MATRIX_UNIFORM,
+    MATRIX_DOMINANT,
+    MATRIX_SPD,
+    MATRIX_CONDITIONED,
+    MATRIX_BLOCKS,
+    MATRIX_BANDED,
+    MATRIX_TOEPLITZ,
+    MATRIX_CIRCULANT,
+    MATRIX_KIND_COUNT
+};
+
+struct matrix_spec
+{
+    int n;
+    uint64_t seed;
+    enum matrix_kind kind;
+    double cond; /* Condition number of MATRIX_SPD and MATRIX_CONDITIONED */
+    int width;   /* Block size of MATRIX_BLOCKS, half bandwidth of MATRIX_BANDED */
+};
+
+/* Parse "kind" or "kind=value" (e.g. "dominant", "spd", "cond=1e8", "blocks=100") into spec */
+bool parse_matrix_kind(const char *text, struct matrix_spec *spec);
+
+/* Parse "N,seed,kind[=value]" as given to -generate= */
+bool parse_matrix_spec(const char *text, struct matrix_spec *spec);
+
+const char *matrix_kind_name(enum matrix_kind kind);
+
+/* Fill the n x n matrix mat (n == spec->n), the rows are generated in parallel */
+bool generate_matrix(const struct matrix_spec *spec, int n, double mat[n][n]);
+
+/* Fill rows row0 .. row0 + nrows - 1 of the matrix into rows (nrows x spec->n, row-major) */
+bool generate_matrix_block(const struct matrix_spec *spec, int row0, int nrows, double *rows);
+
+/* Allocate and fill spec->n rows the way read_matrix_from_file does, free with free_matrix */
+bool generate_matrix_rows(const struct matrix_spec *spec, double ***mat);
+
+/* Fill the contiguous n x n matrix mat of the given element type (n == spec->n) */
+bool generate_matrix_typed(const struct matrix_spec *spec, enum scalar_type type, void *mat);
+
+#endif /* MATRIX_GEN_H */
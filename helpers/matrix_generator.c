@@ -1,158 +1,205 @@
-#include <stdio.h>
-#include <stdlib.h>
-#include <time.h>
-#include <math.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-
-// Configuration for number of matrices for each size
-// Format: { {matrix_size, count}, ... }
-int matrix_config[][2] = {
-    {5, 1},
-    {8, 1},
-    {10, 1},
-    {11, 1},
-    {12, 1},
-    {13, 1},
-    {14, 1},
-    {15, 1}};
-
-int config_size = sizeof(matrix_config) / sizeof(matrix_config[0]);
-
-// Function to calculate the determinant of a matrix (recursive for general case)
-double determinant(double **matrix, int n)
+/*
+ * @file matrix_generator.c
+ * @brief Writes reproducible benchmark matrices to disk
+ *
+ * Usage: matrix_generator [-sizes=5,8,1000:3000:1000] [-count=1] [-kind=dominant]
+ *                         [-seed=1] [-format=text|binary] [-precision=double|float|complex]
+ *                         [-out=../performance_test_matrices]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>     /* errno, EEXIST */
+#include <stdbool.h>   /* bool */
+#include <stdio.h>     /* printf, snprintf, fprintf */
+#include <stdlib.h>    /* malloc, free, strtol, strtoull */
+#include <string.h>    /* strncmp, strcmp, strchr */
+#include <sys/stat.h>  /* mkdir */
+#include <sys/types.h> /* mode_t */
+
+#include "file_reader.h"
+#include "matrix_gen.h"
+#include "timer.h"
+
+#define MAX_SIZES 64
+#define DEFAULT_OUT_DIR "../performance_test_matrices"
+
+struct generator_options
 {
-    if (n == 1)
-    {
-        return matrix[0][0];
-    }
-
-    if (n == 2)
-    {
-        return matrix[0][0] * matrix[1][1] - matrix[0][1] * matrix[1][0];
-    }
-
-    double det = 0;
-    for (int p = 0; p < n; p++)
+    int sizes[MAX_SIZES];
+    int nsizes;
+    int count;
+    struct matrix_spec spec; /* kind, cond and base seed */
+    bool binary;
+    enum scalar_type precision;
+    const char *out_dir;
+};
+
+/* Parse comma separated sizes and start:end:step ranges into opts->sizes */
+static bool parse_sizes(const char *text, struct generator_options *opts)
+{
+    opts->nsizes = 0;
+    while (*text)
     {
-        double **submatrix = (double **)malloc((n - 1) * sizeof(double *));
-        for (int i = 0; i < n - 1; i++)
+        char *end;
+        long start = strtol(text, &end, 10), stop = start, step = 1;
+        if (end == text || start < 1)
         {
-            submatrix[i] = (double *)malloc((n - 1) * sizeof(double));
+            return false;
         }
-
-        for (int i = 1; i < n; i++)
+        if (*end == ':')
         {
-            int col_index = 0;
-            for (int j = 0; j < n; j++)
+            stop = strtol(end + 1, &end, 10);
+            if (*end != ':')
             {
-                if (j == p)
-                    continue;
-                submatrix[i - 1][col_index++] = matrix[i][j];
+                return false;
+            }
+            step = strtol(end + 1, &end, 10);
+            if (stop < start || step < 1)
+            {
+                return false;
             }
         }
-
-        det += (p % 2 == 0 ? 1 : -1) * matrix[0][p] * determinant(submatrix, n - 1);
-
-        for (int i = 0; i < n - 1; i++)
+        for (long n = start; n <= stop; n += step)
+        {
+            if (opts->nsizes == MAX_SIZES || n > 1000000)
+            {
+                return false;
+            }
+            opts->sizes[opts->nsizes++] = (int)n;
+        }
+        if (*end != ',' && *end != '\0')
         {
-            free(submatrix[i]);
+            return false;
         }
-        free(submatrix);
+        text = *end ? end + 1 : end;
     }
-
-    return det;
+    return opts->nsizes > 0;
 }
 
-// Function to save the matrix to a file
-void save_matrix_to_file(double **matrix, int size, int index)
+static bool parse_generator_options(int argc, char *argv[], struct generator_options *opts)
 {
-    char folder_name[] = "../performance_test_matrices";
-    mkdir(folder_name, 0777); // Create the folder if it doesn't exist
-
-    char file_name[100];
-    sprintf(file_name, "%s/matrix_%dx%d_%02d.txt", folder_name, size, size, index);
-
-    FILE *file = fopen(file_name, "w");
-    if (file == NULL)
+    /* The sizes of the original generator */
+    static const int default_sizes[] = {5, 8, 10, 11, 12, 13, 14, 15};
+
+    opts->nsizes = sizeof(default_sizes) / sizeof(default_sizes[0]);
+    memcpy(opts->sizes, default_sizes, sizeof(default_sizes));
+    opts->count = 1;
+    opts->spec.seed = 1;
+    parse_matrix_kind("dominant", &opts->spec);
+    opts->binary = false;
+    opts->precision = SCALAR_DOUBLE;
+    opts->out_dir = DEFAULT_OUT_DIR;
+
+    for (int i = 1; i < argc; i++)
     {
-        perror("Error opening file");
-        return;
-    }
+        const char *arg = argv[i];
+        bool ok = true;
+        char *end;
+        if (strncmp(arg, "-sizes=", 7) == 0)
+        {
+            ok = parse_sizes(arg + 7, opts);
+        }
+        else if (strncmp(arg, "-count=", 7) == 0)
+        {
+            opts->count = (int)strtol(arg + 7, &end, 10);
+            ok = *end == '\0' && opts->count >= 1 && opts->count <= 99;
+        }
+        else if (strncmp(arg, "-kind=", 6) == 0)
+        {
+            ok = parse_matrix_kind(arg + 6, &opts->spec);
+        }
+        else if (strncmp(arg, "-seed=", 6) == 0)
+        {
+            opts->spec.seed = strtoull(arg + 6, &end, 10);
+            ok = end != arg + 6 && *end == '\0';
+        }
+        else if (strncmp(arg, "-format=", 8) == 0)
+        {
+            ok = strcmp(arg + 8, "text") == 0 || strcmp(arg + 8, "binary") == 0;
+            opts->binary = strcmp(arg + 8, "binary") == 0;
+        }
+        else if (strncmp(arg, "-precision=", 11) == 0)
+        {
+            ok = parse_scalar_type(arg + 11, &opts->precision);
+        }
+        else if (strncmp(arg, "-out=", 5) == 0)
+        {
+            opts->out_dir = arg + 5;
+            ok = *opts->out_dir != '\0';
+        }
+        else
+        {
+            ok = false;
+        }
 
-    for (int i = 0; i < size; i++)
-    {
-        for (int j = 0; j < size; j++)
+        if (!ok)
         {
-            fprintf(file, "%.2f ", matrix[i][j]);
+            fprintf(stderr, "Invalid argument: %s\n", arg);
+            fprintf(stderr, "Usage: %s [-sizes=<list>] [-count=<n>] [-kind=uniform|dominant|spd[=cond]|cond[=cond]|blocks[=size]|band[=width]|toeplitz|circulant] "
+                            "[-seed=<n>] [-format=text|binary] [-precision=double|float|complex] [-out=<directory>]\n",
+                    argv[0]);
+            return false;
         }
-        fprintf(file, "\n");
     }
-
-    fclose(file);
+    return true;
 }
 
-// Function to generate a random matrix and ensure it is invertible
-void generate_invertible_matrix(int size, int min_value, int max_value, int num_matrices)
+/* Generate and save one matrix, matrix_<n>x<n>_<index>.{txt,bin} */
+static bool generate_to_file(const struct generator_options *opts, int n, int index)
 {
-    double **matrix;
-    matrix = (double **)malloc(size * sizeof(double *));
-    for (int i = 0; i < size; i++)
-    {
-        matrix[i] = (double *)malloc(size * sizeof(double));
-    }
+    struct matrix_spec spec = opts->spec;
+    spec.n = n;
+    spec.seed = opts->spec.seed + (uint64_t)index - 1; /* Distinct, reproducible matrices per index */
 
-    for (int idx = 1; idx <= num_matrices; idx++)
+    void *mat = malloc((size_t)n * n * scalar_size(opts->precision));
+    if (!mat)
     {
-        int retries = 0;
-        while (1)
-        {
-            retries++;
-            if (retries > 1000)
-            {
-                fprintf(stderr, "Failed to generate an invertible matrix of size %d after 1000 attempts.\n", size);
-                return;
-            }
-
-            // Fill the matrix with random values
-            for (int i = 0; i < size; i++)
-            {
-                for (int j = 0; j < size; j++)
-                {
-                    matrix[i][j] = (rand() % (max_value - min_value + 1)) + min_value;
-                }
-            }
-
-            float det = determinant(matrix, size);
+        perror("malloc (matrix)");
+        return false;
+    }
 
-            // Check if the matrix is invertible
-            if (fabs(det) > 1e-6)
-            {
-                break;
-            }
-        }
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/matrix_%dx%d_%02d.%s", opts->out_dir, n, n, index, opts->binary ? "bin" : "txt");
 
-        // Save the matrix to a file
-        save_matrix_to_file(matrix, size, idx);
-    }
+    double start = now_ms();
+    bool ok = generate_matrix_typed(&spec, opts->precision, mat);
+    double generated = now_ms();
+    ok = ok && write_matrix_typed(path, opts->precision, n, n, mat);
+    double written = now_ms();
 
-    // Free allocated memory
-    for (int i = 0; i < size; i++)
+    if (ok)
     {
-        free(matrix[i]);
+        printf("Generated %s (%s %s, seed %llu) in %.2f ms, written in %.2f ms.\n", path, scalar_type_name(opts->precision), matrix_kind_name(spec.kind),
+               (unsigned long long)spec.seed, generated - start, written - generated);
     }
-    free(matrix);
+    free(mat);
+    return ok;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    srand(time(0)); // Seed for random number generation
+    struct generator_options opts;
+    if (!parse_generator_options(argc, argv, &opts))
+    {
+        return 1;
+    }
 
-    for (int i = 0; i < config_size; i++)
+    if (mkdir(opts.out_dir, 0777) != 0 && errno != EEXIST) // Create the folder if it doesn't exist
     {
-        int size = matrix_config[i][0];
-        int count = matrix_config[i][1];
-        generate_invertible_matrix(size, 0, 100, count);
+        perror("Error creating output directory");
+        return 1;
+    }
+
+    for (int i = 0; i < opts.nsizes; i++)
+    {
+        for (int idx = 1; idx <= opts.count; idx++)
+        {
+            if (!generate_to_file(&opts, opts.sizes[i], idx))
+            {
+                return 1;
+            }
+        }
     }
     return 0;
 }
@@ -0,0 +1,238 @@
+/*
+ * @file placement.c
+ * @brief Huge page backed allocation and thread pinning for first-touch placement
+ */
+
+#define _GNU_SOURCE /* MAP_ANONYMOUS, MAP_HUGETLB, MADV_HUGEPAGE, sched_setaffinity */
+
+#include "placement.h"
+
+#include <omp.h>
+#include <sched.h>    /* sched_getaffinity, sched_setaffinity, CPU_* */
+#include <stdint.h>   /* uintptr_t */
+#include <stdio.h>    /* printf, fprintf */
+#include <string.h>   /* strcmp */
+#include <sys/mman.h> /* mmap, munmap, madvise */
+#include <unistd.h>   /* sysconf */
+
+/* The x86-64 and aarch64 (4K granule) huge page size */
+#define HUGE_PAGE_BYTES ((size_t)2 << 20)
+
+static enum huge_page_mode huge_pages = HUGE_PAGES_THP;
+static bool pin_enabled = false;
+static int fixed_chunk_rows = 0;
+
+bool parse_huge_page_mode(const char *text, enum huge_page_mode *mode)
+{
+    if (strcmp(text, "off") == 0)
+    {
+        *mode = HUGE_PAGES_OFF;
+    }
+    else if (strcmp(text, "thp") == 0)
+    {
+        *mode = HUGE_PAGES_THP;
+    }
+    else if (strcmp(text, "explicit") == 0)
+    {
+        *mode = HUGE_PAGES_EXPLICIT;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+void placement_set_huge_pages(enum huge_page_mode mode)
+{
+    huge_pages = mode;
+}
+
+void placement_set_pinning(bool pin)
+{
+    pin_enabled = pin;
+}
+
+static size_t round_up(size_t bytes, size_t page)
+{
+    return (bytes + page - 1) / page * page;
+}
+
+static void *map_anonymous(size_t bytes, int extra_flags)
+{
+    void *ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+    return ptr == MAP_FAILED ? NULL : ptr;
+}
+
+/* Huge page aligned mapping advised for transparent huge pages */
+static void *map_transparent_huge(size_t bytes)
+{
+    /* Over-allocate by one huge page and trim, mmap only guarantees base page alignment */
+    size_t mapped = bytes + HUGE_PAGE_BYTES;
+    char *raw = map_anonymous(mapped, 0);
+    if (!raw)
+    {
+        return NULL;
+    }
+
+    char *aligned = (char *)round_up((uintptr_t)raw, HUGE_PAGE_BYTES);
+    if (aligned > raw)
+    {
+        munmap(raw, aligned - raw);
+    }
+    if (raw + mapped > aligned + bytes)
+    {
+        munmap(aligned + bytes, raw + mapped - (aligned + bytes));
+    }
+
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+void *placement_alloc(size_t bytes, size_t *page_bytes)
+{
+    /* Below one huge page, base pages waste nothing and place at a finer grain */
+    if (huge_pages == HUGE_PAGES_OFF || bytes < HUGE_PAGE_BYTES)
+    {
+        *page_bytes = (size_t)sysconf(_SC_PAGESIZE);
+        return map_anonymous(round_up(bytes, *page_bytes), 0);
+    }
+
+    *page_bytes = HUGE_PAGE_BYTES;
+    bytes = round_up(bytes, HUGE_PAGE_BYTES);
+
+#ifdef MAP_HUGETLB
+    if (huge_pages == HUGE_PAGES_EXPLICIT)
+    {
+        void *ptr = map_anonymous(bytes, MAP_HUGETLB);
+        if (ptr)
+        {
+            return ptr;
+        }
+
+        static bool warned = false;
+        if (!warned)
+        {
+            fprintf(stderr, "Warning: no explicit huge pages available (see /proc/sys/vm/nr_hugepages), using transparent huge pages.\n");
+            warned = true;
+        }
+    }
+#endif
+    return map_transparent_huge(bytes);
+}
+
+void placement_free(void *ptr, size_t bytes, size_t page_bytes)
+{
+    if (ptr)
+    {
+        munmap(ptr, round_up(bytes, page_bytes));
+    }
+}
+
+void placement_set_chunk_rows(int rows)
+{
+    fixed_chunk_rows = rows > 0 ? rows : 0;
+}
+
+int placement_chunk_rows(size_t row_bytes, size_t page_bytes)
+{
+    if (fixed_chunk_rows > 0)
+    {
+        return fixed_chunk_rows;
+    }
+    return (int)((page_bytes + row_bytes - 1) / row_bytes);
+}
+
+#ifdef __linux__
+/* The mask the process started with, pinning narrows the master's own mask */
+static cpu_set_t allowed;
+static int ncpu = 0;
+
+/* Read the allowed CPUs once, false (pinning disabled) if they cannot be read */
+static bool load_allowed_cpus(void)
+{
+    bool ok = true;
+#pragma omp critical(placement_allowed_cpus)
+    {
+        if (ncpu == 0)
+        {
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+            {
+                perror("sched_getaffinity");
+                pin_enabled = false;
+                ok = false;
+            }
+            else
+            {
+                ncpu = CPU_COUNT(&allowed);
+                printf("Pinning OpenMP threads to %d CPUs.\n", ncpu);
+            }
+        }
+    }
+    return ok;
+}
+
+/* Pin the calling thread to the index-th allowed CPU. Linux numbers the first hardware thread of
+ * every core before the SMT siblings, so up to one thread per core this is one core per thread. */
+static void pin_to_allowed(int index)
+{
+    int target = index % ncpu;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+    {
+        if (CPU_ISSET(cpu, &allowed) && target-- == 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            sched_setaffinity(0, sizeof(set), &set);
+            break;
+        }
+    }
+}
+#endif
+
+void placement_pin_threads(void)
+{
+    /* An explicit OMP_PROC_BIND policy is already applied by the runtime */
+    if (!pin_enabled || omp_get_proc_bind() != omp_proc_bind_false)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    if (!load_allowed_cpus())
+    {
+        return;
+    }
+
+    /* Thread t on the t-th allowed CPU */
+#pragma omp parallel
+    {
+        pin_to_allowed(omp_get_thread_num());
+    }
+#endif
+}
+
+void placement_pin_team(const int *cores, int count)
+{
+    if (!pin_enabled || omp_get_proc_bind() != omp_proc_bind_false)
+    {
+        return;
+    }
+
+#ifdef __linux__
+    if (!load_allowed_cpus())
+    {
+        return;
+    }
+
+#pragma omp parallel num_threads(count)
+    {
+        pin_to_allowed(cores[omp_get_thread_num()]);
+    }
+#else
+    (void)cores, (void)count;
+#endif
+}
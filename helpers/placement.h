@@ -0,0 +1,62 @@
+#ifndef PLACEMENT_H
+#define PLACEMENT_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* size_t */
+
+/* Memory placement for the OpenMP engine on multi-socket nodes.
+ *
+ * Linux places a page on the NUMA node of the thread that first writes it.
+ * placement_alloc hands out untouched, page aligned memory, so the engine
+ * can initialize each block of rows on the thread that later updates it:
+ * the rows are split into chunks of placement_chunk_rows rows and dealt out
+ * with schedule(static, chunk) in every loop over them, which keeps the
+ * owner of a row fixed for the whole inversion. Large buffers are backed by
+ * huge pages to cut TLB misses, and the threads can be pinned to cores so
+ * the owner does not migrate away from its memory.
+ */
+enum huge_page_mode
+{
+    HUGE_PAGES_OFF,      /* Base pages only */
+    HUGE_PAGES_THP,      /* Transparent huge pages through madvise (default) */
+    HUGE_PAGES_EXPLICIT, /* Preallocated hugetlbfs pages, THP if none are left */
+};
+
+/* Parse "off", "thp" or "explicit" */
+bool parse_huge_page_mode(const char *text, enum huge_page_mode *mode);
+
+void placement_set_huge_pages(enum huge_page_mode mode);
+
+/* Pin every OpenMP thread to its own core at the start of each inversion */
+void placement_set_pinning(bool pin);
+
+/* Untouched, page aligned memory of at least bytes bytes, NULL on failure.
+ * page_bytes receives the page size that backs it.
+ */
+void *placement_alloc(size_t bytes, size_t *page_bytes);
+
+/* Release memory from placement_alloc, with the same bytes and the page_bytes it reported */
+void placement_free(void *ptr, size_t bytes, size_t page_bytes);
+
+/* Rows per ownership chunk: enough rows of row_bytes to fill a page of page_bytes,
+ * unless a fixed number of rows was set with placement_set_chunk_rows
+ */
+int placement_chunk_rows(size_t row_bytes, size_t page_bytes);
+
+/* Fixed rows per ownership chunk, e.g. from a tuning profile (0 restores the page-sized default).
+ * Chunks smaller than a page balance small matrices better but share pages between threads.
+ */
+void placement_set_chunk_rows(int rows);
+
+/* Pin the threads of the next parallel regions if enabled, thread t to the
+ * t-th CPU the process may run on. Leaves OMP_PROC_BIND to the runtime.
+ */
+void placement_pin_threads(void);
+
+/* Pin thread t of the next parallel regions of the calling thread to the
+ * cores[t]-th allowed CPU, for teams that share the node with other teams
+ * (see batch_pipeline.h). Does nothing unless pinning is enabled.
+ */
+void placement_pin_team(const int *cores, int count);
+
+#endif /* PLACEMENT_H */
@@ -0,0 +1,363 @@
+/*
+ * @file profiler.c
+ * @brief Low-overhead per-phase timers with optional hardware counters
+ *
+ * Every thread that records a phase gets its own cache-line aligned slot,
+ * so recording never takes a lock. The report aggregates the slots per
+ * phase and lists the per-thread times to expose load imbalance.
+ */
+
+#define _GNU_SOURCE /* syscall */
+
+#include "profiler.h"
+#include "timer.h"
+#include "tracer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#define PROF_MAX_THREADS 256
+#define PROF_COUNTERS 4
+
+enum prof_counter
+{
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_LLC_MISSES,
+    COUNTER_FP_OPS
+};
+
+static const char *phase_names[PHASE_COUNT] = {
+    [PHASE_READ] = "read",
+    [PHASE_AUGMENT] = "augment",
+    [PHASE_ELIMINATION] = "elimination",
+    [PHASE_RREF] = "rref",
+    [PHASE_EXTRACT] = "extract",
+    [PHASE_ROW_UPDATE] = "row updates",
+    [PHASE_MPI_COMM] = "mpi comm",
+    [PHASE_CONDITION] = "condition",
+    [PHASE_TILE_WAIT] = "tile wait",
+    [PHASE_PARTITION] = "partition",
+};
+
+struct prof_slot
+{
+    double ms[PHASE_COUNT];
+    long calls[PHASE_COUNT];
+    double flops[PHASE_COUNT];
+    double bytes[PHASE_COUNT];
+    unsigned long long counters[PHASE_COUNT][PROF_COUNTERS];
+    int perf_fd[PROF_COUNTERS]; /* perf_fd[0] is the group leader */
+    int ncounters;
+    bool perf_tried;
+} __attribute__((aligned(64)));
+
+static struct prof_slot prof_slots[PROF_MAX_THREADS];
+static int prof_nslots = 0;
+static bool prof_on = false;
+
+bool prof_enabled(void)
+{
+    return prof_on;
+}
+
+void prof_reset(void)
+{
+    for (int s = 0; s < prof_nslots; s++)
+    {
+        struct prof_slot *slot = &prof_slots[s];
+        memset(slot->ms, 0, sizeof(slot->ms));
+        memset(slot->calls, 0, sizeof(slot->calls));
+        memset(slot->flops, 0, sizeof(slot->flops));
+        memset(slot->bytes, 0, sizeof(slot->bytes));
+        memset(slot->counters, 0, sizeof(slot->counters));
+    }
+}
+
+#ifdef ENABLE_PROFILING
+
+/* Trace-event category of each phase */
+static const char *phase_categories[PHASE_COUNT] = {
+    [PHASE_READ] = "io",
+    [PHASE_AUGMENT] = "compute",
+    [PHASE_ELIMINATION] = "compute",
+    [PHASE_RREF] = "compute",
+    [PHASE_EXTRACT] = "compute",
+    [PHASE_ROW_UPDATE] = "compute",
+    [PHASE_MPI_COMM] = "comm",
+    [PHASE_CONDITION] = "compute",
+    [PHASE_TILE_WAIT] = "io",
+    [PHASE_PARTITION] = "compute",
+};
+
+static bool prof_hw = false;
+static __thread struct prof_slot *my_slot = NULL;
+
+bool prof_enable(bool hw_counters)
+{
+    prof_on = true;
+    prof_hw = hw_counters;
+    return true;
+}
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config, int group_fd)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = (group_fd == -1);
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+
+    /* Count the calling thread on whatever CPU it runs */
+    return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+#endif
+
+/* Open the counter group of the calling thread, failures just disable the counters */
+static void open_thread_counters(struct prof_slot *slot)
+{
+    slot->perf_tried = true;
+    slot->ncounters = 0;
+
+#ifdef __linux__
+    int leader = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, -1);
+    if (leader < 0)
+    {
+        if (slot == &prof_slots[0])
+        {
+            perror("perf_event_open (hardware counters disabled)");
+        }
+        return;
+    }
+    slot->perf_fd[COUNTER_CYCLES] = leader;
+    slot->perf_fd[COUNTER_INSTRUCTIONS] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, leader);
+    slot->perf_fd[COUNTER_LLC_MISSES] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader);
+
+    /* FLOP events are model specific, e.g. 0x01c7 for scalar double FP_ARITH_INST_RETIRED on Intel */
+    const char *fp_event = getenv("MATINV_PERF_FP_EVENT");
+    slot->perf_fd[COUNTER_FP_OPS] = fp_event ? open_counter(PERF_TYPE_RAW, strtoull(fp_event, NULL, 0), leader) : -1;
+
+    if (slot->perf_fd[COUNTER_INSTRUCTIONS] < 0 || slot->perf_fd[COUNTER_LLC_MISSES] < 0)
+    {
+        for (int c = 0; c < PROF_COUNTERS; c++)
+        {
+            if (slot->perf_fd[c] >= 0)
+            {
+                close(slot->perf_fd[c]);
+            }
+        }
+        return;
+    }
+
+    slot->ncounters = slot->perf_fd[COUNTER_FP_OPS] >= 0 ? 4 : 3;
+    ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+static void read_counters(struct prof_slot *slot, unsigned long long values[PROF_COUNTERS])
+{
+    memset(values, 0, PROF_COUNTERS * sizeof(values[0]));
+#ifdef __linux__
+    if (slot->ncounters > 0)
+    {
+        unsigned long long buf[1 + PROF_COUNTERS];
+        if (read(slot->perf_fd[0], buf, sizeof(buf)) > 0)
+        {
+            for (unsigned long long c = 0; c < buf[0] && c < PROF_COUNTERS; c++)
+            {
+                values[c] = buf[1 + c];
+            }
+        }
+    }
+#endif
+}
+
+/* Slot of the calling thread, registered on first use */
+static struct prof_slot *thread_slot(void)
+{
+    if (!my_slot)
+    {
+        int id = __sync_fetch_and_add(&prof_nslots, 1);
+        if (id >= PROF_MAX_THREADS)
+        {
+            /* Out of slots, extra threads share the last one */
+            prof_nslots = PROF_MAX_THREADS;
+            id = PROF_MAX_THREADS - 1;
+        }
+        my_slot = &prof_slots[id];
+    }
+
+    if (prof_hw && !my_slot->perf_tried)
+    {
+        open_thread_counters(my_slot);
+    }
+    return my_slot;
+}
+
+struct prof_scope prof_begin(void)
+{
+    struct prof_scope scope;
+    scope.active = prof_on || trace_enabled();
+    if (prof_on)
+    {
+        read_counters(thread_slot(), scope.counters);
+    }
+    if (scope.active)
+    {
+        scope.start = now_ms();
+    }
+    return scope;
+}
+
+void prof_end(enum prof_phase phase, struct prof_scope *scope)
+{
+    if (!scope->active)
+    {
+        return;
+    }
+
+    double end = now_ms();
+    trace_record(phase_names[phase], phase_categories[phase], scope->start, end);
+    if (!prof_on)
+    {
+        return;
+    }
+
+    struct prof_slot *slot = thread_slot();
+    unsigned long long values[PROF_COUNTERS];
+    read_counters(slot, values);
+
+    slot->ms[phase] += end - scope->start;
+    slot->calls[phase]++;
+    for (int c = 0; c < PROF_COUNTERS; c++)
+    {
+        slot->counters[phase][c] += values[c] - scope->counters[c];
+    }
+}
+
+void prof_add_work(enum prof_phase phase, double flops, double bytes)
+{
+    if (prof_on)
+    {
+        struct prof_slot *slot = thread_slot();
+        slot->flops[phase] += flops;
+        slot->bytes[phase] += bytes;
+    }
+}
+
+#else
+
+bool prof_enable(bool hw_counters)
+{
+    (void)hw_counters;
+    fprintf(stderr, "Warning: profiling support not compiled in, rebuild with -DENABLE_PROFILING.\n");
+    return false;
+}
+
+#endif /* ENABLE_PROFILING */
+
+void prof_report(FILE *fp, const char *label)
+{
+    if (!prof_on)
+    {
+        return;
+    }
+
+    int nslots = prof_nslots < PROF_MAX_THREADS ? prof_nslots : PROF_MAX_THREADS;
+    fprintf(fp, "\n********** Phase breakdown (%s) **********\n", label);
+
+    for (int p = 0; p < PHASE_COUNT; p++)
+    {
+        double total = 0.0, wall = 0.0, flops = 0.0, bytes = 0.0;
+        unsigned long long counters[PROF_COUNTERS] = {0};
+        long calls = 0;
+        int threads = 0;
+        bool have_counters = false;
+
+        for (int s = 0; s < nslots; s++)
+        {
+            struct prof_slot *slot = &prof_slots[s];
+            flops += slot->flops[p];
+            bytes += slot->bytes[p];
+            if (slot->calls[p] == 0)
+            {
+                continue;
+            }
+
+            threads++;
+            calls += slot->calls[p];
+            total += slot->ms[p];
+            wall = slot->ms[p] > wall ? slot->ms[p] : wall;
+            have_counters |= slot->ncounters > 0;
+            for (int c = 0; c < PROF_COUNTERS; c++)
+            {
+                counters[c] += slot->counters[p][c];
+            }
+        }
+
+        if (calls == 0)
+        {
+            continue;
+        }
+
+        fprintf(fp, "%-12s %9ld calls %12.3f ms", phase_names[p], calls, wall);
+        if (threads > 1)
+        {
+            fprintf(fp, " (max over %d threads, sum %.3f ms)", threads, total);
+        }
+        fprintf(fp, "\n");
+
+        if (flops > 0.0)
+        {
+            /* flops per millisecond / 1e6 = GFLOP/s */
+            fprintf(fp, "%-12s %.3f GFLOP/s, model intensity %.3f flop/byte\n", "", flops / wall / 1e6, flops / bytes);
+        }
+
+        if (have_counters)
+        {
+            fprintf(fp, "%-12s cycles %llu, instructions %llu (IPC %.2f), LLC misses %llu",
+                    "", counters[COUNTER_CYCLES], counters[COUNTER_INSTRUCTIONS],
+                    counters[COUNTER_CYCLES] ? (double)counters[COUNTER_INSTRUCTIONS] / counters[COUNTER_CYCLES] : 0.0,
+                    counters[COUNTER_LLC_MISSES]);
+            if (counters[COUNTER_LLC_MISSES] > 0 && flops > 0.0)
+            {
+                /* 64-byte lines fetched from memory */
+                fprintf(fp, ", measured intensity %.3f flop/byte", flops / (64.0 * counters[COUNTER_LLC_MISSES]));
+            }
+            if (counters[COUNTER_FP_OPS] > 0)
+            {
+                fprintf(fp, ", FP events %llu", counters[COUNTER_FP_OPS]);
+            }
+            fprintf(fp, "\n");
+        }
+
+        if (threads > 1)
+        {
+            fprintf(fp, "%-12s per thread:", "");
+            for (int s = 0; s < nslots; s++)
+            {
+                if (prof_slots[s].calls[p] > 0)
+                {
+                    fprintf(fp, " %.3f", prof_slots[s].ms[p]);
+                }
+            }
+            fprintf(fp, " ms\n");
+        }
+    }
+    fflush(fp);
+}
@@ -0,0 +1,73 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h> /* bool */
+#include <stdio.h>   /* FILE */
+
+/* Phases of an inversion that can be timed */
+enum prof_phase
+{
+    PHASE_READ,        /* Reading and parsing the input file */
+    PHASE_AUGMENT,     /* Building the n x 2n augmented matrix */
+    PHASE_ELIMINATION, /* Forward elimination */
+    PHASE_RREF,        /* Backward elimination to reduced row echelon form */
+    PHASE_EXTRACT,     /* Copying the inverse out of the augmented matrix */
+    PHASE_ROW_UPDATE,  /* Per-thread row updates inside the parallel loops */
+    PHASE_MPI_COMM,    /* MPI collectives */
+    PHASE_CONDITION,   /* Condition number estimate */
+    PHASE_TILE_WAIT,   /* Out-of-core engine waiting for tile reads and writes, streaming engine for rows */
+    PHASE_PARTITION,   /* Finding the independent diagonal blocks (or the structure) and gathering and scattering them */
+    PHASE_COUNT
+};
+
+/* Scoped phase timers.
+ *
+ * PROF_BEGIN(phase) ... PROF_END(phase) accumulates the elapsed time (and
+ * the hardware counters, if enabled) of the enclosed code into the calling
+ * thread's slot. PROF_WORK(phase, flops, bytes) records the nominal work of
+ * a phase so the report can show achieved FLOP/s and arithmetic intensity.
+ *
+ * The macros compile to nothing unless ENABLE_PROFILING is defined, and
+ * cost a single branch when profiling is compiled in but not enabled.
+ */
+#ifdef ENABLE_PROFILING
+
+struct prof_scope
+{
+    double start;
+    unsigned long long counters[4];
+    bool active;
+};
+
+#define PROF_BEGIN(phase) struct prof_scope prof_scope_##phase = prof_begin()
+#define PROF_END(phase) prof_end(phase, &prof_scope_##phase)
+#define PROF_WORK(phase, flops, bytes) prof_add_work(phase, flops, bytes)
+
+struct prof_scope prof_begin(void);
+void prof_end(enum prof_phase phase, struct prof_scope *scope);
+void prof_add_work(enum prof_phase phase, double flops, double bytes);
+
+#else
+
+#define PROF_BEGIN(phase) ((void)0)
+#define PROF_END(phase) ((void)0)
+#define PROF_WORK(phase, flops, bytes) ((void)0)
+
+#endif /* ENABLE_PROFILING */
+
+/* Turn profiling on at run time. With hw_counters, cycles, instructions,
+ * LLC misses and (if MATINV_PERF_FP_EVENT holds a raw event code) FLOP
+ * events are read through perf_event_open. Returns false if profiling
+ * was not compiled in.
+ */
+bool prof_enable(bool hw_counters);
+
+bool prof_enabled(void);
+
+/* Forget everything recorded so far */
+void prof_reset(void);
+
+/* Print the phase breakdown, label identifies the process (e.g. "rank 3") */
+void prof_report(FILE *fp, const char *label);
+
+#endif /* PROFILER_H */
@@ -0,0 +1,51 @@
+/*
+ * @file scalar.c
+ * @brief Names and sizes of the matrix element types
+ */
+
+#include "scalar.h"
+
+#include <complex.h> /* double complex */
+#include <string.h>  /* strcmp */
+
+static const char *scalar_names[SCALAR_TYPE_COUNT] = {
+    [SCALAR_FLOAT] = "float",
+    [SCALAR_DOUBLE] = "double",
+    [SCALAR_COMPLEX] = "complex",
+};
+
+bool parse_scalar_type(const char *name, enum scalar_type *type)
+{
+    for (int t = 0; t < SCALAR_TYPE_COUNT; t++)
+    {
+        if (strcmp(name, scalar_names[t]) == 0)
+        {
+            *type = (enum scalar_type)t;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *scalar_type_name(enum scalar_type type)
+{
+    return (type >= 0 && type < SCALAR_TYPE_COUNT) ? scalar_names[type] : "unknown";
+}
+
+size_t scalar_size(enum scalar_type type)
+{
+    switch (type)
+    {
+    case SCALAR_FLOAT:
+        return sizeof(float);
+    case SCALAR_COMPLEX:
+        return sizeof(double complex);
+    default:
+        return sizeof(double);
+    }
+}
+
+double scalar_flop_factor(enum scalar_type type)
+{
+    return type == SCALAR_COMPLEX ? 4.0 : 1.0;
+}
@@ -0,0 +1,39 @@
+#ifndef SCALAR_H
+#define SCALAR_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* size_t */
+
+/* Element types of the matrices.
+ *
+ * SCALAR_DOUBLE is the native type of every engine. SCALAR_FLOAT halves
+ * the bytes moved (and doubles the SIMD lanes) where single precision is
+ * accurate enough, SCALAR_COMPLEX (double complex) covers signal-processing
+ * matrices. The float and complex kernels are generated from one source,
+ * see scalar_template.h.
+ */
+enum scalar_type
+{
+    SCALAR_FLOAT,
+    SCALAR_DOUBLE,
+    SCALAR_COMPLEX,
+    SCALAR_TYPE_COUNT
+};
+
+/* The same types for the preprocessor, set SCALAR_KIND to one of them before including a template */
+#define SCALAR_KIND_FLOAT 1
+#define SCALAR_KIND_DOUBLE 2
+#define SCALAR_KIND_COMPLEX 3
+
+/* Parse "float", "double" or "complex", returns false for anything else */
+bool parse_scalar_type(const char *name, enum scalar_type *type);
+
+const char *scalar_type_name(enum scalar_type type);
+
+/* Bytes per element */
+size_t scalar_size(enum scalar_type type);
+
+/* Real flops per nominal flop: a complex multiply-add costs four real ones */
+double scalar_flop_factor(enum scalar_type type);
+
+#endif /* SCALAR_H */
@@ -0,0 +1,84 @@
+/* Per-type definitions of the type-generic templates.
+ *
+ * A template is instantiated by defining SCALAR_KIND (see scalar.h) and
+ * including it, the template includes this file first. No include guard:
+ * every inclusion replaces the definitions of the previous one.
+ *
+ * SCALAR          Element type.
+ * REAL            Real type of magnitudes and norms.
+ * WIDE            Accumulator of residual checks (double, double complex).
+ * TYPED(name)     name_f, name_d or name_z.
+ * SCALAR_TYPE     The enum scalar_type value.
+ * SCALAR_ABS(x)   |x|.
+ * SCALAR_ABS1(x)  |re x| + |im x|, the cheap magnitude used to pick pivots
+ *                 (as in LAPACK's izamax), |x| for real types.
+ * WIDE_NORM2(x)   |x|^2 of a WIDE value.
+ * REAL_EPSILON    Machine epsilon of REAL.
+ * SCALAR_MPI      MPI datatype, defined when mpi.h is included before.
+ */
+
+#include "scalar.h" /* SCALAR_KIND_*, enum scalar_type */
+
+#include <complex.h> /* double complex, cabs, creal, cimag */
+#include <float.h>   /* FLT_EPSILON, DBL_EPSILON */
+#include <math.h>    /* fabs, fabsf */
+
+#undef SCALAR
+#undef REAL
+#undef WIDE
+#undef TYPED
+#undef SCALAR_TYPE
+#undef SCALAR_ABS
+#undef SCALAR_ABS1
+#undef WIDE_NORM2
+#undef REAL_EPSILON
+#undef SCALAR_MPI
+
+#define SCALAR_CONCAT_(name, suffix) name##_##suffix
+#define SCALAR_CONCAT(name, suffix) SCALAR_CONCAT_(name, suffix)
+
+#if SCALAR_KIND == SCALAR_KIND_FLOAT
+#define SCALAR float
+#define REAL float
+#define WIDE double
+#define TYPED(name) SCALAR_CONCAT(name, f)
+#define SCALAR_TYPE SCALAR_FLOAT
+#define SCALAR_ABS(x) fabsf(x)
+#define SCALAR_ABS1(x) fabsf(x)
+#define WIDE_NORM2(x) ((x) * (x))
+#define REAL_EPSILON FLT_EPSILON
+#ifdef MPI_VERSION
+#define SCALAR_MPI MPI_FLOAT
+#endif
+
+#elif SCALAR_KIND == SCALAR_KIND_DOUBLE
+#define SCALAR double
+#define REAL double
+#define WIDE double
+#define TYPED(name) SCALAR_CONCAT(name, d)
+#define SCALAR_TYPE SCALAR_DOUBLE
+#define SCALAR_ABS(x) fabs(x)
+#define SCALAR_ABS1(x) fabs(x)
+#define WIDE_NORM2(x) ((x) * (x))
+#define REAL_EPSILON DBL_EPSILON
+#ifdef MPI_VERSION
+#define SCALAR_MPI MPI_DOUBLE
+#endif
+
+#elif SCALAR_KIND == SCALAR_KIND_COMPLEX
+#define SCALAR double complex
+#define REAL double
+#define WIDE double complex
+#define TYPED(name) SCALAR_CONCAT(name, z)
+#define SCALAR_TYPE SCALAR_COMPLEX
+#define SCALAR_ABS(x) cabs(x)
+#define SCALAR_ABS1(x) (fabs(creal(x)) + fabs(cimag(x)))
+#define WIDE_NORM2(x) (creal(x) * creal(x) + cimag(x) * cimag(x))
+#define REAL_EPSILON DBL_EPSILON
+#ifdef MPI_VERSION
+#define SCALAR_MPI MPI_C_DOUBLE_COMPLEX
+#endif
+
+#else
+#error "SCALAR_KIND must be SCALAR_KIND_FLOAT, SCALAR_KIND_DOUBLE or SCALAR_KIND_COMPLEX"
+#endif
@@ -0,0 +1,132 @@
+/*
+ * @file tile_io.c
+ * @brief POSIX AIO transfers of matrix tiles and scratch files for the out-of-core engine
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "tile_io.h"
+
+#include <errno.h>  /* errno, EINTR */
+#include <stdio.h>  /* perror, snprintf */
+#include <stdlib.h> /* getenv, mkstemp */
+#include <string.h> /* memset */
+#include <unistd.h> /* pread, pwrite, unlink, close */
+
+bool tile_io_start(struct tile_io *io, int fd, void *buf, size_t bytes, off_t offset, bool write)
+{
+    memset(&io->cb, 0, sizeof(io->cb));
+    io->cb.aio_fildes = fd;
+    io->cb.aio_buf = buf;
+    io->cb.aio_nbytes = bytes;
+    io->cb.aio_offset = offset;
+    io->cb.aio_sigevent.sigev_notify = SIGEV_NONE;
+    io->write = write;
+
+    if ((write ? aio_write(&io->cb) : aio_read(&io->cb)) != 0)
+    {
+        perror(write ? "aio_write" : "aio_read");
+        io->pending = false;
+        return false;
+    }
+    io->pending = true;
+    return true;
+}
+
+bool tile_io_wait(struct tile_io *io)
+{
+    if (!io->pending)
+    {
+        return true;
+    }
+    io->pending = false;
+
+    const struct aiocb *list[1] = {&io->cb};
+    int err;
+    while ((err = aio_error(&io->cb)) == EINPROGRESS)
+    {
+        if (aio_suspend(list, 1, NULL) != 0 && errno != EINTR)
+        {
+            perror("aio_suspend");
+            return false;
+        }
+    }
+
+    ssize_t done = aio_return(&io->cb);
+    if (err != 0 || done < 0)
+    {
+        errno = err;
+        perror(io->write ? "Tile write failed" : "Tile read failed");
+        return false;
+    }
+
+    /* Finish a short transfer in place */
+    char *buf = (char *)io->cb.aio_buf;
+    size_t rest = io->cb.aio_nbytes - (size_t)done;
+    off_t offset = io->cb.aio_offset + done;
+    return rest == 0 || (io->write ? tile_pwrite(io->cb.aio_fildes, buf + done, rest, offset)
+                                   : tile_pread(io->cb.aio_fildes, buf + done, rest, offset));
+}
+
+bool tile_pread(int fd, void *buf, size_t bytes, off_t offset)
+{
+    char *p = buf;
+    while (bytes > 0)
+    {
+        ssize_t got = pread(fd, p, bytes, offset);
+        if (got < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (got <= 0)
+        {
+            perror("pread");
+            return false;
+        }
+        p += got;
+        bytes -= (size_t)got;
+        offset += got;
+    }
+    return true;
+}
+
+bool tile_pwrite(int fd, const void *buf, size_t bytes, off_t offset)
+{
+    const char *p = buf;
+    while (bytes > 0)
+    {
+        ssize_t put = pwrite(fd, p, bytes, offset);
+        if (put < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (put <= 0)
+        {
+            perror("pwrite");
+            return false;
+        }
+        p += put;
+        bytes -= (size_t)put;
+        offset += put;
+    }
+    return true;
+}
+
+int tile_scratch_file(const char *dir)
+{
+    if (!dir)
+    {
+        dir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+    }
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/matinv_tiles_XXXXXX", dir);
+    int fd = mkstemp(path);
+    if (fd < 0)
+    {
+        perror("Error creating scratch file");
+        return -1;
+    }
+    unlink(path);
+    return fd;
+}
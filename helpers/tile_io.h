@@ -0,0 +1,36 @@
+#ifndef TILE_IO_H
+#define TILE_IO_H
+
+#include <aio.h>       /* struct aiocb */
+#include <stdbool.h>   /* bool */
+#include <stddef.h>    /* size_t */
+#include <sys/types.h> /* off_t */
+
+/* Asynchronous transfers between memory and a region of a file.
+ *
+ * A transfer is queued with POSIX AIO and runs while the caller computes.
+ * tile_io_wait blocks until it is done and finishes a short transfer
+ * (possible for very large requests) synchronously, so a completed
+ * transfer always covers the whole region.
+ */
+struct tile_io
+{
+    struct aiocb cb;
+    bool pending;
+    bool write;
+};
+
+/* Queue reading (or writing) bytes at offset of fd into (from) buf, false if it cannot be queued */
+bool tile_io_start(struct tile_io *io, int fd, void *buf, size_t bytes, off_t offset, bool write);
+
+/* Wait for the queued transfer, returns immediately if there is none */
+bool tile_io_wait(struct tile_io *io);
+
+/* Synchronous transfers of exactly bytes bytes */
+bool tile_pread(int fd, void *buf, size_t bytes, off_t offset);
+bool tile_pwrite(int fd, const void *buf, size_t bytes, off_t offset);
+
+/* Create a scratch file in dir (NULL: $TMPDIR or /tmp), already unlinked so it disappears when closed */
+int tile_scratch_file(const char *dir);
+
+#endif /* TILE_IO_H */
@@ -0,0 +1,90 @@
+/*
+ * @file tile_layout.c
+ * @brief Tile-major matrix storage and parallel converters from and to row-major
+ */
+
+#include "tile_layout.h"
+#include "placement.h"
+
+#include <stdio.h>  /* perror */
+#include <string.h> /* memcpy, memset */
+
+bool tiled_alloc(struct tiled_matrix *tm, int n, int b)
+{
+    tm->n = n;
+    tm->b = b;
+    tm->nt = (n + b - 1) / b;
+    tm->bytes = (size_t)tm->nt * tm->nt * b * b * sizeof(double);
+    tm->data = placement_alloc(tm->bytes, &tm->page_bytes);
+    if (!tm->data)
+    {
+        perror("malloc (tiled matrix)");
+        return false;
+    }
+    return true;
+}
+
+void tiled_free(struct tiled_matrix *tm)
+{
+    placement_free(tm->data, tm->bytes, tm->page_bytes);
+    tm->data = NULL;
+}
+
+/* Each thread fills whole tiles: b row segments of b doubles out of mat, one contiguous tile written */
+void tiled_from_rows(struct tiled_matrix *tm, int n, const double mat[n][n])
+{
+    int b = tm->b, nt = tm->nt;
+
+#pragma omp parallel for schedule(static)
+    for (int t = 0; t < nt * nt; t++)
+    {
+        int I = t / nt, J = t % nt;
+        double *tile = tiled_tile(tm, I, J);
+        int rows = n - I * b < b ? n - I * b : b;
+        int cols = n - J * b < b ? n - J * b : b;
+
+        if (rows < b || cols < b)
+        {
+            memset(tile, 0, (size_t)b * b * sizeof(double));
+        }
+        for (int r = 0; r < rows; r++)
+        {
+            memcpy(tile + r * b, &mat[I * b + r][J * b], cols * sizeof(double));
+        }
+        if (I == J)
+        {
+            for (int r = rows; r < b; r++)
+            {
+                tile[r * b + r] = 1.0;
+            }
+        }
+    }
+}
+
+void tiled_to_rows(const struct tiled_matrix *tm, int n, double mat[n][n], const int *col_map)
+{
+    int b = tm->b, nt = tm->nt;
+
+    /* By rows, so each thread writes whole rows of mat and a permutation of the columns stays within them */
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++)
+    {
+        int I = i / b, r = i % b;
+        for (int J = 0; J < nt; J++)
+        {
+            const double *src = tiled_tile(tm, I, J) + r * b;
+            int cols = n - J * b < b ? n - J * b : b;
+            if (col_map)
+            {
+                for (int c = 0; c < cols; c++)
+                {
+                    mat[i][col_map[J * b + c]] = src[c];
+                }
+            }
+            else
+            {
+                memcpy(&mat[i][J * b], src, cols * sizeof(double));
+            }
+        }
+    }
+}
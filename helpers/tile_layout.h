@@ -0,0 +1,56 @@
+#ifndef TILE_LAYOUT_H
+#define TILE_LAYOUT_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* size_t */
+
+/* Tile-major storage of a square double matrix.
+ *
+ * The matrix is cut into nt x nt tiles of b x b elements. Each tile is a
+ * contiguous row-major block and the tiles follow each other row of tiles
+ * by row of tiles, so tile (I, J) starts at (I·nt + J)·b² doubles. A row
+ * segment within a tile is unit-stride, and so is a column segment up to
+ * the stride b, within a single tile of b² doubles: column sweeps such as
+ * a pivot search touch a few pages instead of one page per row. The matrix
+ * is padded to nt·b with the identity, which leaves its inverse unchanged
+ * in the leading n x n block.
+ *
+ * The converters deal out the tiles with schedule(static) over the
+ * flattened tile index, the engines loop over tiles the same way, so each
+ * tile is first touched by the thread that updates it (see placement.h).
+ */
+struct tiled_matrix
+{
+    int n;             /* Rows and columns of the matrix */
+    int b;             /* Rows and columns of a tile */
+    int nt;            /* Tiles per row and per column */
+    double *data;      /* nt² tiles of b² doubles */
+    size_t bytes;
+    size_t page_bytes;
+};
+
+/* Storage for an n x n matrix in b x b tiles, returns false if out of memory */
+bool tiled_alloc(struct tiled_matrix *tm, int n, int b);
+void tiled_free(struct tiled_matrix *tm);
+
+/* First element of tile (I, J) */
+static inline double *tiled_tile(const struct tiled_matrix *tm, int I, int J)
+{
+    return tm->data + ((size_t)I * tm->nt + J) * tm->b * tm->b;
+}
+
+/* Element (i, j), for the occasional single access */
+static inline double *tiled_at(const struct tiled_matrix *tm, int i, int j)
+{
+    return tiled_tile(tm, i / tm->b, j / tm->b) + (i % tm->b) * tm->b + j % tm->b;
+}
+
+/* Copy the row-major n x n matrix mat into the tiles, padding with the identity */
+void tiled_from_rows(struct tiled_matrix *tm, int n, const double mat[n][n]);
+
+/* Copy the leading n x n block back to row-major, column j of the tiles going to
+ * column col_map[j] of mat (NULL for the identity)
+ */
+void tiled_to_rows(const struct tiled_matrix *tm, int n, double mat[n][n], const int *col_map);
+
+#endif /* TILE_LAYOUT_H */
@@ -0,0 +1,11 @@
+#define _POSIX_C_SOURCE 200809L /* clock_gettime with -std=c99 */
+
+#include "timer.h"
+#include <time.h> /* clock_gettime, CLOCK_MONOTONIC */
+
+double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
@@ -0,0 +1,11 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+/* Milliseconds on a monotonic clock (CLOCK_MONOTONIC).
+ *
+ * Only differences between two calls are meaningful, unlike gettimeofday
+ * the value never jumps when the system time is adjusted.
+ */
+double now_ms(void);
+
+#endif /* TIMER_H */
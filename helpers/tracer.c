@@ -0,0 +1,173 @@
+/*
+ * @file tracer.c
+ * @brief Per-thread ring buffers of timeline events, exported as trace-event JSON
+ */
+
+#define _POSIX_C_SOURCE 200809L /* open_memstream */
+
+#include "tracer.h"
+#include "timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define TRACE_MAX_THREADS 256
+#define TRACE_DEFAULT_EVENTS (1 << 16)
+
+struct trace_event
+{
+    const char *name;
+    const char *category;
+    double start_ms;
+    double end_ms;
+};
+
+struct trace_buffer
+{
+    struct trace_event *events;
+    size_t capacity;
+    size_t written; /* Total events recorded, the ring holds the last capacity of them */
+    int tid;
+};
+
+static struct trace_buffer trace_buffers[TRACE_MAX_THREADS];
+static int trace_nbuffers = 0;
+static bool trace_on = false;
+static size_t trace_capacity = TRACE_DEFAULT_EVENTS;
+static double trace_base_ms = 0.0;
+static __thread struct trace_buffer *my_buffer = NULL;
+
+void trace_enable(size_t events_per_thread)
+{
+    trace_capacity = events_per_thread ? events_per_thread : TRACE_DEFAULT_EVENTS;
+    trace_base_ms = now_ms();
+    trace_on = true;
+#ifndef ENABLE_PROFILING
+    fprintf(stderr, "Warning: the trace will be empty, rebuild with -DENABLE_PROFILING to record phases.\n");
+#endif
+}
+
+bool trace_enabled(void)
+{
+    return trace_on;
+}
+
+/* Ring buffer of the calling thread, allocated on first use */
+static struct trace_buffer *thread_buffer(void)
+{
+    if (!my_buffer)
+    {
+        int id = __sync_fetch_and_add(&trace_nbuffers, 1);
+        if (id >= TRACE_MAX_THREADS)
+        {
+            return NULL;
+        }
+
+        struct trace_buffer *buf = &trace_buffers[id];
+        buf->events = malloc(trace_capacity * sizeof(struct trace_event));
+        buf->capacity = buf->events ? trace_capacity : 0;
+        buf->written = 0;
+        buf->tid = id;
+        my_buffer = buf;
+    }
+    return my_buffer;
+}
+
+void trace_record(const char *name, const char *category, double start_ms, double end_ms)
+{
+    if (!trace_on)
+    {
+        return;
+    }
+
+    struct trace_buffer *buf = thread_buffer();
+    if (!buf || buf->capacity == 0)
+    {
+        return;
+    }
+
+    struct trace_event *ev = &buf->events[buf->written % buf->capacity];
+    ev->name = name;
+    ev->category = category;
+    ev->start_ms = start_ms;
+    ev->end_ms = end_ms;
+    buf->written++;
+}
+
+char *trace_serialize(int pid, const char *process_name)
+{
+    char *text = NULL;
+    size_t len = 0;
+    FILE *fp = open_memstream(&text, &len);
+    if (!fp)
+    {
+        perror("open_memstream (trace)");
+        return NULL;
+    }
+
+    int nbuffers = trace_nbuffers < TRACE_MAX_THREADS ? trace_nbuffers : TRACE_MAX_THREADS;
+    fprintf(fp, "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, \"args\": {\"name\": \"%s\"}}",
+            pid, process_name);
+
+    for (int b = 0; b < nbuffers; b++)
+    {
+        struct trace_buffer *buf = &trace_buffers[b];
+        fprintf(fp, ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": %d, \"args\": {\"name\": \"thread %d\"}}",
+                pid, buf->tid, buf->tid);
+
+        size_t first = buf->written > buf->capacity ? buf->written - buf->capacity : 0;
+        if (first > 0)
+        {
+            fprintf(stderr, "Trace: thread %d dropped its %zu oldest events, increase the buffer size.\n", buf->tid, first);
+        }
+
+        for (size_t e = first; e < buf->written; e++)
+        {
+            struct trace_event *ev = &buf->events[e % buf->capacity];
+            /* Trace-event timestamps are in microseconds */
+            fprintf(fp, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                    ev->name, ev->category, pid, buf->tid,
+                    (ev->start_ms - trace_base_ms) * 1000.0, (ev->end_ms - ev->start_ms) * 1000.0);
+        }
+    }
+
+    fclose(fp);
+    return text;
+}
+
+bool trace_write_fragments(const char *path, char **fragments, int count)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        perror("Error opening trace file");
+        return false;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    for (int i = 0; i < count; i++)
+    {
+        fprintf(fp, "%s%s", i ? ",\n" : "", fragments[i]);
+    }
+    fprintf(fp, "\n]}\n");
+
+    if (fclose(fp) != 0)
+    {
+        perror("Error closing trace file");
+        return false;
+    }
+    return true;
+}
+
+bool trace_write(const char *path, const char *process_name)
+{
+    char *fragment = trace_serialize(0, process_name);
+    if (!fragment)
+    {
+        return false;
+    }
+
+    bool ok = trace_write_fragments(path, &fragment, 1);
+    free(fragment);
+    return ok;
+}
@@ -0,0 +1,38 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <stdbool.h> /* bool */
+#include <stddef.h>  /* size_t */
+
+/* Timeline tracer writing Chrome/Perfetto trace-event JSON.
+ *
+ * Every thread records complete events (name, category, begin, end) into
+ * its own fixed-size ring buffer, so recording never locks and the oldest
+ * events are overwritten once a buffer is full. The events are fed by the
+ * profiler scopes (see profiler.h), so a -DENABLE_PROFILING build is
+ * needed to get any events.
+ *
+ * Load the output in chrome://tracing or https://ui.perfetto.dev, each
+ * process (MPI rank) is one pid and each thread one track.
+ */
+
+/* Start recording, events_per_thread is the ring capacity (0 for the default) */
+void trace_enable(size_t events_per_thread);
+
+bool trace_enabled(void);
+
+/* Record one event of the calling thread, times in now_ms() milliseconds */
+void trace_record(const char *name, const char *category, double start_ms, double end_ms);
+
+/* Serialize the events of this process as a comma separated list of JSON
+ * objects with the given pid. Returns a malloc'ed string, NULL on failure.
+ */
+char *trace_serialize(int pid, const char *process_name);
+
+/* Write {"traceEvents": [...]} from already serialized fragments */
+bool trace_write_fragments(const char *path, char **fragments, int count);
+
+/* Write the events of this process to path */
+bool trace_write(const char *path, const char *process_name);
+
+#endif /* TRACER_H */
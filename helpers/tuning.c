@@ -0,0 +1,224 @@
+/*
+ * @file tuning.c
+ * @brief Per-machine tuning profile: load, record, save and look up the fastest engine configurations and the
+ *        time of each thread count
+ */
+
+#define _POSIX_C_SOURCE 200809L /* gethostname */
+
+#include "tuning.h"
+
+#include <math.h>   /* fabs, log */
+#include <omp.h>    /* omp_get_num_procs */
+#include <stdio.h>  /* fopen, fgets, sscanf, fprintf */
+#include <string.h> /* strcmp, strncpy */
+#include <unistd.h> /* gethostname */
+
+#define TUNING_MAGIC "matinv-tuning"
+#define TUNING_VERSION 2
+#define TUNING_MAX_ENTRIES 256
+#define TUNING_MAX_SCALING 2048
+#define TUNING_LINE 256
+
+static struct tuning_entry entries[TUNING_MAX_ENTRIES];
+static int entry_count = 0;
+static struct tuning_scaling scalings[TUNING_MAX_SCALING];
+static int scaling_count = 0;
+
+static void this_host(char *name, size_t size)
+{
+    if (gethostname(name, size) != 0)
+    {
+        snprintf(name, size, "unknown");
+    }
+    name[size - 1] = '\0';
+}
+
+bool tuning_load(const char *path)
+{
+    FILE *fp = fopen(path, "r");
+    if (!fp)
+    {
+        perror(path);
+        return false;
+    }
+
+    char line[TUNING_LINE], host[TUNING_LINE];
+    int version, cpus;
+    if (!fgets(line, sizeof(line), fp) || sscanf(line, TUNING_MAGIC " %d", &version) != 1 || version < 1 ||
+        version > TUNING_VERSION || !fgets(line, sizeof(line), fp) || sscanf(line, "host %255s %d", host, &cpus) != 2)
+    {
+        fprintf(stderr, "%s is not a tuning profile.\n", path);
+        fclose(fp);
+        return false;
+    }
+
+    /* Thread counts and chunks tuned for another node type would be guesses here */
+    if (cpus != omp_get_num_procs())
+    {
+        printf("Warning: tuning profile %s was made on %s with %d CPUs, this machine has %d, ignoring it.\n", path, host, cpus,
+               omp_get_num_procs());
+        fclose(fp);
+        return true;
+    }
+
+    int lineno = 2;
+    while (fgets(line, sizeof(line), fp))
+    {
+        lineno++;
+        if (strncmp(line, "threads ", 8) == 0)
+        {
+            struct tuning_scaling scaling;
+            char precision[16];
+            if (sscanf(line + 8, "%15s %d %d %lf", precision, &scaling.n, &scaling.threads, &scaling.ms) != 4 ||
+                !parse_scalar_type(precision, &scaling.type) || scaling.n < 1 || scaling.threads < 1)
+            {
+                fprintf(stderr, "Malformed entry on line %d of tuning profile %s.\n", lineno, path);
+                fclose(fp);
+                return false;
+            }
+            tuning_record_scaling(&scaling);
+            continue;
+        }
+
+        struct tuning_entry entry;
+        char precision[16];
+        if (sscanf(line, "%15s %d %15s %d %d %lf", precision, &entry.n, entry.engine, &entry.threads, &entry.chunk_rows,
+                   &entry.ms) != 6 ||
+            !parse_scalar_type(precision, &entry.type) || entry.n < 1 || entry.threads < 1 || entry.chunk_rows < 0)
+        {
+            fprintf(stderr, "Malformed entry on line %d of tuning profile %s.\n", lineno, path);
+            fclose(fp);
+            return false;
+        }
+        tuning_record(&entry);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+void tuning_record(const struct tuning_entry *entry)
+{
+    for (int i = 0; i < entry_count; i++)
+    {
+        if (entries[i].type == entry->type && entries[i].n == entry->n)
+        {
+            entries[i] = *entry;
+            return;
+        }
+    }
+    if (entry_count < TUNING_MAX_ENTRIES)
+    {
+        entries[entry_count++] = *entry;
+    }
+}
+
+void tuning_record_scaling(const struct tuning_scaling *scaling)
+{
+    for (int i = 0; i < scaling_count; i++)
+    {
+        if (scalings[i].type == scaling->type && scalings[i].n == scaling->n && scalings[i].threads == scaling->threads)
+        {
+            scalings[i] = *scaling;
+            return;
+        }
+    }
+    if (scaling_count < TUNING_MAX_SCALING)
+    {
+        scalings[scaling_count++] = *scaling;
+    }
+}
+
+bool tuning_save(const char *path)
+{
+    FILE *fp = fopen(path, "w");
+    if (!fp)
+    {
+        perror(path);
+        return false;
+    }
+
+    char host[TUNING_LINE];
+    this_host(host, sizeof(host));
+    fprintf(fp, "%s %d\nhost %s %d\n", TUNING_MAGIC, TUNING_VERSION, host, omp_get_num_procs());
+    for (int i = 0; i < entry_count; i++)
+    {
+        const struct tuning_entry *e = &entries[i];
+        fprintf(fp, "%s %d %s %d %d %.3f\n", scalar_type_name(e->type), e->n, e->engine, e->threads, e->chunk_rows, e->ms);
+    }
+    for (int i = 0; i < scaling_count; i++)
+    {
+        const struct tuning_scaling *s = &scalings[i];
+        fprintf(fp, "threads %s %d %d %.3f\n", scalar_type_name(s->type), s->n, s->threads, s->ms);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        perror(path);
+        return false;
+    }
+    return true;
+}
+
+const struct tuning_entry *tuning_lookup(enum scalar_type type, int n)
+{
+    const struct tuning_entry *best = NULL;
+    double best_dist = 0.0;
+    for (int i = 0; i < entry_count; i++)
+    {
+        if (entries[i].type != type)
+        {
+            continue;
+        }
+        /* Costs grow as a power of n, so sizes are compared by ratio, ties go to the larger size */
+        double dist = fabs(log((double)n / entries[i].n));
+        if (!best || dist < best_dist || (dist == best_dist && entries[i].n > best->n))
+        {
+            best = &entries[i];
+            best_dist = dist;
+        }
+    }
+    return best;
+}
+
+int tuning_team_size(enum scalar_type type, int n, int free_cores, int queued)
+{
+    /* The nearest timed size by ratio, as in tuning_lookup */
+    int nearest = 0;
+    double best_dist = 0.0;
+    for (int i = 0; i < scaling_count; i++)
+    {
+        if (scalings[i].type != type)
+        {
+            continue;
+        }
+        double dist = fabs(log((double)n / scalings[i].n));
+        if (!nearest || dist < best_dist || (dist == best_dist && scalings[i].n > nearest))
+        {
+            nearest = scalings[i].n;
+            best_dist = dist;
+        }
+    }
+
+    /* Teams of t threads run min(queued, free_cores / t) matrices at once, each in ms(t). Ties go to the smaller team. */
+    int best = 0;
+    double best_rate = 0.0;
+    for (int i = 0; i < scaling_count; i++)
+    {
+        const struct tuning_scaling *s = &scalings[i];
+        if (s->type != type || s->n != nearest || s->threads > free_cores || s->ms <= 0.0)
+        {
+            continue;
+        }
+        int teams = free_cores / s->threads;
+        teams = teams < queued ? teams : queued;
+        double rate = teams / s->ms;
+        if (rate > best_rate || (rate == best_rate && s->threads < best))
+        {
+            best = s->threads;
+            best_rate = rate;
+        }
+    }
+    return best;
+}
@@ -0,0 +1,78 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <stdbool.h> /* bool */
+
+#include "scalar.h"
+
+/* Per-machine tuning profile of the shared-memory engines.
+ *
+ * The fastest engine differs with the matrix size: the OpenMP engine loses
+ * to the serial one on small matrices, where forking the threads costs more
+ * than the work, and the best thread count and ownership chunk differ from
+ * one node type to the next. benchmark_program -tune= times the candidates
+ * over a grid of sizes on the current machine and records the fastest one
+ * of each size here. The OpenMP program loads the profile with -tuning= and
+ * runs every inversion with the entry of the nearest size.
+ *
+ * It also keeps the time of every thread count at each size, the fastest
+ * serial or OpenMP configuration with that many threads. A concurrent batch
+ * sizes its teams from them for throughput rather than latency (see
+ * tuning_team_size).
+ *
+ * The profile is a small text file:
+ *
+ *   matinv-tuning 2
+ *   host <hostname> <cpus>
+ *   <precision> <size> <engine> <threads> <chunk rows> <median ms>
+ *   ...
+ *   threads <precision> <size> <threads> <median ms>
+ *   ...
+ *
+ * A chunk of 0 rows stands for the page-sized default of placement.h.
+ * Version 1 profiles have no threads lines and are still read.
+ */
+struct tuning_entry
+{
+    enum scalar_type type;
+    int n;
+    char engine[16]; /* Engine name as in engines.h */
+    int threads;
+    int chunk_rows;
+    double ms;
+};
+
+/* Median time of the fastest serial or OpenMP configuration with this many threads */
+struct tuning_scaling
+{
+    enum scalar_type type;
+    int n;
+    int threads;
+    double ms;
+};
+
+/* Load the profile at path. Returns false (after printing why) if it cannot
+ * be read or is malformed. A profile made on a machine with another number
+ * of CPUs is ignored with a warning.
+ */
+bool tuning_load(const char *path);
+
+/* Add an entry, replacing the one of the same precision and size */
+void tuning_record(const struct tuning_entry *entry);
+
+/* Add the time of a thread count, replacing the one of the same precision, size and thread count */
+void tuning_record_scaling(const struct tuning_scaling *scaling);
+
+/* Write every entry to path, tagged with this machine */
+bool tuning_save(const char *path);
+
+/* The entry of the given precision whose size is nearest to n (by ratio), NULL if there is none */
+const struct tuning_entry *tuning_lookup(enum scalar_type type, int n);
+
+/* Team size for the next of queued n x n matrices, with free_cores cores free for them: the measured
+ * thread count (of the nearest size) that inverts the most matrices per second on those cores. With
+ * at least one matrix per core waiting that is the best speedup per thread, with fewer the teams grow
+ * to keep every core busy. 0 if no thread count of this precision up to free_cores was timed. */
+int tuning_team_size(enum scalar_type type, int n, int free_cores, int queued);
+
+#endif /* TUNING_H */
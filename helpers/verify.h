@@ -0,0 +1,58 @@
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <complex.h> /* double complex */
+#include <stdbool.h> /* bool */
+#include <stdio.h>   /* FILE */
+
+#include "scalar.h"
+
+/* Accuracy check of a computed inverse X of A.
+ *
+ * VERIFY_FULL forms R = A·X - I with a blocked, multithreaded multiply
+ * (2n^3 flops) and reports ||R||_F and max |R_ij| exactly.
+ * VERIFY_SAMPLED multiplies A·(X·z) - z for a few random +-1 vectors z
+ * (O(n^2)), which gives an unbiased estimate of ||R||_F^2 and is cheap
+ * enough to leave on in production runs.
+ *
+ * Both report the relative backward error ||R||_F / (||A||_F ||X||_F)
+ * and pass when it is below VERIFY_GROWTH * n * epsilon of the element type.
+ */
+enum verify_mode
+{
+    VERIFY_NONE,
+    VERIFY_SAMPLED,
+    VERIFY_FULL
+};
+
+struct verify_result
+{
+    enum verify_mode mode;
+    int n;
+    double residual;      /* ||A·X - I||_F, estimated in sampled mode */
+    double max_abs;       /* max |A·X - I|_ij, full mode only */
+    double backward;      /* residual / (||A||_F ||X||_F) */
+    double tolerance;     /* Threshold on backward */
+    double ms;            /* Time spent verifying */
+    bool passed;
+};
+
+/* Parse "full" or "sampled", returns false for anything else */
+bool parse_verify_mode(const char *name, enum verify_mode *mode);
+
+const char *verify_mode_name(enum verify_mode mode);
+
+/* Verify inv against mat, fills res and returns res->passed */
+bool verify_inverse(enum verify_mode mode, int n, const double mat[n][n], const double inv[n][n], struct verify_result *res);
+
+/* The same for float and complex double inverses, accumulated in double */
+bool verify_inverse_f(enum verify_mode mode, int n, const float mat[n][n], const float inv[n][n], struct verify_result *res);
+bool verify_inverse_z(enum verify_mode mode, int n, const double complex mat[n][n], const double complex inv[n][n], struct verify_result *res);
+
+/* Dispatch on the element type of the n x n arrays mat and inv */
+bool verify_inverse_typed(enum scalar_type type, enum verify_mode mode, int n, const void *mat, const void *inv, struct verify_result *res);
+
+/* One-line summary of res */
+void print_verify_result(FILE *fp, const char *label, const struct verify_result *res);
+
+#endif /* VERIFY_H */
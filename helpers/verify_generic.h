@@ -0,0 +1,178 @@
+/* Type-generic residual checks, instantiated by verify.c for float and complex double.
+ *
+ * The same two modes as the double verify_inverse, with the products
+ * accumulated in WIDE (double, double complex) so the residual of a float
+ * inverse is not drowned in float rounding of the check itself. The
+ * tolerance scales with the epsilon of the element type. No include guard.
+ */
+
+#include "scalar_template.h"
+
+static double TYPED(frobenius_norm)(int n, const SCALAR mat[n][n])
+{
+    double sumsq = 0.0;
+#pragma omp parallel for reduction(+ : sumsq)
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            WIDE x = mat[i][j];
+            sumsq += WIDE_NORM2(x);
+        }
+    }
+    return sqrt(sumsq);
+}
+
+/* ||A·X - I||_F^2 and max |A·X - I| from the full product, one block of rows per task */
+static bool TYPED(full_residual)(int n, const SCALAR mat[n][n], const SCALAR inv[n][n], double *sumsq_out, double *max_out)
+{
+    double sumsq = 0.0, max_abs = 0.0;
+    bool failed = false;
+
+#pragma omp parallel reduction(+ : sumsq) reduction(max : max_abs)
+    {
+        WIDE (*res)[n] = malloc(sizeof(WIDE[VERIFY_BLOCK_ROWS][n]));
+        if (!res)
+        {
+#pragma omp atomic write
+            failed = true;
+        }
+
+#pragma omp for schedule(dynamic)
+        for (int ib = 0; ib < n; ib += VERIFY_BLOCK_ROWS)
+        {
+            if (!res)
+            {
+                continue;
+            }
+
+            int iend = ib + VERIFY_BLOCK_ROWS < n ? ib + VERIFY_BLOCK_ROWS : n;
+            memset(res, 0, (size_t)(iend - ib) * n * sizeof(WIDE));
+
+            for (int jb = 0; jb < n; jb += VERIFY_BLOCK_COLS)
+            {
+                int jend = jb + VERIFY_BLOCK_COLS < n ? jb + VERIFY_BLOCK_COLS : n;
+                for (int kb = 0; kb < n; kb += VERIFY_BLOCK_ROWS)
+                {
+                    int kend = kb + VERIFY_BLOCK_ROWS < n ? kb + VERIFY_BLOCK_ROWS : n;
+                    for (int i = ib; i < iend; i++)
+                    {
+                        WIDE *row = res[i - ib];
+                        for (int k = kb; k < kend; k++)
+                        {
+                            WIDE a = mat[i][k];
+                            for (int j = jb; j < jend; j++)
+                            {
+                                row[j] += a * inv[k][j];
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (int i = ib; i < iend; i++)
+            {
+                res[i - ib][i] -= 1.0;
+                for (int j = 0; j < n; j++)
+                {
+                    double r2 = WIDE_NORM2(res[i - ib][j]);
+                    sumsq += r2;
+                    max_abs = r2 > max_abs ? r2 : max_abs;
+                }
+            }
+        }
+
+        free(res);
+    }
+
+    if (failed)
+    {
+        perror("malloc (verification block)");
+        return false;
+    }
+    *sumsq_out = sumsq;
+    *max_out = sqrt(max_abs);
+    return true;
+}
+
+/* Estimate ||A·X - I||_F^2 as the mean of ||A·(X·z) - z||^2 over random +-1 vectors z */
+static bool TYPED(sampled_residual)(int n, const SCALAR mat[n][n], const SCALAR inv[n][n], double *sumsq_out)
+{
+    double (*z)[VERIFY_SAMPLES] = malloc(sizeof(double[n][VERIFY_SAMPLES]));
+    WIDE (*y)[VERIFY_SAMPLES] = malloc(sizeof(WIDE[n][VERIFY_SAMPLES]));
+    if (!z || !y)
+    {
+        perror("malloc (verification probes)");
+        free(z);
+        free(y);
+        return false;
+    }
+    fill_probes(n, z);
+
+    /* y = X·z */
+#pragma omp parallel for
+    for (int i = 0; i < n; i++)
+    {
+        WIDE acc[VERIFY_SAMPLES] = {0};
+        for (int j = 0; j < n; j++)
+        {
+            WIDE x = inv[i][j];
+            for (int s = 0; s < VERIFY_SAMPLES; s++)
+            {
+                acc[s] += x * z[j][s];
+            }
+        }
+        for (int s = 0; s < VERIFY_SAMPLES; s++)
+        {
+            y[i][s] = acc[s];
+        }
+    }
+
+    /* A·y - z */
+    double sumsq = 0.0;
+#pragma omp parallel for reduction(+ : sumsq)
+    for (int i = 0; i < n; i++)
+    {
+        WIDE acc[VERIFY_SAMPLES] = {0};
+        for (int j = 0; j < n; j++)
+        {
+            WIDE a = mat[i][j];
+            for (int s = 0; s < VERIFY_SAMPLES; s++)
+            {
+                acc[s] += a * y[j][s];
+            }
+        }
+        for (int s = 0; s < VERIFY_SAMPLES; s++)
+        {
+            WIDE r = acc[s] - z[i][s];
+            sumsq += WIDE_NORM2(r);
+        }
+    }
+
+    free(z);
+    free(y);
+    *sumsq_out = sumsq / VERIFY_SAMPLES;
+    return true;
+}
+
+bool TYPED(verify_inverse)(enum verify_mode mode, int n, const SCALAR mat[n][n], const SCALAR inv[n][n], struct verify_result *res)
+{
+    double start = now_ms();
+    double sumsq = 0.0;
+
+    res->mode = mode;
+    res->n = n;
+    res->max_abs = 0.0;
+    res->passed = false;
+
+    bool ok = mode == VERIFY_FULL ? TYPED(full_residual)(n, mat, inv, &sumsq, &res->max_abs)
+                                  : TYPED(sampled_residual)(n, mat, inv, &sumsq);
+
+    double scale = TYPED(frobenius_norm)(n, mat) * TYPED(frobenius_norm)(n, inv);
+    res->residual = sqrt(sumsq);
+    res->backward = scale > 0.0 ? res->residual / scale : INFINITY;
+    res->tolerance = VERIFY_GROWTH * n * REAL_EPSILON;
+    res->passed = ok && !(res->backward > res->tolerance);
+    res->ms = now_ms() - start;
+    return res->passed;
+}
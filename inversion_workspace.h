@@ -0,0 +1,22 @@
+#ifndef INVERSION_WORKSPACE_H
+#define INVERSION_WORKSPACE_H
+
+/* Caller-owned buffers and settings of one double inversion.
+ *
+ * invert_matrix and invert_matrix_par allocate these per call and read the
+ * process-wide condition limit. The _ws entry points take them from the
+ * caller instead, so a library context (see matinv.h) can reuse one set of
+ * buffers for every matrix up to its capacity, and several contexts can
+ * invert concurrently without sharing any state.
+ */
+struct inversion_workspace
+{
+    double *aug;       /* n x 2n augmented matrix */
+    int *perm;         /* 2n ints: pivot order, then its inverse */
+    double *work;      /* 4n doubles for the condition estimate */
+    int chunk;         /* Rows per ownership chunk of the OpenMP engine */
+    double cond_limit; /* Reject above this condition number estimate, 0 for no limit */
+    double cond;       /* Out: condition number estimate, -1 if not reached */
+};
+
+#endif /* INVERSION_WORKSPACE_H */
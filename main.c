@@ -1,17 +1,47 @@
 #include "matrix_inversion.h"
 #include "matrix_inversion_parallel.h"
+#include "matrix_inversion_typed.h"
+#include "matrix_inversion_ooc.h"
+#include "matrix_inversion_tiled.h"
+#include "matrix_inversion_blocks.h"
+#include "matrix_inversion_structured.h"
+#include "matrix_inversion_selected.h"
+#include "matrix_inversion_stream.h"
+#include "matrix_inversion_exact.h"
+#include "engines.h"
+#include "matinv.h"
 #include "helpers/common.h"
 #include "helpers/file_reader.h"
+#include "helpers/cli_options.h"
+#include "helpers/batch_pipeline.h"
+#include "helpers/profiler.h"
+#include "helpers/tracer.h"
+#include "helpers/verify.h"
+#include "helpers/condition.h"
+#include "helpers/matrix_gen.h"
+#include "helpers/placement.h"
+#include "helpers/tuning.h"
+#include "helpers/timer.h"
 
+#include <omp.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <math.h>
+#include <float.h>
 
 double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol);
-void process_parallel_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol]);
-bool invert_matrix_from_file(const char *filepath);
+double **load_input_matrix(const struct cli_options *opts, int *nrow, int *ncol);
+bool process_parallel_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol], enum verify_mode verify);
+bool invert_single_matrix(const struct cli_options *opts);
+bool invert_single_matrix_typed(const struct cli_options *opts);
+bool invert_single_matrix_ooc(const struct cli_options *opts);
+bool invert_single_matrix_stream(const struct cli_options *opts);
+bool invert_single_matrix_exact(const struct cli_options *opts);
+bool invert_single_matrix_diagonal(const struct cli_options *opts);
+bool invert_matrices_in_batch(const struct cli_options *opts);
 
 // void test_openmp()
 // {
@@ -30,60 +60,443 @@ int main(int argc, char *argv[])
 
     if (argc < 2)
     {
-        fprintf(stderr, "Usage: %s -path=<file_path>\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
-    const char *filepath = NULL;
+    struct cli_options opts;
+    init_cli_options(&opts);
+    if (!parse_cli_options(argc, argv, &opts))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
 
-    // Parse command-line arguments
-    for (int i = 1; i < argc; i++)
+    if (opts.profile)
+    {
+        prof_enable(opts.profile_counters);
+    }
+    cond_set_limit(opts.cond_limit);
+    placement_set_pinning(opts.pin);
+    placement_set_huge_pages(opts.huge_pages);
+    if (opts.trace_path)
+    {
+        trace_enable(0);
+    }
+    if (opts.tuning_path && !tuning_load(opts.tuning_path))
     {
-        if (strncmp(argv[i], "-path=", 6) == 0)
+        return 1;
+    }
+    if (opts.blocks)
+    {
+        set_default_engine(ENGINE_BLOCKS);
+    }
+    if (opts.structure)
+    {
+        enum matrix_structure structure;
+        if (!parse_matrix_structure(opts.structure, &structure))
         {
-            filepath = argv[i] + 6; // Extract file path
+            fprintf(stderr, "Error: unknown structure %s, use auto, general, toeplitz or circulant.\n", opts.structure);
+            print_usage(argv[0]);
+            return 1;
         }
+        structured_set_hint(structure);
+        set_default_engine(ENGINE_STRUCTURED);
     }
 
-    if (!filepath)
+    bool ok;
+    if (is_batch_mode(&opts))
     {
-        fprintf(stderr, "Error: File path not specified. Use -path=<file_path>.\n");
-        return 1;
+        ok = invert_matrices_in_batch(&opts);
+        if (!ok)
+        {
+            fprintf(stderr, "Batch finished with failures.\n");
+        }
     }
-
-    if (!invert_matrix_from_file(filepath))
+    else
     {
-        fprintf(stderr, "Failed to process file: %s\n", filepath);
-        return 1;
+        if (opts.ooc_memory_mb > 0.0)
+        {
+            ok = invert_single_matrix_ooc(&opts);
+        }
+        else if (opts.stream)
+        {
+            ok = invert_single_matrix_stream(&opts);
+        }
+        else if (opts.exact)
+        {
+            ok = invert_single_matrix_exact(&opts);
+        }
+        else if (opts.diagonal)
+        {
+            ok = invert_single_matrix_diagonal(&opts);
+        }
+        else
+        {
+            ok = opts.precision == SCALAR_DOUBLE ? invert_single_matrix(&opts) : invert_single_matrix_typed(&opts);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Failed to process %s\n", opts.generate ? "the generated matrix" : opts.filepath);
+        }
     }
 
-    return 0;
+    prof_report(stdout, "OpenMP");
+    if (opts.trace_path && !trace_write(opts.trace_path, "OpenMP"))
+    {
+        ok = false;
+    }
+    return ok ? 0 : 1;
 }
 
-/* Function to read and invert a matrix from a file */
-bool invert_matrix_from_file(const char *filepath)
+/* Function to read (or generate) and invert a single matrix */
+bool invert_single_matrix(const struct cli_options *opts)
 {
     int nrow, ncol;
-    double **mat = allocate_and_read_matrix(filepath, &nrow, &ncol);
+    double **mat = load_input_matrix(opts, &nrow, &ncol);
 
     if (!mat)
     {
         return false;
     }
 
-    double mat_inv_parallel[nrow][ncol];
-    bool result = false;
-
-    process_parallel_inversion(nrow, ncol, mat, mat_inv_parallel);
+    /* On the heap, generated inputs can be far larger than the stack */
+    double (*mat_inv_parallel)[ncol] = malloc(sizeof(double[nrow][ncol]));
+    if (!mat_inv_parallel)
+    {
+        perror("malloc (inverse)");
+        free_matrix(mat, nrow);
+        return false;
+    }
+    bool result = process_parallel_inversion(nrow, ncol, mat, mat_inv_parallel, opts->verify);
 
     // printf("\n********** Inverted Matrix Start **********\n");
     // print_mat(nrow, ncol, mat_inv_parallel);
     // printf("\n********** Inverted Matrix End **********\n");
 
+    free(mat_inv_parallel);
     free_matrix(mat, nrow);
+    return result;
+}
+
+/* Out-of-core source for -generate=, the rows are regenerated as they are needed */
+static bool generated_source(void *ctx, int n, int row0, int nrows, double *rows)
+{
+    (void)n;
+    return generate_matrix_block(ctx, row0, nrows, rows);
+}
+
+/* Out-of-core run without -ooc-out, the inverse is only timed */
+static bool discard_sink(void *ctx, int n, int col0, int ncols, const double *panel)
+{
+    (void)ctx, (void)n, (void)col0, (void)ncols, (void)panel;
     return true;
 }
 
+/* Invert a single matrix that need not fit in memory, streaming it from a .bin file (or the generator) */
+bool invert_single_matrix_ooc(const struct cli_options *opts)
+{
+    ooc_set_memory_limit((size_t)(opts->ooc_memory_mb * 1024 * 1024));
+    ooc_set_scratch_dir(opts->ooc_dir);
+    if (opts->verify != VERIFY_NONE)
+    {
+        printf("Note: -verify is not available out of core, the inverse is never held in memory.\n");
+    }
+
+    struct ooc_file input = {-1, 0}, output = {-1, 0};
+    ooc_source source = generated_source;
+    void *source_ctx = (void *)&opts->generate_spec;
+    int n = opts->generate_spec.n;
+    if (!opts->generate)
+    {
+        if (!ooc_open_input(&input, opts->filepath))
+        {
+            fprintf(stderr, "Out-of-core input must be a square binary (.bin) matrix file.\n");
+            return false;
+        }
+        source = ooc_file_source;
+        source_ctx = &input;
+        n = input.n;
+    }
+
+    ooc_sink sink = discard_sink;
+    void *sink_ctx = NULL;
+    bool result = true;
+    if (opts->ooc_out)
+    {
+        result = ooc_create_output(&output, opts->ooc_out, n);
+        sink = ooc_file_sink;
+        sink_ctx = &output;
+    }
+
+    if (result)
+    {
+        result = benchmark_matrix_inversion_ooc(n, source, source_ctx, sink, sink_ctx);
+    }
+
+    ooc_close(&output);
+    ooc_close(&input);
+    return result;
+}
+
+/* Streaming source for -path=, the rows are parsed as the engine asks for them */
+static bool file_stream_source(void *ctx, int n, int row0, int nrows, double *rows)
+{
+    (void)n, (void)row0;
+    return matrix_stream_read(ctx, nrows, rows);
+}
+
+/* Invert a single matrix while it is being read (or generated) */
+bool invert_single_matrix_stream(const struct cli_options *opts)
+{
+    struct matrix_stream input = {NULL};
+    stream_source source = generated_source;
+    void *source_ctx = (void *)&opts->generate_spec;
+    int n = opts->generate_spec.n;
+    if (!opts->generate)
+    {
+        if (!matrix_stream_open(&input, opts->filepath))
+        {
+            fprintf(stderr, "Failed to read matrix from file %s\n", opts->filepath);
+            return false;
+        }
+        if (input.nrow != input.ncol)
+        {
+            fprintf(stderr, "Matrix in %s is not square (%dx%d).\n", opts->filepath, input.nrow, input.ncol);
+            matrix_stream_close(&input);
+            return false;
+        }
+        source = file_stream_source;
+        source_ctx = &input;
+        n = input.nrow;
+    }
+
+    /* The engine fills mat as it reads, it is kept for the verification */
+    double (*mat)[n] = malloc(sizeof(double[n][n]));
+    double (*mat_inv)[n] = malloc(sizeof(double[n][n]));
+    bool result = mat && mat_inv;
+    if (!result)
+    {
+        perror("malloc (streamed matrix)");
+    }
+    else
+    {
+        result = benchmark_matrix_inversion_stream(n, source, source_ctx, mat, mat_inv);
+    }
+    if (result && opts->verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        result = verify_inverse(opts->verify, n, mat, mat_inv, &res);
+        print_verify_result(stdout, "OpenMP", &res);
+    }
+
+    free(mat_inv);
+    free(mat);
+    matrix_stream_close(&input);
+    return result;
+}
+
+/* Read (or generate) a single matrix and invert it exactly */
+bool invert_single_matrix_exact(const struct cli_options *opts)
+{
+    int nrow, ncol;
+    double **rows = load_input_matrix(opts, &nrow, &ncol);
+    if (!rows)
+    {
+        return false;
+    }
+    if (nrow != ncol)
+    {
+        fprintf(stderr, "Matrix is not square (%dx%d).\n", nrow, ncol);
+        free_matrix(rows, nrow);
+        return false;
+    }
+
+    int n = nrow;
+    double (*mat)[n] = malloc(sizeof(double[n][n]));
+    if (!mat)
+    {
+        perror("malloc (matrix copy)");
+        free_matrix(rows, nrow);
+        return false;
+    }
+    copy_matrix(n, n, rows, mat);
+    free_matrix(rows, nrow);
+
+    struct exact_inverse inv;
+    bool inverted = benchmark_matrix_inversion_exact(n, mat, &inv);
+    bool result = inverted;
+    if (result && opts->exact_out)
+    {
+        result = write_exact_inverse(opts->exact_out, &inv);
+    }
+
+    /* The rounded inverse goes through the usual check, as a cross-check of the reconstruction */
+    if (result && opts->verify != VERIFY_NONE)
+    {
+        double (*mat_inv)[n] = malloc(sizeof(double[n][n]));
+        if (!mat_inv)
+        {
+            perror("malloc (inverse)");
+            result = false;
+        }
+        else
+        {
+            struct verify_result res;
+            exact_inverse_to_double(&inv, n, mat_inv);
+            result = verify_inverse(opts->verify, n, mat, mat_inv, &res);
+            print_verify_result(stdout, "Exact", &res);
+            free(mat_inv);
+        }
+    }
+
+    if (inverted)
+    {
+        exact_inverse_free(&inv);
+    }
+    free(mat);
+    return result;
+}
+
+/* Write the diagonal of the inverse, one entry per line */
+static bool write_diagonal(const char *filepath, int n, const double diag[n])
+{
+    FILE *fp = fopen(filepath, "w");
+    if (!fp)
+    {
+        perror("Error opening output file");
+        return false;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        fprintf(fp, "%.17g\n", diag[i]);
+    }
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0 || !ok)
+    {
+        perror("Error writing output file");
+        return false;
+    }
+    return true;
+}
+
+/* Read (or generate) a single matrix and compute only the diagonal of its inverse */
+bool invert_single_matrix_diagonal(const struct cli_options *opts)
+{
+    int nrow, ncol;
+    double **rows = load_input_matrix(opts, &nrow, &ncol);
+    if (!rows)
+    {
+        return false;
+    }
+    if (nrow != ncol)
+    {
+        fprintf(stderr, "Matrix is not square (%dx%d).\n", nrow, ncol);
+        free_matrix(rows, nrow);
+        return false;
+    }
+
+    int n = nrow;
+    double (*mat)[n] = malloc(sizeof(double[n][n]));
+    double *diag = malloc(n * sizeof(double));
+    if (!mat || !diag)
+    {
+        perror("malloc (matrix copy)");
+        free(mat);
+        free(diag);
+        free_matrix(rows, nrow);
+        return false;
+    }
+    copy_matrix(n, n, rows, mat);
+    free_matrix(rows, nrow);
+
+    bool result = benchmark_inversion_diagonal(n, mat, diag);
+    if (result && opts->diagonal_out)
+    {
+        result = write_diagonal(opts->diagonal_out, n, diag);
+    }
+
+    /* Cross-check against the diagonal of the full inverse, which differs by about cond·n·eps relative to its norm */
+    if (result && opts->verify != VERIFY_NONE)
+    {
+        double (*mat_inv)[n] = malloc(sizeof(double[n][n]));
+        if (!mat_inv)
+        {
+            perror("malloc (inverse)");
+            result = false;
+        }
+        else if ((result = invert_matrix_par(n, n, mat, mat_inv)))
+        {
+            double inorm = cond_norm1(n, n, mat_inv, 0), diff = 0.0;
+            for (int i = 0; i < n; i++)
+            {
+                diff = fmax(diff, fabs(diag[i] - mat_inv[i][i]));
+            }
+            double rel = inorm > 0.0 ? diff / inorm : diff;
+            double tol = 100.0 * n * DBL_EPSILON * cond_norm1(n, n, mat, 0) * inorm;
+            result = rel <= tol;
+            printf("Verification (Selected) of the %dx%d diagonal against the full inverse: max |d - diag(A^-1)| / ||A^-1||_1 = %.3e (tol %.1e): %s\n",
+                   n, n, rel, tol, result ? "PASSED" : "FAILED");
+        }
+        free(mat_inv);
+    }
+
+    free(diag);
+    free(mat);
+    return result;
+}
+
+/* Read (or generate) and invert a single float or complex matrix */
+bool invert_single_matrix_typed(const struct cli_options *opts)
+{
+    int n;
+    void *mat = load_typed_input_matrix(opts, &n);
+    void *mat_inv = mat ? malloc((size_t)n * n * scalar_size(opts->precision)) : NULL;
+    if (!mat_inv)
+    {
+        if (mat)
+        {
+            perror("malloc (inverse)");
+        }
+        free(mat);
+        return false;
+    }
+
+    /* The typed engines leave mat unchanged, no copy needed for the verification */
+    bool parallel = select_engine(opts->precision, n) != ENGINE_SERIAL;
+    bool result = benchmark_matrix_inversion_typed(opts->precision, parallel, n, mat, mat_inv);
+    if (result && opts->verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        result = verify_inverse_typed(opts->precision, opts->verify, n, mat, mat_inv, &res);
+        print_verify_result(stdout, "OpenMP", &res);
+    }
+
+    free(mat_inv);
+    free(mat);
+    return result;
+}
+
+/* The input matrix of a single inversion: generated in memory with -generate=, read from -path= otherwise */
+double **load_input_matrix(const struct cli_options *opts, int *nrow, int *ncol)
+{
+    if (!opts->generate)
+    {
+        return allocate_and_read_matrix(opts->filepath, nrow, ncol);
+    }
+
+    double **mat;
+    printf("Generating %dx%d %s matrix with seed %llu\n", opts->generate_spec.n, opts->generate_spec.n,
+           matrix_kind_name(opts->generate_spec.kind), (unsigned long long)opts->generate_spec.seed);
+    if (!generate_matrix_rows(&opts->generate_spec, &mat))
+    {
+        fprintf(stderr, "Failed to generate the matrix\n");
+        return NULL;
+    }
+    *nrow = *ncol = opts->generate_spec.n;
+    return mat;
+}
+
 /* Helper function to allocate and read a matrix */
 double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol)
 {
@@ -97,12 +510,182 @@ double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol)
 }
 
 /* Process parallel matrix inversion */
-void process_parallel_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol])
+bool process_parallel_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol], enum verify_mode verify)
 {
-    double mat_cp[nrow][ncol];
+    /* Heap copy, batch runs go through here with matrices too large for the stack */
+    double (*mat_cp)[ncol] = malloc(sizeof(double[nrow][ncol]));
+    if (!mat_cp)
+    {
+        perror("malloc (matrix copy)");
+        return false;
+    }
     copy_matrix(nrow, ncol, mat, mat_cp);
 
-    // Benchmark and invert matrix
-    benchmark_matrix_inversion_parallel(nrow, ncol, mat_cp, mat_inv);
+    // Benchmark and invert matrix, the tuning profile (or -blocks, -structure) may pick another engine
+    bool result;
+    switch (select_engine(SCALAR_DOUBLE, nrow))
+    {
+    case ENGINE_SERIAL:
+        result = benchmark_matrix_inversion(nrow, ncol, mat_cp, mat_inv);
+        break;
+    case ENGINE_TILED:
+        result = benchmark_matrix_inversion_tiled(nrow, mat_cp, mat_inv);
+        break;
+    case ENGINE_BLOCKS:
+        result = benchmark_matrix_inversion_blocks(nrow, mat_cp, mat_inv);
+        break;
+    case ENGINE_STRUCTURED:
+        result = benchmark_matrix_inversion_structured(nrow, mat_cp, mat_inv);
+        break;
+    default:
+        result = benchmark_matrix_inversion_parallel(nrow, ncol, mat_cp, mat_inv);
+        break;
+    }
     // *result = invert_matrix_par(nrow, ncol, mat_cp, mat_inv);
+
+    if (result && verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        result = verify_inverse(verify, nrow, mat_cp, mat_inv, &res);
+        print_verify_result(stdout, "OpenMP", &res);
+    }
+
+    free(mat_cp);
+    return result;
+}
+
+/* Compute stage of the batch pipeline */
+static bool invert_batch_job(struct batch_job *job, void *arg)
+{
+    const enum verify_mode *verify = arg;
+    int nrow = job->nrow, ncol = job->ncol;
+    double (*mat_inv)[ncol] = (double (*)[ncol])job->mat_inv;
+    return process_parallel_inversion(nrow, ncol, job->mat, mat_inv, *verify);
+}
+
+/* Without timed thread counts, a team gets at most one thread per this many rows */
+#define BATCH_ROWS_PER_THREAD 128
+
+/* State of the lanes of a concurrent batch */
+struct concurrent_batch
+{
+    enum verify_mode verify;
+    bool pin;
+    struct matinv_context **contexts; /* One per lane */
+};
+
+/* Team size of an n x n matrix for throughput: the timed thread count that inverts the most matrices per
+ * second on the free cores (tuning_team_size). Without timings, the free cores are split evenly over the
+ * queued matrices, capped at the thread count measured fastest by an older profile or else at one thread
+ * per BATCH_ROWS_PER_THREAD rows: small teams synchronize less per pivot. */
+static int batch_team_size(int n, int free_cores, int queued, void *arg)
+{
+    (void)arg;
+    int team = tuning_team_size(SCALAR_DOUBLE, n, free_cores, queued);
+    if (team > 0)
+    {
+        return team;
+    }
+
+    const struct tuning_entry *entry = tuning_lookup(SCALAR_DOUBLE, n);
+    int cap = (n + BATCH_ROWS_PER_THREAD - 1) / BATCH_ROWS_PER_THREAD;
+    if (entry)
+    {
+        cap = strcmp(entry->engine, engine_name(ENGINE_SERIAL)) == 0 ? 1 : entry->threads;
+    }
+    team = free_cores / queued;
+    return team < 1 ? 1 : team > cap ? cap : team;
+}
+
+/* Compute stage of a concurrent batch, runs on a lane thread with job->threads OpenMP threads */
+static bool invert_batch_job_concurrent(struct batch_job *job, void *arg)
+{
+    struct concurrent_batch *batch = arg;
+    int n = job->nrow;
+    if (job->ncol != n)
+    {
+        fprintf(stderr, "Matrix in %s is not square (%dx%d).\n", job->filepath, n, job->ncol);
+        return false;
+    }
+
+    double (*mat)[n] = malloc(sizeof(double[n][n]));
+    if (!mat)
+    {
+        perror("malloc (matrix copy)");
+        return false;
+    }
+    copy_matrix(n, n, job->mat, mat);
+    double (*mat_inv)[n] = (double (*)[n])job->mat_inv;
+
+    if (batch->pin)
+    {
+        placement_pin_team(job->cores, job->threads);
+    }
+    struct matinv_context *ctx = batch->contexts[job->lane];
+    double start = now_ms();
+    bool result = matinv_invert(ctx, n, mat, mat_inv);
+    double elapsed_time = now_ms() - start;
+
+    /* One call per report, the lanes print concurrently */
+    if (result)
+    {
+        printf("Matrix inversion (%s) completed in %.3f ms for %dx%d matrix.\n"
+               "Condition number estimate (1-norm): %.3e\nTeam size %d for %s\n",
+               job->threads > 1 ? "Parallel" : "Serial", elapsed_time, n, n, matinv_condition(ctx), job->threads, job->filepath);
+    }
+    if (result && batch->verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        result = verify_inverse(batch->verify, n, mat, mat_inv, &res);
+        print_verify_result(stdout, "OpenMP", &res);
+    }
+
+    free(mat);
+    return result;
+}
+
+/* Invert every matrix of a directory or manifest, overlapping file I/O with the inversions */
+bool invert_matrices_in_batch(const struct cli_options *opts)
+{
+    char **paths;
+    int count;
+    if (!list_batch_files(opts->dirpath, opts->manifest, &paths, &count))
+    {
+        return false;
+    }
+
+    struct batch_config cfg = {opts->prefetch_depth, opts->writeback_depth, opts->out_dir, 0, NULL, NULL};
+    int failures;
+    if (opts->concurrent_cores == 0)
+    {
+        failures = run_batch_pipeline(paths, count, &cfg, invert_batch_job, (void *)&opts->verify);
+    }
+    else
+    {
+        /* One context per lane, a lane inverts one matrix at a time. Serial exactly for teams of one. */
+        cfg.cores = opts->concurrent_cores < 0 ? omp_get_max_threads() : opts->concurrent_cores;
+        cfg.team_size = batch_team_size;
+        struct matinv_config mcfg;
+        matinv_init_config(&mcfg);
+        mcfg.serial_below = 0;
+        mcfg.cond_limit = opts->cond_limit;
+
+        struct concurrent_batch batch = {opts->verify, opts->pin, calloc(cfg.cores, sizeof(struct matinv_context *))};
+        bool ready = batch.contexts != NULL;
+        for (int l = 0; ready && l < cfg.cores; l++)
+        {
+            ready = (batch.contexts[l] = matinv_create(&mcfg)) != NULL;
+        }
+
+        printf("Concurrent batch on %d cores\n", cfg.cores);
+        failures = ready ? run_batch_pipeline(paths, count, &cfg, invert_batch_job_concurrent, &batch) : count;
+        for (int l = 0; batch.contexts && l < cfg.cores; l++)
+        {
+            matinv_destroy(batch.contexts[l]);
+        }
+        free(batch.contexts);
+    }
+
+    free_batch_files(paths, count);
+    return failures == 0;
 }
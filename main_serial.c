@@ -1,7 +1,15 @@
 #include "matrix_inversion.h"
 #include "matrix_inversion_parallel.h"
+#include "matrix_inversion_typed.h"
 #include "helpers/common.h"
 #include "helpers/file_reader.h"
+#include "helpers/cli_options.h"
+#include "helpers/batch_pipeline.h"
+#include "helpers/profiler.h"
+#include "helpers/tracer.h"
+#include "helpers/verify.h"
+#include "helpers/condition.h"
+#include "helpers/matrix_gen.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -10,8 +18,11 @@
 #include <stddef.h>
 
 double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol);
-void process_parallel_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol]);
-bool invert_matrix_from_file(const char *filepath);
+double **load_input_matrix(const struct cli_options *opts, int *nrow, int *ncol);
+bool process_serial_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol], enum verify_mode verify);
+bool invert_single_matrix(const struct cli_options *opts);
+bool invert_single_matrix_typed(const struct cli_options *opts);
+bool invert_matrices_in_batch(const struct cli_options *opts);
 
 /* Main function to perform matrix inversion */
 int main(int argc, char *argv[])
@@ -20,58 +31,132 @@ int main(int argc, char *argv[])
 
     if (argc < 2)
     {
-        fprintf(stderr, "Usage: %s -path=<file_path>\n", argv[0]);
+        print_usage(argv[0]);
         return 1;
     }
 
-    const char *filepath = NULL;
+    struct cli_options opts;
+    init_cli_options(&opts);
+    if (!parse_cli_options(argc, argv, &opts))
+    {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (opts.profile)
+    {
+        prof_enable(opts.profile_counters);
+    }
+    cond_set_limit(opts.cond_limit);
+    if (opts.trace_path)
+    {
+        trace_enable(0);
+    }
 
-    // Parse command-line arguments
-    for (int i = 1; i < argc; i++)
+    bool ok;
+    if (is_batch_mode(&opts))
     {
-        if (strncmp(argv[i], "-path=", 6) == 0)
+        ok = invert_matrices_in_batch(&opts);
+        if (!ok)
         {
-            filepath = argv[i] + 6; // Extract file path
+            fprintf(stderr, "Batch finished with failures.\n");
         }
     }
-
-    if (!filepath)
+    else
     {
-        fprintf(stderr, "Error: File path not specified. Use -path=<file_path>.\n");
-        return 1;
+        ok = opts.precision == SCALAR_DOUBLE ? invert_single_matrix(&opts) : invert_single_matrix_typed(&opts);
+        if (!ok)
+        {
+            fprintf(stderr, "Failed to process %s\n", opts.generate ? "the generated matrix" : opts.filepath);
+        }
     }
 
-    if (!invert_matrix_from_file(filepath))
+    prof_report(stdout, "Serial");
+    if (opts.trace_path && !trace_write(opts.trace_path, "Serial"))
     {
-        fprintf(stderr, "Failed to process file: %s\n", filepath);
-        return 1;
+        ok = false;
     }
-
-    return 0;
+    return ok ? 0 : 1;
 }
 
-/* Function to read and invert a matrix from a file */
-bool invert_matrix_from_file(const char *filepath)
+/* Function to read (or generate) and invert a single matrix */
+bool invert_single_matrix(const struct cli_options *opts)
 {
     int nrow, ncol;
-    double **mat = allocate_and_read_matrix(filepath, &nrow, &ncol);
+    double **mat = load_input_matrix(opts, &nrow, &ncol);
 
     if (!mat)
     {
         return false;
     }
 
-    double mat_inv_serial[nrow][ncol];
-    bool result = false;
-
-    process_serial_inversion(nrow, ncol, mat, mat_inv_serial);
+    /* On the heap, generated inputs can be far larger than the stack */
+    double (*mat_inv_serial)[ncol] = malloc(sizeof(double[nrow][ncol]));
+    if (!mat_inv_serial)
+    {
+        perror("malloc (inverse)");
+        free_matrix(mat, nrow);
+        return false;
+    }
+    bool result = process_serial_inversion(nrow, ncol, mat, mat_inv_serial, opts->verify);
 
     // printf("\n********** Inverted Matrix Start **********\n");
     // print_mat(nrow, ncol, mat_inv_serial);
     // printf("\n********** Inverted Matrix End **********\n");
 
+    free(mat_inv_serial);
     free_matrix(mat, nrow);
-    return true;
+    return result;
+}
+
+/* Read (or generate) and invert a single float or complex matrix */
+bool invert_single_matrix_typed(const struct cli_options *opts)
+{
+    int n;
+    void *mat = load_typed_input_matrix(opts, &n);
+    void *mat_inv = mat ? malloc((size_t)n * n * scalar_size(opts->precision)) : NULL;
+    if (!mat_inv)
+    {
+        if (mat)
+        {
+            perror("malloc (inverse)");
+        }
+        free(mat);
+        return false;
+    }
+
+    /* The typed engines leave mat unchanged, no copy needed for the verification */
+    bool result = benchmark_matrix_inversion_typed(opts->precision, false, n, mat, mat_inv);
+    if (result && opts->verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        result = verify_inverse_typed(opts->precision, opts->verify, n, mat, mat_inv, &res);
+        print_verify_result(stdout, "Serial", &res);
+    }
+
+    free(mat_inv);
+    free(mat);
+    return result;
+}
+
+/* The input matrix of a single inversion: generated in memory with -generate=, read from -path= otherwise */
+double **load_input_matrix(const struct cli_options *opts, int *nrow, int *ncol)
+{
+    if (!opts->generate)
+    {
+        return allocate_and_read_matrix(opts->filepath, nrow, ncol);
+    }
+
+    double **mat;
+    printf("Generating %dx%d %s matrix with seed %llu\n", opts->generate_spec.n, opts->generate_spec.n,
+           matrix_kind_name(opts->generate_spec.kind), (unsigned long long)opts->generate_spec.seed);
+    if (!generate_matrix_rows(&opts->generate_spec, &mat))
+    {
+        fprintf(stderr, "Failed to generate the matrix\n");
+        return NULL;
+    }
+    *nrow = *ncol = opts->generate_spec.n;
+    return mat;
 }
 
 /* Helper function to allocate and read a matrix */
@@ -86,10 +171,52 @@ double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol)
     return mat;
 }
 
-void process_serial_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol])
+bool process_serial_inversion(int nrow, int ncol, double **mat, double mat_inv[nrow][ncol], enum verify_mode verify)
 {
-    double mat_cp[nrow][ncol];
+    /* Heap copy, batch runs go through here with matrices too large for the stack */
+    double (*mat_cp)[ncol] = malloc(sizeof(double[nrow][ncol]));
+    if (!mat_cp)
+    {
+        perror("malloc (matrix copy)");
+        return false;
+    }
     copy_matrix(nrow, ncol, mat, mat_cp);
 
-    benchmark_matrix_inversion(nrow, ncol, mat_cp, mat_inv);
+    bool result = benchmark_matrix_inversion(nrow, ncol, mat_cp, mat_inv);
+
+    if (result && verify != VERIFY_NONE)
+    {
+        struct verify_result res;
+        result = verify_inverse(verify, nrow, mat_cp, mat_inv, &res);
+        print_verify_result(stdout, "Serial", &res);
+    }
+
+    free(mat_cp);
+    return result;
+}
+
+/* Compute stage of the batch pipeline */
+static bool invert_batch_job(struct batch_job *job, void *arg)
+{
+    const enum verify_mode *verify = arg;
+    int nrow = job->nrow, ncol = job->ncol;
+    double (*mat_inv)[ncol] = (double (*)[ncol])job->mat_inv;
+    return process_serial_inversion(nrow, ncol, job->mat, mat_inv, *verify);
+}
+
+/* Invert every matrix of a directory or manifest, overlapping file I/O with the inversions */
+bool invert_matrices_in_batch(const struct cli_options *opts)
+{
+    char **paths;
+    int count;
+    if (!list_batch_files(opts->dirpath, opts->manifest, &paths, &count))
+    {
+        return false;
+    }
+
+    struct batch_config cfg = {opts->prefetch_depth, opts->writeback_depth, opts->out_dir, 0, NULL, NULL};
+    int failures = run_batch_pipeline(paths, count, &cfg, invert_batch_job, (void *)&opts->verify);
+
+    free_batch_files(paths, count);
+    return failures == 0;
 }
@@ -0,0 +1,185 @@
+/*
+ * @file matinv.c
+ * @brief Reentrant library interface with a per-context workspace arena
+ *
+ * The context keeps one augmented matrix, pivot order and condition
+ * estimate scratch sized for its largest matrix and hands them to the
+ * workspace entry points of the serial and OpenMP engines. The thread count
+ * is set on the calling thread for the inversion only, so contexts with
+ * different settings can run side by side.
+ */
+
+#include "matinv.h"
+#include "matrix_inversion.h"
+#include "matrix_inversion_parallel.h"
+#include "matrix_inversion_selected.h"
+#include "helpers/placement.h"
+
+#include <omp.h>
+#include <stdio.h>  /* perror, fprintf */
+#include <stdlib.h> /* malloc, free */
+
+#define MATINV_SERIAL_BELOW 128
+
+struct matinv_context
+{
+    struct matinv_config cfg;
+    int capacity;      /* Largest n the buffers hold */
+    double *aug;       /* capacity x 2 capacity, from placement_alloc */
+    size_t aug_bytes;
+    size_t page_bytes;
+    int *perm;         /* 2 capacity */
+    double *work;      /* 4 capacity */
+    double cond;
+};
+
+void matinv_init_config(struct matinv_config *cfg)
+{
+    cfg->engine = MATINV_AUTO;
+    cfg->threads = 0;
+    cfg->serial_below = MATINV_SERIAL_BELOW;
+    cfg->chunk_rows = 0;
+    cfg->cond_limit = 0.0;
+}
+
+struct matinv_context *matinv_create(const struct matinv_config *cfg)
+{
+    struct matinv_context *ctx = calloc(1, sizeof(*ctx));
+    if (!ctx)
+    {
+        perror("malloc (matinv context)");
+        return NULL;
+    }
+
+    if (cfg)
+    {
+        ctx->cfg = *cfg;
+    }
+    else
+    {
+        matinv_init_config(&ctx->cfg);
+    }
+    ctx->cond = -1.0;
+    return ctx;
+}
+
+static void release_buffers(struct matinv_context *ctx)
+{
+    placement_free(ctx->aug, ctx->aug_bytes, ctx->page_bytes);
+    free(ctx->perm);
+    free(ctx->work);
+    ctx->aug = NULL;
+    ctx->perm = NULL;
+    ctx->work = NULL;
+    ctx->capacity = 0;
+}
+
+void matinv_destroy(struct matinv_context *ctx)
+{
+    if (ctx)
+    {
+        release_buffers(ctx);
+        free(ctx);
+    }
+}
+
+bool matinv_reserve(struct matinv_context *ctx, int n)
+{
+    if (n <= ctx->capacity)
+    {
+        return true;
+    }
+
+    /* Grow to n and never shrink, the buffers of the largest matrix serve all smaller ones */
+    release_buffers(ctx);
+    ctx->aug_bytes = sizeof(double[n][2 * n]);
+    ctx->aug = placement_alloc(ctx->aug_bytes, &ctx->page_bytes);
+    ctx->perm = malloc(2 * (size_t)n * sizeof(int));
+    ctx->work = malloc(4 * (size_t)n * sizeof(double));
+    if (!ctx->aug || !ctx->perm || !ctx->work)
+    {
+        perror("malloc (matinv workspace)");
+        release_buffers(ctx);
+        return false;
+    }
+    ctx->capacity = n;
+    return true;
+}
+
+static bool use_serial(const struct matinv_config *cfg, int n, int threads)
+{
+    switch (cfg->engine)
+    {
+    case MATINV_SERIAL:
+        return true;
+    case MATINV_OPENMP:
+        return false;
+    default:
+        /* Forking a team costs more than the work on small matrices, and buys nothing with one thread */
+        return n < cfg->serial_below || threads == 1;
+    }
+}
+
+bool matinv_invert(struct matinv_context *ctx, int n, const double mat[n][n], double mat_inv[n][n])
+{
+    if (n < 1)
+    {
+        fprintf(stderr, "matinv: invalid matrix size %d\n", n);
+        return false;
+    }
+    if (!matinv_reserve(ctx, n))
+    {
+        return false;
+    }
+
+    /* The thread count is an ICV of the calling thread, restored so the caller's own regions are unaffected */
+    int caller_threads = omp_get_max_threads();
+    int threads = ctx->cfg.threads > 0 ? ctx->cfg.threads : caller_threads;
+    omp_set_num_threads(threads);
+
+    size_t row_bytes = sizeof(double[2 * n]);
+    int chunk = ctx->cfg.chunk_rows > 0 ? ctx->cfg.chunk_rows : (int)((ctx->page_bytes + row_bytes - 1) / row_bytes);
+    struct inversion_workspace ws = {ctx->aug, ctx->perm, ctx->work, chunk, ctx->cfg.cond_limit, -1.0};
+
+    /* The engines only read mat */
+    double (*in)[n] = (double (*)[n])mat;
+    bool ok = use_serial(&ctx->cfg, n, threads) ? invert_matrix_ws(n, in, &ws, mat_inv) : invert_matrix_par_ws(n, in, &ws, mat_inv);
+
+    omp_set_num_threads(caller_threads);
+    ctx->cond = ws.cond;
+    return ok;
+}
+
+bool matinv_invert_selected(struct matinv_context *ctx, int n, const double mat[n][n], int count, struct inverse_block *blocks)
+{
+    if (n < 1)
+    {
+        fprintf(stderr, "matinv: invalid matrix size %d\n", n);
+        return false;
+    }
+    if (!matinv_reserve(ctx, n))
+    {
+        return false;
+    }
+
+    int caller_threads = omp_get_max_threads();
+    omp_set_num_threads(ctx->cfg.threads > 0 ? ctx->cfg.threads : caller_threads);
+
+    /* The LU factors take n x n of the augmented matrix buffer */
+    size_t row_bytes = sizeof(double[n]);
+    int chunk = ctx->cfg.chunk_rows > 0 ? ctx->cfg.chunk_rows : (int)((ctx->page_bytes + row_bytes - 1) / row_bytes);
+    struct inversion_workspace ws = {ctx->aug, ctx->perm, ctx->work, chunk, ctx->cfg.cond_limit, -1.0};
+
+    /* Always the OpenMP factorization, the selected columns are solved from its L and U */
+    double (*in)[n] = (double (*)[n])mat;
+    bool ok = invert_selected_ws(n, in, &ws, count, blocks);
+
+    omp_set_num_threads(caller_threads);
+    ctx->cond = ws.cond;
+    return ok;
+}
+
+double matinv_condition(const struct matinv_context *ctx)
+{
+    return ctx->cond;
+}
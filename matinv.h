@@ -0,0 +1,134 @@
+#ifndef MATINV_H
+#define MATINV_H
+
+#include <stdbool.h> /* bool */
+
+/* Library interface of the double inversion engines (libmatinv).
+ *
+ * A context owns everything an inversion needs besides the matrices: the
+ * engine choice, the OpenMP thread count, the condition number limit and
+ * scratch buffers sized for the largest matrix it has seen. Once the buffers
+ * have grown to that size, matinv_invert allocates nothing, so a service can
+ * invert any number of matrices without allocator churn or memory growth.
+ *
+ * Calls are reentrant: contexts share no state, and different threads may
+ * each invert with their own context at the same time. A single context
+ * must not be used by two threads at once. Failures return false after
+ * printing why, like the programs do.
+ *
+ *   struct matinv_config cfg;
+ *   matinv_init_config(&cfg);
+ *   cfg.threads = 8;
+ *   struct matinv_context *ctx = matinv_create(&cfg);
+ *   matinv_reserve(ctx, 1000);              optional, grows the buffers up front
+ *   ok = matinv_invert(ctx, n, mat, mat_inv);
+ *   matinv_destroy(ctx);
+ */
+enum matinv_engine
+{
+    MATINV_AUTO,   /* Serial below serial_below rows or with one thread, OpenMP otherwise */
+    MATINV_SERIAL, /* Single-threaded Gauss-Jordan */
+    MATINV_OPENMP, /* Multi-threaded Gauss-Jordan */
+};
+
+struct matinv_config
+{
+    enum matinv_engine engine;
+    int threads;       /* OpenMP threads per inversion, 0 for the OpenMP default */
+    int serial_below;  /* MATINV_AUTO: matrices with fewer rows run serially */
+    int chunk_rows;    /* Rows per ownership chunk of the OpenMP engine, 0 for about a page */
+    double cond_limit; /* Reject matrices whose condition number estimate exceeds it, 0 for no limit */
+};
+
+struct matinv_context;
+
+/* Defaults: MATINV_AUTO, OpenMP default threads, serial below 128 rows, page-sized chunks, no limit */
+void matinv_init_config(struct matinv_config *cfg);
+
+/* New context with a copy of cfg (NULL for the defaults), NULL if out of memory */
+struct matinv_context *matinv_create(const struct matinv_config *cfg);
+
+void matinv_destroy(struct matinv_context *ctx);
+
+/* Grow the buffers to hold an n x n inversion, returns false if out of memory */
+bool matinv_reserve(struct matinv_context *ctx, int n);
+
+/* Invert the n x n matrix mat into mat_inv, mat is left unchanged */
+bool matinv_invert(struct matinv_context *ctx, int n, const double mat[n][n], double mat_inv[n][n]);
+
+/* 1-norm condition number estimate of the last matrix inverted with ctx, -1 if there is none */
+double matinv_condition(const struct matinv_context *ctx);
+
+/* Only some entries of the inverse: fill each of the count blocks (see matrix_inversion_selected.h)
+ * with its rows and columns of the inverse of mat. Factors mat as LU with OpenMP in the context's
+ * buffers and solves only the columns somebody asked for, so the diagonal costs about two thirds
+ * of a full inversion and a few entries about a third. The selection itself is allocated. */
+struct inverse_block;
+bool matinv_invert_selected(struct matinv_context *ctx, int n, const double mat[n][n], int count, struct inverse_block *blocks);
+
+/* Asynchronous inversions on a pool of worker threads.
+ *
+ * Each worker owns a context made from the pool's config and takes
+ * requests in submission order, so the caller can prepare the next matrix
+ * or consume the last inverse while the engine runs. A pool holds a fixed
+ * number of request slots: matinv_submit waits for one to come free when
+ * they are all taken, which bounds the memory of any number of requests in
+ * flight. The matrices are not copied and must stay valid until the
+ * request is finished.
+ *
+ * Every request ends in exactly one of DONE, FAILED or CANCELLED. The
+ * callback, if any, runs once with that status: on the worker before
+ * matinv_wait returns for DONE and FAILED, on the thread calling
+ * matinv_cancel for CANCELLED. A request must be released once nobody
+ * waits on it any more, which hands its slot back; the callback may do
+ * that itself for fire-and-forget requests.
+ *
+ *   struct matinv_pool *pool = matinv_pool_create(&cfg, 2, 16);
+ *   struct matinv_request *req = matinv_submit(pool, n, mat, mat_inv, NULL, NULL);
+ *   ... other work ...
+ *   if (matinv_wait(req) == MATINV_DONE) ...
+ *   matinv_release(req);
+ *   matinv_pool_destroy(pool);
+ */
+enum matinv_status
+{
+    MATINV_PENDING,   /* Queued */
+    MATINV_RUNNING,   /* Being inverted by a worker */
+    MATINV_DONE,      /* mat_inv holds the inverse */
+    MATINV_FAILED,    /* Singular, ill-conditioned or out of memory */
+    MATINV_CANCELLED, /* Withdrawn before a worker took it, mat_inv untouched */
+};
+
+struct matinv_pool;
+struct matinv_request;
+
+typedef void (*matinv_callback)(struct matinv_request *req, enum matinv_status status, void *arg);
+
+/* workers threads, each inverting with cfg (NULL for the defaults), and max_requests slots (0 for
+ * four per worker). NULL if out of memory or a thread cannot be started. */
+struct matinv_pool *matinv_pool_create(const struct matinv_config *cfg, int workers, int max_requests);
+
+/* Finish every request already submitted, then stop the workers. Handles not yet released become invalid. */
+void matinv_pool_destroy(struct matinv_pool *pool);
+
+/* Queue the inversion of mat into mat_inv, waiting for a free slot if needed. callback may be NULL. */
+struct matinv_request *matinv_submit(struct matinv_pool *pool, int n, const double mat[n][n], double mat_inv[n][n],
+                                     matinv_callback callback, void *arg);
+
+/* Current status, without waiting */
+enum matinv_status matinv_poll(struct matinv_request *req);
+
+/* Wait until the request is finished and return how it ended */
+enum matinv_status matinv_wait(struct matinv_request *req);
+
+/* Withdraw a request no worker has taken yet, returns false if it is already running or finished */
+bool matinv_cancel(struct matinv_request *req);
+
+/* Condition number estimate of a DONE request, -1 otherwise */
+double matinv_request_condition(struct matinv_request *req);
+
+/* Give the slot back. A request released while still queued is cancelled without its callback, one
+ * released while running keeps its slot until it finishes. */
+void matinv_release(struct matinv_request *req);
+
+#endif /* MATINV_H */
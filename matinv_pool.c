@@ -0,0 +1,312 @@
+/*
+ * @file matinv_pool.c
+ * @brief Asynchronous submission of inversions to a pool of worker threads
+ *
+ * The requests live in a fixed array of slots. A submitted request goes on
+ * a bounded queue as large as the array, so pushing never waits, and the
+ * wait for a free slot is what holds a producer back. Workers pop requests
+ * in order and invert them with their own context, skipping the ones that
+ * were cancelled while queued. A slot returns to the free list once the
+ * request is released, no longer on the queue and not running.
+ */
+
+#include "matinv.h"
+#include "helpers/bounded_queue.h"
+
+#include <pthread.h>
+#include <stdio.h>  /* perror, fprintf */
+#include <stdlib.h> /* malloc, calloc, free */
+
+#define MATINV_SLOTS_PER_WORKER 4
+
+struct matinv_request
+{
+    struct matinv_pool *pool;
+    int n;
+    const double *mat;
+    double *mat_inv;
+    matinv_callback callback;
+    void *arg;
+    enum matinv_status status;
+    double cond;
+    bool queued;   /* Still on the queue, possibly cancelled */
+    bool released;
+    struct matinv_request *next_free;
+};
+
+struct matinv_worker
+{
+    struct matinv_pool *pool;
+    struct matinv_context *ctx;
+    pthread_t thread;
+    bool started;
+};
+
+struct matinv_pool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t changed; /* A request finished or a slot came free */
+    bool closing;
+    struct matinv_request *slots;
+    struct matinv_request *free_list;
+    struct bounded_queue pending;
+    struct matinv_worker *workers;
+    int nworkers;
+};
+
+static bool finished(enum matinv_status status)
+{
+    return status != MATINV_PENDING && status != MATINV_RUNNING;
+}
+
+/* Put the slot back on the free list once nothing refers to it, called with the lock held */
+static void recycle_locked(struct matinv_request *req)
+{
+    struct matinv_pool *pool = req->pool;
+    if (req->released && !req->queued && finished(req->status))
+    {
+        req->next_free = pool->free_list;
+        pool->free_list = req;
+        pthread_cond_broadcast(&pool->changed);
+    }
+}
+
+static void *matinv_worker_main(void *arg)
+{
+    struct matinv_worker *worker = arg;
+    struct matinv_pool *pool = worker->pool;
+    void *item;
+
+    while (bq_pop(&pool->pending, &item))
+    {
+        struct matinv_request *req = item;
+        pthread_mutex_lock(&pool->lock);
+        req->queued = false;
+        bool run = req->status == MATINV_PENDING;
+        if (run)
+        {
+            req->status = MATINV_RUNNING;
+        }
+        else
+        {
+            recycle_locked(req);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (!run)
+        {
+            continue;
+        }
+
+        int n = req->n;
+        bool ok = matinv_invert(worker->ctx, n, (const double (*)[n])req->mat, (double (*)[n])req->mat_inv);
+        enum matinv_status status = ok ? MATINV_DONE : MATINV_FAILED;
+        req->cond = ok ? matinv_condition(worker->ctx) : -1.0;
+
+        /* Before the status is published, so a waiter that then releases the request cannot race the callback */
+        if (req->callback)
+        {
+            req->callback(req, status, req->arg);
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        req->status = status;
+        pthread_cond_broadcast(&pool->changed);
+        recycle_locked(req);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+struct matinv_pool *matinv_pool_create(const struct matinv_config *cfg, int workers, int max_requests)
+{
+    if (workers < 1 || max_requests < 0)
+    {
+        fprintf(stderr, "matinv: invalid pool of %d workers and %d requests\n", workers, max_requests);
+        return NULL;
+    }
+    int nslots = max_requests > 0 ? max_requests : MATINV_SLOTS_PER_WORKER * workers;
+
+    struct matinv_pool *pool = calloc(1, sizeof(*pool));
+    if (!pool)
+    {
+        perror("malloc (matinv pool)");
+        return NULL;
+    }
+    pool->slots = calloc(nslots, sizeof(struct matinv_request));
+    pool->workers = calloc(workers, sizeof(struct matinv_worker));
+    if (!pool->slots || !pool->workers || !bq_init(&pool->pending, nslots))
+    {
+        perror("malloc (matinv pool)");
+        free(pool->workers);
+        free(pool->slots);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->changed, NULL);
+    for (int i = nslots - 1; i >= 0; i--)
+    {
+        pool->slots[i].pool = pool;
+        pool->slots[i].next_free = pool->free_list;
+        pool->free_list = &pool->slots[i];
+    }
+
+    pool->nworkers = workers;
+    for (int w = 0; w < workers; w++)
+    {
+        struct matinv_worker *worker = &pool->workers[w];
+        worker->pool = pool;
+        worker->ctx = matinv_create(cfg);
+        if (!worker->ctx)
+        {
+            matinv_pool_destroy(pool);
+            return NULL;
+        }
+        if (pthread_create(&worker->thread, NULL, matinv_worker_main, worker) != 0)
+        {
+            perror("pthread_create (matinv worker)");
+            matinv_pool_destroy(pool);
+            return NULL;
+        }
+        worker->started = true;
+    }
+    return pool;
+}
+
+void matinv_pool_destroy(struct matinv_pool *pool)
+{
+    if (!pool)
+    {
+        return;
+    }
+
+    /* Submitters waiting for a slot give up, the workers drain the queue */
+    pthread_mutex_lock(&pool->lock);
+    pool->closing = true;
+    pthread_cond_broadcast(&pool->changed);
+    pthread_mutex_unlock(&pool->lock);
+    bq_close(&pool->pending);
+
+    for (int w = 0; w < pool->nworkers; w++)
+    {
+        if (pool->workers[w].started)
+        {
+            pthread_join(pool->workers[w].thread, NULL);
+        }
+        matinv_destroy(pool->workers[w].ctx);
+    }
+
+    bq_destroy(&pool->pending);
+    pthread_cond_destroy(&pool->changed);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool->slots);
+    free(pool);
+}
+
+struct matinv_request *matinv_submit(struct matinv_pool *pool, int n, const double mat[n][n], double mat_inv[n][n],
+                                     matinv_callback callback, void *arg)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->free_list && !pool->closing)
+    {
+        pthread_cond_wait(&pool->changed, &pool->lock);
+    }
+    if (pool->closing)
+    {
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    struct matinv_request *req = pool->free_list;
+    pool->free_list = req->next_free;
+
+    req->n = n;
+    req->mat = &mat[0][0];
+    req->mat_inv = &mat_inv[0][0];
+    req->callback = callback;
+    req->arg = arg;
+    req->status = MATINV_PENDING;
+    req->cond = -1.0;
+    req->queued = true;
+    req->released = false;
+    pthread_mutex_unlock(&pool->lock);
+
+    /* The queue holds every slot, so this does not wait */
+    if (!bq_push(&pool->pending, req))
+    {
+        pthread_mutex_lock(&pool->lock);
+        req->queued = false;
+        req->status = MATINV_CANCELLED;
+        req->released = true;
+        recycle_locked(req);
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+    return req;
+}
+
+enum matinv_status matinv_poll(struct matinv_request *req)
+{
+    pthread_mutex_lock(&req->pool->lock);
+    enum matinv_status status = req->status;
+    pthread_mutex_unlock(&req->pool->lock);
+    return status;
+}
+
+enum matinv_status matinv_wait(struct matinv_request *req)
+{
+    struct matinv_pool *pool = req->pool;
+    pthread_mutex_lock(&pool->lock);
+    while (!finished(req->status))
+    {
+        pthread_cond_wait(&pool->changed, &pool->lock);
+    }
+    enum matinv_status status = req->status;
+    pthread_mutex_unlock(&pool->lock);
+    return status;
+}
+
+bool matinv_cancel(struct matinv_request *req)
+{
+    struct matinv_pool *pool = req->pool;
+    pthread_mutex_lock(&pool->lock);
+    bool cancelled = req->status == MATINV_PENDING;
+    if (cancelled)
+    {
+        /* The slot stays taken until a worker pops it off the queue */
+        req->status = MATINV_CANCELLED;
+        pthread_cond_broadcast(&pool->changed);
+    }
+    /* Once the lock is dropped the handle may be released and its slot reused by another submission */
+    matinv_callback callback = req->callback;
+    void *arg = req->arg;
+    pthread_mutex_unlock(&pool->lock);
+
+    if (cancelled && callback)
+    {
+        callback(req, MATINV_CANCELLED, arg);
+    }
+    return cancelled;
+}
+
+double matinv_request_condition(struct matinv_request *req)
+{
+    pthread_mutex_lock(&req->pool->lock);
+    double cond = req->status == MATINV_DONE ? req->cond : -1.0;
+    pthread_mutex_unlock(&req->pool->lock);
+    return cond;
+}
+
+void matinv_release(struct matinv_request *req)
+{
+    struct matinv_pool *pool = req->pool;
+    pthread_mutex_lock(&pool->lock);
+    if (req->status == MATINV_PENDING)
+    {
+        req->status = MATINV_CANCELLED;
+        pthread_cond_broadcast(&pool->changed);
+    }
+    req->released = true;
+    recycle_locked(req);
+    pthread_mutex_unlock(&pool->lock);
+}
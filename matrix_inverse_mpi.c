@@ -4,127 +4,192 @@
  *
  * Inverse the given matrix with inverse_matrix_mpi, called from the benchmarking function
  * benchmark_inversion to measure the performance of the parallel implementation.
- * Functions expect that the input is a square matrix.
+ * Functions expect that the input is a square matrix. The engines of all three
+ * precisions are generated from matrix_inverse_mpi_generic.h, which keeps one
+ * augmented matrix per node in a shared memory window.
  */
 
 #include "matrix_inverse_mpi.h"
+#include "mpi_comm_profiler.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
 #include <mpi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <float.h>
 #include <stdbool.h>
 
-#define EPSILON 1e-10
-
-void inverse_matrix_mpi(double **mat, int nrow, int ncol, double **mat_inv_parallel)
+/* Ranks that share memory with this one and the leaders of all nodes */
+struct mpi_nodes
 {
-    int rank, size;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
-    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    MPI_Comm comm;    /* The engine communicator they were split from */
+    MPI_Comm node;    /* The ranks of this node */
+    MPI_Comm leaders; /* Node rank 0 of every node, MPI_COMM_NULL on the other ranks */
+    int count;        /* Number of nodes */
+    int *node_of;     /* Node of every rank of comm, its leader's rank in leaders */
+};
+
+/* Communicator of the engine, MPI_COMM_NULL for MPI_COMM_WORLD, and its split by node once used */
+static MPI_Comm engine_comm = MPI_COMM_NULL;
+static struct mpi_nodes nodes = {MPI_COMM_NULL, MPI_COMM_NULL, MPI_COMM_NULL, 0, NULL};
+
+static MPI_Comm mpi_engine_comm(void)
+{
+    return engine_comm == MPI_COMM_NULL ? MPI_COMM_WORLD : engine_comm;
+}
 
-    if (nrow != ncol)
+void mpi_set_engine_comm(MPI_Comm comm)
+{
+    if (comm == engine_comm)
     {
-        if (rank == 0)
-        {
-            fprintf(stderr, "Matrix must be square for inversion.\n");
-        }
-        MPI_Abort(MPI_COMM_WORLD, 1);
+        return;
     }
-
-    int n = nrow;
-    double *augmented = malloc(n * 2 * n * sizeof(double)); // Contiguous memory
-
-    // Initialize augmented matrix [mat | I]
-    if (rank == 0)
+    if (nodes.node_of)
     {
-        for (int i = 0; i < n; i++)
+        MPI_Comm_free(&nodes.node);
+        if (nodes.leaders != MPI_COMM_NULL)
         {
-            for (int j = 0; j < n; j++)
-            {
-                augmented[i * 2 * n + j] = mat[i][j];
-                augmented[i * 2 * n + j + n] = (i == j) ? 1.0 : 0.0;
-            }
+            MPI_Comm_free(&nodes.leaders);
         }
+        free(nodes.node_of);
+        nodes.node_of = NULL;
     }
+    engine_comm = comm;
+}
 
-    // Broadcast augmented matrix to all processes
-    MPI_Bcast(augmented, n * 2 * n, MPI_DOUBLE, 0, MPI_COMM_WORLD);
-
-    // Gaussian elimination
-    for (int k = 0; k < n; k++)
+/* Split the engine communicator by node on first use. Its rank 0 leads node 0. */
+static const struct mpi_nodes *mpi_nodes(void)
+{
+    if (nodes.node_of)
     {
-        int pivot_rank = k % size;
-        if (rank == pivot_rank)
-        {
-            if (fabs(augmented[k * 2 * n + k]) < EPSILON)
-            {
-                fprintf(stderr, "Matrix is singular or nearly singular.\n");
-                MPI_Abort(MPI_COMM_WORLD, 1);
-            }
-
-            // Scale pivot row
-            double pivot = augmented[k * 2 * n + k];
-            for (int j = 0; j < 2 * n; j++)
-            {
-                augmented[k * 2 * n + j] /= pivot;
-            }
-        }
+        return &nodes;
+    }
 
-        MPI_Bcast(&augmented[k * 2 * n], 2 * n, MPI_DOUBLE, pivot_rank, MPI_COMM_WORLD);
+    MPI_Comm comm = mpi_engine_comm();
+    nodes.comm = comm;
 
-        // Eliminate other rows
-        for (int i = 0; i < n; i++)
-        {
-            if (i != k)
-            {
-                double factor = augmented[i * 2 * n + k];
-                for (int j = 0; j < 2 * n; j++)
-                {
-                    augmented[i * 2 * n + j] -= factor * augmented[k * 2 * n + j];
-                }
-            }
-        }
+    int rank, size, node_rank;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodes.node);
+    MPI_Comm_rank(nodes.node, &node_rank);
+    MPI_Comm_split(comm, node_rank == 0 ? 0 : MPI_UNDEFINED, rank, &nodes.leaders);
+
+    int node = 0;
+    if (nodes.leaders != MPI_COMM_NULL)
+    {
+        MPI_Comm_rank(nodes.leaders, &node);
     }
+    MPI_Bcast(&node, 1, MPI_INT, 0, nodes.node);
+    MPI_Allreduce(&node, &nodes.count, 1, MPI_INT, MPI_MAX, comm);
+    nodes.count++;
 
-    // Extract inverse matrix
-    if (rank == 0)
+    nodes.node_of = malloc(size * sizeof(int));
+    if (!nodes.node_of)
     {
-        for (int i = 0; i < n; i++)
-        {
-            for (int j = 0; j < n; j++)
-            {
-                mat_inv_parallel[i][j] = augmented[i * 2 * n + j + n];
-            }
-        }
+        perror("malloc (node map)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
+    MPI_Allgather(&node, 1, MPI_INT, nodes.node_of, 1, MPI_INT, comm);
+    return &nodes;
+}
 
-    free(augmented);
+/* Make the stores of every rank of the node to the shared window visible to all of them */
+static void mpi_node_sync(MPI_Win win, const struct mpi_nodes *nodes)
+{
+    MPI_Win_sync(win);
+    comm_prof_barrier(COMM_NODE_SYNC, nodes->node);
+    MPI_Win_sync(win);
 }
 
-void benchmark_inversion(double **mat, int nrow, int ncol)
+#define SCALAR_KIND SCALAR_KIND_DOUBLE
+#include "matrix_inverse_mpi_generic.h"
+#undef SCALAR_KIND
+
+#define SCALAR_KIND SCALAR_KIND_FLOAT
+#include "matrix_inverse_mpi_generic.h"
+#undef SCALAR_KIND
+
+#define SCALAR_KIND SCALAR_KIND_COMPLEX
+#include "matrix_inverse_mpi_generic.h"
+#undef SCALAR_KIND
+
+bool inverse_matrix_mpi(double **mat, int nrow, int ncol, double **mat_inv_parallel)
 {
-    double **mat_inv_parallel = malloc(nrow * sizeof(double *));
-    for (int i = 0; i < nrow; i++)
+    if (nrow != ncol)
     {
-        mat_inv_parallel[i] = malloc(ncol * sizeof(double));
+        int rank;
+        MPI_Comm_rank(mpi_engine_comm(), &rank);
+        if (rank == 0)
+        {
+            fprintf(stderr, "Matrix must be square for inversion.\n");
+        }
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
+    return inverse_matrix_mpi_rows_d(nrow, (const double *const *)mat, mat_inv_parallel);
+}
+
+bool benchmark_inversion(double **mat, int nrow, int ncol, double **mat_inv_parallel)
+{
     double start_time = MPI_Wtime();
 
-    inverse_matrix_mpi(mat, nrow, ncol, mat_inv_parallel);
+    bool ok = inverse_matrix_mpi(mat, nrow, ncol, mat_inv_parallel);
 
     double end_time = MPI_Wtime();
 
     int rank;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank); // Determines the Rank of process
 
-    if (rank == 0)
+    if (rank == 0 && !ok)
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+    }
+    else if (rank == 0)
     {
         double elapsed_time = (end_time - start_time) * 1000.0; // Convert seconds to milliseconds
 
         printf("Matrix inversion (Parallel) completed in %.3f ms for %dx%d matrix.\n", elapsed_time, nrow, ncol);
+        cond_report(stdout);
 
         // printf("Inverted Matrix:\n");
         // print_mat_pointer(nrow, ncol, mat_inv_parallel);
     }
+    return ok;
+}
+
+bool inverse_matrix_mpi_typed(enum scalar_type type, int n, const void *mat, void *mat_inv)
+{
+    switch (type)
+    {
+    case SCALAR_FLOAT:
+        return inverse_matrix_mpi_f(n, mat, mat_inv);
+    case SCALAR_COMPLEX:
+        return inverse_matrix_mpi_z(n, mat, mat_inv);
+    default:
+        return inverse_matrix_mpi_d(n, mat, mat_inv);
+    }
+}
+
+bool benchmark_inversion_typed(enum scalar_type type, int n, const void *mat, void *mat_inv)
+{
+    double start_time = MPI_Wtime();
+
+    bool ok = inverse_matrix_mpi_typed(type, n, mat, mat_inv);
+
+    double end_time = MPI_Wtime();
+
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (rank == 0 && !ok)
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+    }
+    else if (rank == 0)
+    {
+        printf("Matrix inversion (Parallel) completed in %.3f ms for %dx%d matrix.\n", (end_time - start_time) * 1000.0, n, n);
+        cond_report(stdout);
+    }
+    return ok;
 }
@@ -1,7 +1,35 @@
 #ifndef MPI_MATRIX_INVERSE_H
 #define MPI_MATRIX_INVERSE_H
 
-void inverse_matrix_mpi(double **mat, int nrow, int ncol, double **mat_inv_parallel);
-void benchmark_inversion(double **mat, int nrow, int ncol);
+#include <complex.h>
+#include <mpi.h>
+#include <stdbool.h>
+
+#include "helpers/scalar.h"
+
+/* Ranks the engine runs on, MPI_COMM_WORLD until set (MPI_COMM_NULL sets it back). Every rank of comm takes
+ * part in each inversion, "rank 0" below is rank 0 of comm. Collective over the previous communicator when
+ * an inversion already ran on it. */
+void mpi_set_engine_comm(MPI_Comm comm);
+
+/* Invert mat on rank 0 into mat_inv_parallel on rank 0. Returns false on every
+ * rank if the matrix is singular or its condition number exceeds the limit
+ * (see helpers/condition.h).
+ */
+bool inverse_matrix_mpi(double **mat, int nrow, int ncol, double **mat_inv_parallel);
+
+/* Times inverse_matrix_mpi, the inverse is left in mat_inv_parallel on rank 0 */
+bool benchmark_inversion(double **mat, int nrow, int ncol, double **mat_inv_parallel);
+
+/* The same on contiguous n x n arrays on rank 0 */
+bool inverse_matrix_mpi_d(int n, const double mat[n][n], double mat_inv[n][n]);
+bool inverse_matrix_mpi_f(int n, const float mat[n][n], float mat_inv[n][n]);
+bool inverse_matrix_mpi_z(int n, const double complex mat[n][n], double complex mat_inv[n][n]);
+
+/* Dispatch on the element type. Collective. */
+bool inverse_matrix_mpi_typed(enum scalar_type type, int n, const void *mat, void *mat_inv);
+
+/* Times inverse_matrix_mpi_typed */
+bool benchmark_inversion_typed(enum scalar_type type, int n, const void *mat, void *mat_inv);
 
 #endif // MPI_MATRIX_INVERSE_H
@@ -0,0 +1,280 @@
+/* Type-generic MPI inversion, instantiated by matrix_inverse_mpi.c for float, double and complex double.
+ *
+ * Gauss-Jordan on [A | I] with the rows dealt out cyclically: rank r owns
+ * rows r, r + size, ... and only ever updates those. The ranks of a node
+ * share one augmented matrix in an MPI-3 shared memory window instead of
+ * each holding a copy, and only the node leaders (see struct mpi_nodes) take
+ * part in the broadcasts: the input and every scaled pivot row cross the
+ * network once per node and land straight in the shared copy. The ranks
+ * are those of the engine communicator (mpi_set_engine_comm). No include
+ * guard, mpi.h must be included before.
+ */
+
+#include "helpers/scalar_template.h"
+
+/* 1-norm of the n x n matrix behind the row pointers */
+static REAL TYPED(mpi_norm1)(int n, const SCALAR *const *rows)
+{
+    REAL best = 0;
+    for (int j = 0; j < n; j++)
+    {
+        REAL sum = 0;
+        for (int i = 0; i < n; i++)
+        {
+            sum += SCALAR_ABS(rows[i][j]);
+        }
+        best = sum > best ? sum : best;
+    }
+    return best;
+}
+
+/* Collect the inverse half of the rows on rank 0. Each node holds the final
+ * values of its own ranks' rows only, so the leaders pack those and gather
+ * them; on a single node rank 0 reads the shared copy directly. */
+static void TYPED(gather_inverse)(int n, SCALAR aug[n][2 * n], const struct mpi_nodes *nodes, SCALAR *const *mat_inv)
+{
+    int rank, size;
+    MPI_Comm_rank(nodes->comm, &rank);
+    MPI_Comm_size(nodes->comm, &size);
+
+    if (nodes->count == 1)
+    {
+        if (rank == 0)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                for (int j = 0; j < n; j++)
+                {
+                    mat_inv[i][j] = aug[i][n + j];
+                }
+            }
+        }
+        return;
+    }
+    if (nodes->leaders == MPI_COMM_NULL)
+    {
+        return;
+    }
+
+    int node = nodes->node_of[rank];
+    int *counts = malloc(2 * nodes->count * sizeof(int));
+    SCALAR *packed = malloc(sizeof(SCALAR) * n * n);
+    if (!counts || !packed)
+    {
+        perror("malloc (inverse gather)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    int *displs = counts + nodes->count;
+    for (int c = 0; c < nodes->count; c++)
+    {
+        counts[c] = 0;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        counts[nodes->node_of[i % size]] += n;
+    }
+    displs[0] = 0;
+    for (int c = 1; c < nodes->count; c++)
+    {
+        displs[c] = displs[c - 1] + counts[c - 1];
+    }
+
+    /* Rows go out in ascending order, so rank 0 can put them back by their owners */
+    SCALAR *out = packed + displs[node];
+    for (int i = 0; i < n; i++)
+    {
+        if (nodes->node_of[i % size] == node)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                *out++ = aug[i][n + j];
+            }
+        }
+    }
+    comm_prof_gatherv(COMM_INVERSE_GATHER, rank == 0 ? MPI_IN_PLACE : packed + displs[node], counts[node], SCALAR_MPI,
+                      packed, counts, displs, SCALAR_MPI, 0, nodes->leaders);
+
+    if (rank == 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            const SCALAR *in = packed + displs[nodes->node_of[i % size]];
+            displs[nodes->node_of[i % size]] += n;
+            for (int j = 0; j < n; j++)
+            {
+                mat_inv[i][j] = in[j];
+            }
+        }
+    }
+
+    free(packed);
+    free(counts);
+}
+
+/* The engine proper, on row pointers that are only read on rank 0 */
+static bool TYPED(inverse_matrix_mpi_rows)(int n, const SCALAR *const *mat, SCALAR *const *mat_inv)
+{
+    const struct mpi_nodes *nodes = mpi_nodes();
+    int rank, size;
+    MPI_Comm_rank(nodes->comm, &rank);
+    MPI_Comm_size(nodes->comm, &size);
+    bool leader = nodes->leaders != MPI_COMM_NULL;
+    int node = nodes->node_of[rank];
+
+    comm_prof_engine_begin();
+
+    /* One augmented matrix per node, held by its leader and mapped by the other ranks */
+    SCALAR *base;
+    MPI_Win win;
+    MPI_Aint bytes = leader ? (MPI_Aint)sizeof(SCALAR) * n * 2 * n : 0;
+    if (MPI_Win_allocate_shared(bytes, sizeof(SCALAR), MPI_INFO_NULL, nodes->node, &base, &win) != MPI_SUCCESS)
+    {
+        fprintf(stderr, "Cannot allocate the shared augmented matrix.\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Aint shared_bytes;
+    int disp_unit;
+    MPI_Win_shared_query(win, 0, &shared_bytes, &disp_unit, &base);
+    SCALAR (*aug)[2 * n] = (SCALAR (*)[2 * n])base;
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, win);
+
+    PROF_BEGIN(PHASE_AUGMENT);
+    if (rank == 0)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                aug[i][j] = mat[i][j];
+                aug[i][n + j] = i == j;
+            }
+        }
+    }
+    PROF_END(PHASE_AUGMENT);
+
+    PROF_BEGIN(PHASE_MPI_COMM);
+    if (leader && nodes->count > 1)
+    {
+        comm_prof_bcast(COMM_MATRIX_BCAST, aug, n * 2 * n, SCALAR_MPI, 0, nodes->leaders);
+    }
+    mpi_node_sync(win, nodes);
+    PROF_END(PHASE_MPI_COMM);
+
+    /* Pivots are judged relative to the norm of the input */
+    double anorm = rank == 0 ? TYPED(mpi_norm1)(n, mat) : 0.0;
+    comm_prof_bcast(COMM_SCALAR_BCAST, &anorm, 1, MPI_DOUBLE, 0, nodes->comm);
+    REAL tol = REAL_EPSILON * (REAL)anorm;
+
+    /* A singular pivot zeroes its row instead of aborting, so every rank still takes part in every step and a
+     * caller inverting many matrices (mpi_farm.c) survives it */
+    bool singular = false;
+    for (int k = 0; k < n; k++)
+    {
+        int owner = k % size;
+        PROF_BEGIN(PHASE_ELIMINATION);
+        if (rank == owner)
+        {
+            bool zero_pivot = SCALAR_ABS(aug[k][k]) <= tol;
+            singular = singular || zero_pivot;
+
+            SCALAR scale = zero_pivot ? 0 : 1 / aug[k][k];
+#pragma omp simd
+            for (int j = k; j <= n + k; j++)
+            {
+                aug[k][j] *= scale;
+            }
+        }
+        PROF_END(PHASE_ELIMINATION);
+
+        /* The owner's leader sends the scaled row from its shared copy, the other leaders receive it into theirs.
+         * It is zero outside columns k .. n + k, only those are sent. */
+        PROF_BEGIN(PHASE_MPI_COMM);
+        if (nodes->count > 1)
+        {
+            int root = nodes->node_of[owner];
+            if (node == root)
+            {
+                mpi_node_sync(win, nodes);
+            }
+            if (leader)
+            {
+                comm_prof_bcast(COMM_PIVOT_BCAST, &aug[k][k], n + 1, SCALAR_MPI, root, nodes->leaders);
+            }
+        }
+        mpi_node_sync(win, nodes);
+        PROF_END(PHASE_MPI_COMM);
+
+        /* Nobody else writes these rows, and row k stays put until the next sync. Without pivoting
+         * every row is zero left of column k and right of column n + k at step k. */
+        PROF_BEGIN(PHASE_ROW_UPDATE);
+        for (int i = rank; i < n; i += size)
+        {
+            if (i != k)
+            {
+                SCALAR factor = aug[i][k];
+#pragma omp simd
+                for (int j = k; j <= n + k; j++)
+                {
+                    aug[i][j] -= factor * aug[k][j];
+                }
+            }
+        }
+        PROF_END(PHASE_ROW_UPDATE);
+    }
+    mpi_node_sync(win, nodes);
+    comm_prof_allreduce(COMM_SINGULAR_REDUCE, MPI_IN_PLACE, &singular, 1, MPI_C_BOOL, MPI_LOR, nodes->comm);
+    if (singular && rank == 0)
+    {
+        fprintf(stderr, "Matrix is singular or nearly singular.\n");
+    }
+
+    /* Every rank updates its n / size rows, less the pivot ones, over n + 1 columns at each of the n steps */
+    PROF_WORK(PHASE_ROW_UPDATE, 2.0 * (n + 1) * n * (n - 1) / size, 2.0 * sizeof(SCALAR) * (n + 1) * n * (n - 1) / size);
+
+    PROF_BEGIN(PHASE_EXTRACT);
+    TYPED(gather_inverse)(n, aug, nodes, mat_inv);
+    PROF_END(PHASE_EXTRACT);
+
+    /* The inverse is at hand, so the 1-norm condition number is exact */
+    bool ok = !singular;
+    PROF_BEGIN(PHASE_CONDITION);
+    if (ok && rank == 0)
+    {
+        ok = cond_accept(anorm * TYPED(mpi_norm1)(n, (const SCALAR *const *)mat_inv));
+    }
+    PROF_END(PHASE_CONDITION);
+    comm_prof_bcast(COMM_SCALAR_BCAST, &ok, 1, MPI_C_BOOL, 0, nodes->comm);
+
+    MPI_Win_unlock_all(win);
+    MPI_Win_free(&win);
+    comm_prof_engine_end();
+    return ok;
+}
+
+bool TYPED(inverse_matrix_mpi)(int n, const SCALAR mat[n][n], SCALAR mat_inv[n][n])
+{
+    int rank;
+    MPI_Comm_rank(mpi_engine_comm(), &rank);
+
+    /* The matrices only exist on rank 0 */
+    const SCALAR **rows = NULL;
+    if (rank == 0)
+    {
+        rows = malloc(2 * n * sizeof(SCALAR *));
+        if (!rows)
+        {
+            perror("malloc (row pointers)");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            rows[i] = mat[i];
+            rows[n + i] = mat_inv[i];
+        }
+    }
+
+    bool ok = TYPED(inverse_matrix_mpi_rows)(n, rows, rank == 0 ? (SCALAR *const *)(rows + n) : NULL);
+    free(rows);
+    return ok;
+}
@@ -3,15 +3,14 @@
 
 #include <stdbool.h>
 
+#include "inversion_workspace.h"
+
 bool invert_matrix(int nrow, int ncol, double mat[nrow][ncol], double mat_inv[nrow][ncol]);
-bool gaussian_elimination(int nrow, int ncol, double mat[nrow][ncol]);
-bool rref(int nrow, int ncol, double mat[nrow][ncol]);
 
-void augment_mat_ser(int n, const double mat[n][n], double mat_aug[n][2 * n]);
-void extract_inverse_ser(int nrow, int ncol, const double mat_aug[nrow][ncol], double mat_inv[nrow][nrow]);
-void multiply_row_ser(int row_idx, double n, int nrow, int ncol, double mat[nrow][ncol]);
-void subtract_row_ser(int row_idx, int target_idx, double coeff, int nrow, int ncol, double mat[nrow][ncol]);
+/* Serial inversion through the caller's workspace, mat is left unchanged. Allocation-free and
+ * reentrant: the condition number and its limit live in ws. */
+bool invert_matrix_ws(int n, double mat[n][n], struct inversion_workspace *ws, double mat_inv[n][n]);
 
-void benchmark_matrix_inversion(int nrow, int ncol, double mat[nrow][ncol], double mat_inv[nrow][ncol]);
+bool benchmark_matrix_inversion(int nrow, int ncol, double mat[nrow][ncol], double mat_inv[nrow][ncol]);
 
-#endif
\ No newline at end of file
+#endif
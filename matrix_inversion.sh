@@ -11,6 +11,10 @@ module load openmpi-4.0.4
 
 export OMP_DISPLAY_ENV=TRUE
 
+# Keep each thread on one core, next to the rows it first touched
+export OMP_PLACES=cores
+export OMP_PROC_BIND=close
+
 # Define file paths
 MATRIX_FILES=(
               "HPC.ParallelMatrixInversion/performance_test_matrices/matrix_5x5_01.txt"
@@ -38,9 +42,8 @@ MATRIX_FILES=(
               "HPC.ParallelMatrixInversion/performance_test_matrices/matrix_3000x3000_01.txt"
               )
 
-# Loop through files and execute the program for each
-for FILE_PATH in "${MATRIX_FILES[@]}"; do
-    echo "Processing file: $FILE_PATH"
-    mpiexec ./HPC.ParallelMatrixInversion/main_program -path="$FILE_PATH"
-
-done
\ No newline at end of file
+# Invert them all in one run: rank 0 hands the matrices out, the other ranks invert them side by side
+MANIFEST=$(mktemp)
+printf "%s\n" "${MATRIX_FILES[@]}" > "$MANIFEST"
+mpiexec ./HPC.ParallelMatrixInversion/main_program -manifest="$MANIFEST"
+rm -f "$MANIFEST"
@@ -0,0 +1,689 @@
+/**
+ * @file matrix_inversion_blocks.c
+ * @brief Inversion of the independent diagonal blocks of a permuted block-diagonal matrix
+ *
+ * The blocks are the connected components of the graph joining row i to
+ * column j for every nonzero a[i][j] (rows are nodes 0 .. n - 1, columns
+ * n .. 2n - 1). Each thread runs union-find over its own rows with a
+ * forest of its own, and the forests are merged afterwards, so no thread
+ * waits on another while scanning.
+ *
+ * The band path factors P·B = L·U with partial pivoting among the p rows
+ * below the diagonal. Like LAPACK's gbtrf, the exchanges are applied to
+ * the columns from k on only, so L is kept as the sequence of exchanges
+ * and column eliminations of each step, and U has upper bandwidth p + q.
+ * The inverse is then solved for BLOCKS_BAND_RHS columns of the identity
+ * at a time, starting the forward sweep p rows above the first of them.
+ * */
+
+#include "matrix_inversion_blocks.h"
+#include "matrix_inversion.h"
+#include "matrix_inversion_parallel.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+/* Blocks of at least this many rows are inverted one at a time with all threads, smaller ones serially side by side */
+#define BLOCKS_PAR_MIN 256
+
+/* A block of m rows takes the band path if 2p + q + 1 <= m / BLOCKS_BAND_RATIO */
+#define BLOCKS_BAND_RATIO 8
+
+/* Columns of the inverse solved together, one cache line of each row of the result */
+#define BLOCKS_BAND_RHS 8
+
+/* What the last inversion found, for benchmark_matrix_inversion_blocks */
+static int last_nblocks, last_largest, last_banded;
+
+static int uf_find(int *parent, int v)
+{
+    while (parent[v] != v)
+    {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+/* The smaller root wins, so the forest does not depend on the order of the unions */
+static void uf_union(int *parent, int a, int b)
+{
+    a = uf_find(parent, a);
+    b = uf_find(parent, b);
+    if (a < b)
+    {
+        parent[b] = a;
+    }
+    else if (b < a)
+    {
+        parent[a] = b;
+    }
+}
+
+bool find_blocks(int n, const double mat[n][n], struct block_structure *bs, bool *singular)
+{
+    int threads = omp_get_max_threads();
+    int nodes = 2 * n;
+    int *forest = malloc((size_t)(threads + 1) * nodes * sizeof(int));
+    int *label = malloc(nodes * sizeof(int));
+    int *count = calloc(2 * (size_t)n + 1, sizeof(int));
+    bs->n = n;
+    bs->nblocks = 0;
+    bs->start = malloc((n + 1) * sizeof(int));
+    bs->rows = malloc(n * sizeof(int));
+    bs->cols = malloc(n * sizeof(int));
+    *singular = false;
+    if (!forest || !label || !count || !bs->start || !bs->rows || !bs->cols)
+    {
+        perror("malloc (block structure)");
+        free(count);
+        free(label);
+        free(forest);
+        block_structure_free(bs);
+        return false;
+    }
+
+    /* forest[0 .. nodes) is the merged forest, thread t builds its own behind it */
+#pragma omp parallel num_threads(threads)
+    {
+        int *local = forest + (size_t)(omp_get_thread_num() + 1) * nodes;
+        for (int v = 0; v < nodes; v++)
+        {
+            local[v] = v;
+        }
+#pragma omp for schedule(static)
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                if (mat[i][j] != 0.0)
+                {
+                    uf_union(local, i, n + j);
+                }
+            }
+        }
+    }
+
+    int *parent = forest;
+    for (int v = 0; v < nodes; v++)
+    {
+        parent[v] = v;
+    }
+    for (int t = 0; t < threads; t++)
+    {
+        int *local = forest + (size_t)(t + 1) * nodes;
+        for (int v = 0; v < nodes; v++)
+        {
+            int root = uf_find(local, v);
+            if (root != v)
+            {
+                uf_union(parent, v, root);
+            }
+        }
+    }
+
+    /* Blocks numbered in the order of their first row; count[2k] rows and count[2k + 1] columns of block k */
+    for (int v = 0; v < nodes; v++)
+    {
+        label[v] = -1;
+    }
+    int nblocks = 0;
+    for (int i = 0; i < n; i++)
+    {
+        int root = uf_find(parent, i);
+        if (label[root] < 0)
+        {
+            label[root] = nblocks++;
+        }
+        count[2 * label[root]]++;
+    }
+    for (int j = 0; j < n && !*singular; j++)
+    {
+        int root = uf_find(parent, n + j);
+        /* A column without nonzeros has no rows */
+        *singular = label[root] < 0;
+        if (!*singular)
+        {
+            count[2 * label[root] + 1]++;
+        }
+    }
+    for (int k = 0; k < nblocks && !*singular; k++)
+    {
+        *singular = count[2 * k] != count[2 * k + 1];
+    }
+
+    if (!*singular)
+    {
+        bs->nblocks = nblocks;
+        bs->start[0] = 0;
+        for (int k = 0; k < nblocks; k++)
+        {
+            bs->start[k + 1] = bs->start[k] + count[2 * k];
+            count[2 * k] = count[2 * k + 1] = bs->start[k];
+        }
+        for (int i = 0; i < n; i++)
+        {
+            int k = label[uf_find(parent, i)];
+            bs->rows[count[2 * k]++] = i;
+        }
+        for (int j = 0; j < n; j++)
+        {
+            int k = label[uf_find(parent, n + j)];
+            bs->cols[count[2 * k + 1]++] = j;
+        }
+    }
+
+    free(count);
+    free(label);
+    free(forest);
+    if (*singular)
+    {
+        block_structure_free(bs);
+        return false;
+    }
+    return true;
+}
+
+void block_structure_free(struct block_structure *bs)
+{
+    free(bs->start);
+    free(bs->rows);
+    free(bs->cols);
+    bs->start = bs->rows = bs->cols = NULL;
+    bs->nblocks = 0;
+}
+
+/* Lower and upper bandwidth of the m x m array a, each row is scanned from both ends up to its outermost nonzeros */
+static void bandwidths(int m, const double a[m][m], int *lower, int *upper)
+{
+    int p = 0, q = 0;
+#pragma omp parallel for schedule(static) reduction(max : p, q) if (m >= BLOCKS_PAR_MIN)
+    for (int i = 0; i < m; i++)
+    {
+        int first = 0, last = m - 1;
+        while (first < i && a[i][first] == 0.0)
+        {
+            first++;
+        }
+        while (last > i && a[i][last] == 0.0)
+        {
+            last--;
+        }
+        p = i - first > p ? i - first : p;
+        q = last - i > q ? last - i : q;
+    }
+    *lower = p;
+    *upper = q;
+}
+
+static bool is_banded(int m, int p, int q)
+{
+    return (2 * p + q + 1) * BLOCKS_BAND_RATIO <= m;
+}
+
+/* P·A = L·U in place within the band, L below the diagonal as the multipliers of each step */
+static bool band_factor(int m, double a[m][m], int p, int q, int piv[m], double tol)
+{
+    int w = p + q;
+    for (int k = 0; k < m; k++)
+    {
+        int last = k + p < m - 1 ? k + p : m - 1;
+        int best = k;
+        for (int i = k + 1; i <= last; i++)
+        {
+            if (fabs(a[i][k]) > fabs(a[best][k]))
+            {
+                best = i;
+            }
+        }
+        if (fabs(a[best][k]) <= tol)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            return false;
+        }
+        piv[k] = best;
+
+        int jend = k + w < m - 1 ? k + w : m - 1;
+        if (best != k)
+        {
+            for (int j = k; j <= jend; j++)
+            {
+                double tmp = a[k][j];
+                a[k][j] = a[best][j];
+                a[best][j] = tmp;
+            }
+        }
+
+        double scale = 1.0 / a[k][k];
+        for (int i = k + 1; i <= last; i++)
+        {
+            double l = a[i][k] * scale;
+            a[i][k] = l;
+            if (l == 0.0)
+            {
+                continue;
+            }
+#pragma omp simd
+            for (int j = k + 1; j <= jend; j++)
+            {
+                a[i][j] -= l * a[k][j];
+            }
+        }
+    }
+    return true;
+}
+
+/* Columns j0 .. j0 + g - 1 of the inverse from the band factors, through the m x BLOCKS_BAND_RHS scratch y */
+static void band_solve_columns(int m, const double a[m][m], int p, int q, const int piv[m], int j0, int g,
+                               double y[m][BLOCKS_BAND_RHS], double x[m][m])
+{
+    memset(y, 0, sizeof(double[m][BLOCKS_BAND_RHS]));
+    for (int r = 0; r < g; r++)
+    {
+        y[j0 + r][r] = 1.0;
+    }
+
+    /* The exchanges before row j0 - p cannot reach the unit entries */
+    for (int k = j0 - p > 0 ? j0 - p : 0; k < m; k++)
+    {
+        if (piv[k] != k)
+        {
+            for (int r = 0; r < BLOCKS_BAND_RHS; r++)
+            {
+                double tmp = y[k][r];
+                y[k][r] = y[piv[k]][r];
+                y[piv[k]][r] = tmp;
+            }
+        }
+        int last = k + p < m - 1 ? k + p : m - 1;
+        for (int i = k + 1; i <= last; i++)
+        {
+            double l = a[i][k];
+#pragma omp simd
+            for (int r = 0; r < BLOCKS_BAND_RHS; r++)
+            {
+                y[i][r] -= l * y[k][r];
+            }
+        }
+    }
+
+    int w = p + q;
+    for (int i = m - 1; i >= 0; i--)
+    {
+        int jend = i + w < m - 1 ? i + w : m - 1;
+        for (int j = i + 1; j <= jend; j++)
+        {
+            double u = a[i][j];
+#pragma omp simd
+            for (int r = 0; r < BLOCKS_BAND_RHS; r++)
+            {
+                y[i][r] -= u * y[j][r];
+            }
+        }
+        double scale = 1.0 / a[i][i];
+        for (int r = 0; r < BLOCKS_BAND_RHS; r++)
+        {
+            y[i][r] *= scale;
+        }
+        memcpy(&x[i][j0], y[i], g * sizeof(double));
+    }
+}
+
+/* Invert the banded m x m array a (overwritten by its factors) into x, with all threads if parallel */
+static bool band_invert(int m, double a[m][m], int p, int q, double x[m][m], bool parallel)
+{
+    int *piv = malloc(m * sizeof(int));
+    if (!piv)
+    {
+        perror("malloc (band pivots)");
+        return false;
+    }
+
+    PROF_BEGIN(PHASE_ELIMINATION);
+    bool ok = band_factor(m, a, p, q, piv, cond_pivot_tolerance(m, m, a));
+    PROF_END(PHASE_ELIMINATION);
+    PROF_WORK(PHASE_ELIMINATION, 2.0 * m * p * (p + q), 16.0 * m * (p + q + 1));
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_RREF);
+#pragma omp parallel if (parallel)
+        {
+            double (*y)[BLOCKS_BAND_RHS] = malloc(sizeof(double[m][BLOCKS_BAND_RHS]));
+            if (!y)
+            {
+                perror("malloc (band solve)");
+#pragma omp atomic write
+                ok = false;
+            }
+            /* Later columns start their forward sweep later, so the groups are dealt out as threads come free */
+#pragma omp for schedule(dynamic)
+            for (int j0 = 0; j0 < m; j0 += BLOCKS_BAND_RHS)
+            {
+                if (y)
+                {
+                    band_solve_columns(m, a, p, q, piv, j0, m - j0 < BLOCKS_BAND_RHS ? m - j0 : BLOCKS_BAND_RHS, y, x);
+                }
+            }
+            free(y);
+        }
+        PROF_END(PHASE_RREF);
+        PROF_WORK(PHASE_RREF, 2.0 * m * m * (1.5 * p + q), 8.0 * m * m);
+    }
+
+    free(piv);
+    return ok;
+}
+
+/* Serial inversions of the small blocks, one set of scratch buffers per thread */
+struct small_scratch
+{
+    double *block;
+    double *inv;
+    struct inversion_workspace ws;
+};
+
+static bool alloc_small_scratch(struct small_scratch *s, int m)
+{
+    s->block = malloc(sizeof(double[m][m]));
+    s->inv = malloc(sizeof(double[m][m]));
+    s->ws = (struct inversion_workspace){malloc(sizeof(double[m][2 * m])), malloc(2 * m * sizeof(int)),
+                                         malloc(4 * m * sizeof(double)), 0, cond_get_limit(), -1.0};
+    return s->block && s->inv && s->ws.aug && s->ws.perm && s->ws.work;
+}
+
+static void free_small_scratch(struct small_scratch *s)
+{
+    free(s->block);
+    free(s->inv);
+    free(s->ws.aug);
+    free(s->ws.perm);
+    free(s->ws.work);
+}
+
+/* B = A[rows, cols] */
+static void gather_block(int n, const double mat[n][n], int m, const int *rows, const int *cols, double b[m][m], bool parallel)
+{
+#pragma omp parallel for schedule(static) if (parallel)
+    for (int a = 0; a < m; a++)
+    {
+        for (int c = 0; c < m; c++)
+        {
+            b[a][c] = mat[rows[a]][cols[c]];
+        }
+    }
+}
+
+/* A^-1[cols, rows] = B^-1 */
+static void scatter_inverse(int n, double mat_inv[n][n], int m, const int *rows, const int *cols, const double x[m][m], bool parallel)
+{
+#pragma omp parallel for schedule(static) if (parallel)
+    for (int c = 0; c < m; c++)
+    {
+        for (int a = 0; a < m; a++)
+        {
+            mat_inv[cols[c]][rows[a]] = x[c][a];
+        }
+    }
+}
+
+/* Block numbers by decreasing size, ties in block order, by counting sort on the sizes */
+static bool order_by_size(const struct block_structure *bs, int *order)
+{
+    int n = bs->n;
+    int *slot = calloc(n + 2, sizeof(int));
+    if (!slot)
+    {
+        return false;
+    }
+    for (int k = 0; k < bs->nblocks; k++)
+    {
+        slot[n - (bs->start[k + 1] - bs->start[k]) + 1]++;
+    }
+    for (int key = 1; key <= n + 1; key++)
+    {
+        slot[key] += slot[key - 1];
+    }
+    for (int k = 0; k < bs->nblocks; k++)
+    {
+        order[slot[n - (bs->start[k + 1] - bs->start[k])]++] = k;
+    }
+    free(slot);
+    return true;
+}
+
+/* Every entry outside the blocks of the inverse is zero */
+static void clear_inverse(int n, double mat_inv[n][n])
+{
+    PROF_BEGIN(PHASE_PARTITION);
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++)
+    {
+        memset(mat_inv[i], 0, n * sizeof(double));
+    }
+    PROF_END(PHASE_PARTITION);
+}
+
+/* The whole matrix is one block: the engine for its size, or the band path on a copy */
+static bool invert_single_block(int n, double mat[n][n], double mat_inv[n][n])
+{
+    int p, q;
+    PROF_BEGIN(PHASE_PARTITION);
+    bandwidths(n, mat, &p, &q);
+    PROF_END(PHASE_PARTITION);
+    if (!is_banded(n, p, q))
+    {
+        return n >= BLOCKS_PAR_MIN ? invert_matrix_par(n, n, mat, mat_inv) : invert_matrix(n, n, mat, mat_inv);
+    }
+
+    last_banded = 1;
+    double (*a)[n] = malloc(sizeof(double[n][n]));
+    if (!a)
+    {
+        perror("malloc (band factors)");
+        return false;
+    }
+    memcpy(a, mat, sizeof(double[n][n]));
+    bool ok = band_invert(n, a, p, q, mat_inv, true);
+    free(a);
+    return ok && cond_accept(cond_norm1(n, n, mat, 0) * cond_norm1(n, n, mat_inv, 0));
+}
+
+/* One large block with all threads: gathered, inverted by the OpenMP engine or the band path, scattered */
+static bool invert_large_block(int n, double mat[n][n], double mat_inv[n][n], const struct block_structure *bs, int k,
+                               double *block, double *inv)
+{
+    int s = bs->start[k], m = bs->start[k + 1] - s;
+    double (*b)[m] = (double (*)[m])block;
+    double (*x)[m] = (double (*)[m])inv;
+
+    PROF_BEGIN(PHASE_PARTITION);
+    gather_block(n, mat, m, bs->rows + s, bs->cols + s, b, true);
+    int p, q;
+    bandwidths(m, b, &p, &q);
+    PROF_END(PHASE_PARTITION);
+
+    bool ok;
+    if (is_banded(m, p, q))
+    {
+        last_banded++;
+        ok = band_invert(m, b, p, q, x, true);
+    }
+    else
+    {
+        ok = invert_matrix_par(m, m, b, x);
+    }
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_PARTITION);
+        scatter_inverse(n, mat_inv, m, bs->rows + s, bs->cols + s, x, true);
+        PROF_END(PHASE_PARTITION);
+    }
+    return ok;
+}
+
+/* One small block on the calling thread */
+static bool invert_small_block(int n, double mat[n][n], double mat_inv[n][n], const struct block_structure *bs, int k,
+                               struct small_scratch *scratch, int *banded)
+{
+    int s = bs->start[k], m = bs->start[k + 1] - s;
+    double (*b)[m] = (double (*)[m])scratch->block;
+    double (*x)[m] = (double (*)[m])scratch->inv;
+
+    PROF_BEGIN(PHASE_PARTITION);
+    gather_block(n, mat, m, bs->rows + s, bs->cols + s, b, false);
+    int p, q;
+    bandwidths(m, b, &p, &q);
+    PROF_END(PHASE_PARTITION);
+
+    bool ok;
+    if (is_banded(m, p, q))
+    {
+        (*banded)++;
+        ok = band_invert(m, b, p, q, x, false);
+    }
+    else
+    {
+        ok = invert_matrix_ws(m, b, &scratch->ws, x);
+    }
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_PARTITION);
+        scatter_inverse(n, mat_inv, m, bs->rows + s, bs->cols + s, x, false);
+        PROF_END(PHASE_PARTITION);
+    }
+    return ok;
+}
+
+bool invert_matrix_blocks(int n, double mat[n][n], double mat_inv[n][n])
+{
+    struct block_structure bs;
+    bool singular;
+    last_nblocks = last_largest = last_banded = 0;
+
+    PROF_BEGIN(PHASE_PARTITION);
+    bool found = find_blocks(n, mat, &bs, &singular);
+    PROF_END(PHASE_PARTITION);
+    if (!found)
+    {
+        if (singular)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+        }
+        return false;
+    }
+    last_nblocks = bs.nblocks;
+
+    /* A single block keeps the natural order of the rows and columns, nothing to gather */
+    if (bs.nblocks == 1)
+    {
+        last_largest = n;
+        block_structure_free(&bs);
+        return invert_single_block(n, mat, mat_inv);
+    }
+
+    /* Largest first: the big blocks one by one, then the small ones in order of decreasing work */
+    int *order = malloc(bs.nblocks * sizeof(int));
+    if (!order || !order_by_size(&bs, order))
+    {
+        perror("malloc (block order)");
+        free(order);
+        block_structure_free(&bs);
+        return false;
+    }
+    last_largest = bs.start[order[0] + 1] - bs.start[order[0]];
+
+    clear_inverse(n, mat_inv);
+
+    bool ok = true;
+    int first_small = 0;
+    if (last_largest >= BLOCKS_PAR_MIN)
+    {
+        size_t bytes = sizeof(double[last_largest][last_largest]);
+        double *block = malloc(bytes), *inv = malloc(bytes);
+        ok = block && inv;
+        if (!ok)
+        {
+            perror("malloc (block)");
+        }
+        for (; ok && first_small < bs.nblocks; first_small++)
+        {
+            int k = order[first_small];
+            if (bs.start[k + 1] - bs.start[k] < BLOCKS_PAR_MIN)
+            {
+                break;
+            }
+            ok = invert_large_block(n, mat, mat_inv, &bs, k, block, inv);
+        }
+        free(inv);
+        free(block);
+    }
+
+    if (ok && first_small < bs.nblocks)
+    {
+        int k0 = order[first_small];
+        int max_small = bs.start[k0 + 1] - bs.start[k0];
+        int banded = 0;
+#pragma omp parallel reduction(+ : banded)
+        {
+            struct small_scratch scratch;
+            if (!alloc_small_scratch(&scratch, max_small))
+            {
+                perror("malloc (block workspace)");
+#pragma omp atomic write
+                ok = false;
+            }
+#pragma omp barrier
+#pragma omp for schedule(dynamic)
+            for (int b = first_small; b < bs.nblocks; b++)
+            {
+                bool go;
+#pragma omp atomic read
+                go = ok;
+                if (go && !invert_small_block(n, mat, mat_inv, &bs, order[b], &scratch, &banded))
+                {
+#pragma omp atomic write
+                    ok = false;
+                }
+            }
+            free_small_scratch(&scratch);
+        }
+        last_banded += banded;
+    }
+
+    free(order);
+    block_structure_free(&bs);
+
+    /* A^-1 is at hand, so the 1-norm condition number of the whole matrix is exact */
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_CONDITION);
+        ok = cond_accept(cond_norm1(n, n, mat, 0) * cond_norm1(n, n, mat_inv, 0));
+        PROF_END(PHASE_CONDITION);
+    }
+    return ok;
+}
+
+bool benchmark_matrix_inversion_blocks(int n, double mat[n][n], double mat_inv[n][n])
+{
+    double start = now_ms();
+    if (!invert_matrix_blocks(n, mat, mat_inv))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double elapsed_time = now_ms() - start;
+
+    printf("Matrix inversion (Blocks) completed in %.3f ms for %dx%d matrix.\n", elapsed_time, n, n);
+    cond_report(stdout);
+    printf("Blocks: %d independent blocks, the largest %dx%d, %d inverted through the band path, %d threads.\n", last_nblocks,
+           last_largest, last_largest, last_banded, omp_get_max_threads());
+    return true;
+}
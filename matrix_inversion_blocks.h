@@ -0,0 +1,42 @@
+#ifndef MATRIX_INVERSION_BLOCKS_H
+#define MATRIX_INVERSION_BLOCKS_H
+#include <stdbool.h>
+
+/* Inversion of row and column permutations of block-diagonal matrices.
+ *
+ * Rows and columns are the two sides of a bipartite graph with an edge
+ * for every nonzero a[i][j]. Its connected components are independent
+ * square blocks B_k = A[R_k, C_k], with no nonzero outside them, so
+ * A^-1[C_k, R_k] = B_k^-1 and A^-1 is zero everywhere else. A component
+ * with more rows than columns (a zero row, say) makes A singular.
+ *
+ * Each block is gathered, keeping the order of its rows and columns, and
+ * inverted by an engine that fits its size: small blocks serially, many
+ * at a time, large ones with all threads one after the other. A block
+ * whose nonzeros lie within a narrow band around the diagonal is factored
+ * as a band LU instead, O(m·p·(p + q)) for lower and upper bandwidths p
+ * and q, and its inverse solved column by column in O(m^2·(p + q)). A
+ * single dense component costs one extra O(n^2) pass over the matrix.
+ */
+
+struct block_structure
+{
+    int n;
+    int nblocks;
+    int *start;     /* nblocks + 1 offsets into rows and cols */
+    int *rows;      /* Rows of block k in rows[start[k] .. start[k + 1]), ascending */
+    int *cols;      /* Columns of block k in the same range of cols */
+};
+
+/* Split mat into its independent blocks. Returns false if out of memory or if a block is not square,
+ * *singular tells the two apart. Release with block_structure_free. */
+bool find_blocks(int n, const double mat[n][n], struct block_structure *bs, bool *singular);
+
+void block_structure_free(struct block_structure *bs);
+
+/* Invert the n x n matrix mat into mat_inv block by block, mat is left unchanged */
+bool invert_matrix_blocks(int n, double mat[n][n], double mat_inv[n][n]);
+
+bool benchmark_matrix_inversion_blocks(int n, double mat[n][n], double mat_inv[n][n]);
+
+#endif
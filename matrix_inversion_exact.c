@@ -0,0 +1,767 @@
+/**
+ * @file matrix_inversion_exact.c
+ * @brief Exact rational inversion through modular images and Chinese remaindering
+ *
+ * Each prime p gives, by Gauss-Jordan over GF(p), det(K) mod p and
+ * K^-1 mod p, hence adj(K) = det(K)·K^-1 mod p. The images are combined
+ * with Garner's algorithm: every entry x keeps its mixed-radix digits
+ *
+ *   x = v_0 + v_1·p_0 + v_2·p_0·p_1 + ...,   |v_k| < p_k / 2
+ *
+ * and prime k adds the digit v_k = (x mod p_k - the sum so far)·(p_0 ··· p_k-1)^-1,
+ * all in single-word arithmetic. A zero digit means the new prime left the
+ * entry unchanged, which is the early termination test. An early stop is
+ * only accepted once K·N = d·I holds modulo a fresh prime q that took no
+ * part in the reconstruction, checked in O(n^2) as K·(N·r) = d·r for a
+ * random vector r mod q. The big integers are only built once at the end,
+ * by Horner's rule over the digits.
+ *
+ * The modular arithmetic is Montgomery multiplication with R = 2^64 on
+ * primes below 2^62, three 64-bit products and no division per step.
+ * */
+
+#include "matrix_inversion_exact.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+/* Digits after the decimal point tried before taking the entries as binary doubles */
+#define EXACT_MAX_DECIMALS 9
+
+/* Consecutive primes that must change no entry before the reconstruction is trusted. A stale entry
+ * survives a prime only if the prime divides its distance to the true value, which has at most a few
+ * hundred prime factors of that size among the ~2^56 primes near 2^62. */
+#define EXACT_STABLE_PRIMES 2
+
+/* The primes are the largest ones below this, in decreasing order */
+#define EXACT_PRIME_LIMIT (1ULL << 62)
+
+/* Montgomery arithmetic modulo an odd p < 2^62 */
+struct modulus
+{
+    uint64_t p;
+    uint64_t pinv; /* -p^-1 mod 2^64 */
+    uint64_t r2;   /* 2^128 mod p */
+};
+
+static void modulus_init(struct modulus *m, uint64_t p)
+{
+    uint64_t inv = p;
+    for (int k = 0; k < 5; k++)
+    {
+        inv *= 2 - p * inv;
+    }
+    uint64_t r = (uint64_t)(((uint128_t)1 << 64) % p);
+    m->p = p;
+    m->pinv = -inv;
+    m->r2 = (uint64_t)((uint128_t)r * r % p);
+}
+
+/* a·b·2^-64 mod p */
+static inline uint64_t mont_mul(const struct modulus *m, uint64_t a, uint64_t b)
+{
+    uint128_t t = (uint128_t)a * b;
+    uint64_t q = (uint64_t)t * m->pinv;
+    uint64_t u = (uint64_t)((t + (uint128_t)q * m->p) >> 64);
+    return u >= m->p ? u - m->p : u;
+}
+
+static inline uint64_t mod_sub(uint64_t a, uint64_t b, uint64_t p)
+{
+    return a >= b ? a - b : a + (p - b);
+}
+
+static inline uint64_t mod_add(uint64_t a, uint64_t b, uint64_t p)
+{
+    uint64_t s = a + b;
+    return s >= p ? s - p : s;
+}
+
+static uint64_t to_mont(const struct modulus *m, uint64_t a)
+{
+    return mont_mul(m, a, m->r2);
+}
+
+/* a^-1 in Montgomery form, for a != 0 in Montgomery form */
+static uint64_t mont_inverse(const struct modulus *m, uint64_t a)
+{
+    uint64_t result = to_mont(m, 1), e = m->p - 2;
+    while (e)
+    {
+        if (e & 1)
+        {
+            result = mont_mul(m, result, a);
+        }
+        a = mont_mul(m, a, a);
+        e >>= 1;
+    }
+    return result;
+}
+
+static uint64_t mul_mod(uint64_t a, uint64_t b, uint64_t p)
+{
+    return (uint64_t)((uint128_t)a * b % p);
+}
+
+/* Deterministic Miller-Rabin, these bases settle every 64-bit n */
+static bool is_prime(uint64_t n)
+{
+    static const uint64_t bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+    uint64_t d = n - 1;
+    int s = 0;
+    while ((d & 1) == 0)
+    {
+        d >>= 1;
+        s++;
+    }
+    for (size_t b = 0; b < sizeof(bases) / sizeof(bases[0]); b++)
+    {
+        uint64_t x = 1, base = bases[b] % n, e = d;
+        while (e)
+        {
+            if (e & 1)
+            {
+                x = mul_mod(x, base, n);
+            }
+            base = mul_mod(base, base, n);
+            e >>= 1;
+        }
+        if (x == 1 || x == n - 1)
+        {
+            continue;
+        }
+        int r = 1;
+        for (; r < s && x != n - 1; r++)
+        {
+            x = mul_mod(x, x, n);
+        }
+        if (x != n - 1)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* The largest prime below p, p odd or EXACT_PRIME_LIMIT */
+static uint64_t prime_below(uint64_t p)
+{
+    p -= p & 1 ? 2 : 1;
+    while (!is_prime(p))
+    {
+        p -= 2;
+    }
+    return p;
+}
+
+/* Write mat as K / scale with integer K: the smallest power of ten up to 10^EXACT_MAX_DECIMALS that
+ * reproduces every entry as written in decimal, otherwise the power of two that makes the doubles
+ * themselves integers, as long as they stay below 2^62 */
+static bool integer_matrix(int n, const double mat[n][n], int64_t *k, struct exact_inverse *inv)
+{
+    const double *a = &mat[0][0];
+    size_t count = (size_t)n * n;
+
+    double pow10 = 1.0;
+    for (int s = 0; s <= EXACT_MAX_DECIMALS; s++, pow10 *= 10.0)
+    {
+        bool fits = true;
+        for (size_t e = 0; e < count && fits; e++)
+        {
+            double kx = nearbyint(a[e] * pow10);
+            fits = fabs(kx) < 0x1p53 && kx / pow10 == a[e];
+        }
+        if (fits)
+        {
+            for (size_t e = 0; e < count; e++)
+            {
+                k[e] = (int64_t)nearbyint(a[e] * pow10);
+            }
+            inv->scale_base = 10;
+            inv->scale_power = s;
+            return true;
+        }
+    }
+
+    int shift = 0;
+    for (size_t e = 0; e < count; e++)
+    {
+        if (!isfinite(a[e]))
+        {
+            shift = 64;
+            break;
+        }
+        if (a[e] != 0.0)
+        {
+            /* a = m·2^(exp - 53) with m a 53-bit integer */
+            int exp;
+            uint64_t m = (uint64_t)ldexp(fabs(frexp(a[e], &exp)), 53);
+            int need = 53 - exp - __builtin_ctzll(m);
+            shift = need > shift ? need : shift;
+        }
+    }
+    bool fits = shift < 63;
+    for (size_t e = 0; e < count && fits; e++)
+    {
+        fits = ldexp(fabs(a[e]), shift) < 0x1p62;
+    }
+    if (!fits)
+    {
+        printf("Exact inversion needs decimals with at most %d digits after the point, or doubles of similar magnitude.\n",
+               EXACT_MAX_DECIMALS);
+        return false;
+    }
+    for (size_t e = 0; e < count; e++)
+    {
+        k[e] = (int64_t)ldexp(a[e], shift);
+    }
+    inv->scale_base = 2;
+    inv->scale_power = shift;
+    return true;
+}
+
+/* log2 of the Hadamard bound prod ||row_i||, which bounds |det(K)| and every cofactor since the rows
+ * of an integer matrix have norm 0 or at least 1. -1 if a row is zero. */
+static double hadamard_bits(int n, const int64_t *k)
+{
+    double bits = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        double sum = 0.0;
+        for (int j = 0; j < n; j++)
+        {
+            double v = (double)k[(size_t)i * n + j];
+            sum += v * v;
+        }
+        if (sum == 0.0)
+        {
+            return -1.0;
+        }
+        bits += 0.5 * log2(sum);
+    }
+    return bits;
+}
+
+/* adj(K) mod p into a and det(K) mod p into det, by in-place Gauss-Jordan. False if p divides det(K). */
+static bool adjugate_mod(int n, const int64_t *k, const struct modulus *m, uint64_t a[n][n], int *ipiv, uint64_t *det)
+{
+    uint64_t p = m->p;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            int64_t v = k[(size_t)i * n + j] % (int64_t)p;
+            a[i][j] = to_mont(m, v < 0 ? (uint64_t)(v + (int64_t)p) : (uint64_t)v);
+        }
+    }
+
+    uint64_t d = to_mont(m, 1);
+    bool odd = false;
+    for (int c = 0; c < n; c++)
+    {
+        int r = c;
+        while (r < n && a[r][c] == 0)
+        {
+            r++;
+        }
+        if (r == n)
+        {
+            return false;
+        }
+        ipiv[c] = r;
+        if (r != c)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                uint64_t tmp = a[r][j];
+                a[r][j] = a[c][j];
+                a[c][j] = tmp;
+            }
+            odd = !odd;
+        }
+
+        // Same in-place step as the tiled engine: column c of the pivot row becomes its inverse
+        d = mont_mul(m, d, a[c][c]);
+        uint64_t scale = mont_inverse(m, a[c][c]);
+        a[c][c] = to_mont(m, 1);
+        for (int j = 0; j < n; j++)
+        {
+            a[c][j] = mont_mul(m, a[c][j], scale);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t f = a[i][c];
+            if (i == c || f == 0)
+            {
+                continue;
+            }
+            a[i][c] = 0;
+            for (int j = 0; j < n; j++)
+            {
+                a[i][j] = mod_sub(a[i][j], mont_mul(m, f, a[c][j]), p);
+            }
+        }
+    }
+
+    /* The row exchanges come back as column exchanges, last one first */
+    for (int c = n - 1; c >= 0; c--)
+    {
+        if (ipiv[c] != c)
+        {
+            for (int i = 0; i < n; i++)
+            {
+                uint64_t tmp = a[i][c];
+                a[i][c] = a[i][ipiv[c]];
+                a[i][ipiv[c]] = tmp;
+            }
+        }
+    }
+
+    /* Montgomery times plain gives plain: adj = det·K^-1 leaves the Montgomery domain */
+    d = mont_mul(m, d, 1);
+    d = odd && d != 0 ? p - d : d;
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            a[i][j] = mont_mul(m, a[i][j], d);
+        }
+    }
+    *det = d;
+    return true;
+}
+
+/* Add the digits of prime number kp, the residues res of the count entries, to their digits (rows
+ * of stride words). Returns how many entries changed. */
+static long garner_step(int count, int64_t *digits, int stride, const uint64_t *primes, int kp, const uint64_t *res)
+{
+    struct modulus m;
+    uint64_t p = primes[kp];
+    modulus_init(&m, p);
+
+    /* radix[j] = p_0 ··· p_j-1 mod p, in Montgomery form */
+    uint64_t radix[kp + 1];
+    radix[0] = to_mont(&m, 1);
+    for (int j = 1; j <= kp; j++)
+    {
+        radix[j] = mont_mul(&m, radix[j - 1], to_mont(&m, primes[j - 1] % p));
+    }
+    uint64_t radix_inv = mont_inverse(&m, radix[kp]);
+
+    long changed = 0;
+#pragma omp parallel for schedule(static) reduction(+ : changed)
+    for (int e = 0; e < count; e++)
+    {
+        int64_t *v = digits + (size_t)e * stride;
+        uint64_t sum = 0;
+        for (int j = 0; j < kp; j++)
+        {
+            /* |v_j| < p_j / 2 < p */
+            uint64_t vj = v[j] < 0 ? (uint64_t)(v[j] + (int64_t)p) : (uint64_t)v[j];
+            sum = mod_add(sum, mont_mul(&m, vj, radix[j]), p);
+        }
+        uint64_t t = mont_mul(&m, mod_sub(res[e], sum, p), radix_inv);
+        v[kp] = t > p / 2 ? (int64_t)t - (int64_t)p : (int64_t)t;
+        changed += t != 0;
+    }
+    return changed;
+}
+
+/* x mod q of the count entries from their digits over the first nprimes primes, q below all of them */
+static void garner_residues(int count, const int64_t *digits, int stride, const uint64_t *primes, int nprimes,
+                            const struct modulus *m, uint64_t *res)
+{
+    uint64_t q = m->p;
+
+    /* radix[j] = p_0 ··· p_j-1 mod q, in Montgomery form, so each product below comes out in normal form */
+    uint64_t radix[nprimes > 0 ? nprimes : 1];
+    radix[0] = to_mont(m, 1);
+    for (int j = 1; j < nprimes; j++)
+    {
+        radix[j] = mont_mul(m, radix[j - 1], to_mont(m, primes[j - 1] % q));
+    }
+
+#pragma omp parallel for schedule(static)
+    for (int e = 0; e < count; e++)
+    {
+        const int64_t *v = digits + (size_t)e * stride;
+        uint64_t sum = 0;
+        for (int j = 0; j < nprimes; j++)
+        {
+            /* |v_j| < p_j / 2 < 2^61 < q */
+            uint64_t vj = v[j] < 0 ? (uint64_t)(v[j] + (int64_t)q) : (uint64_t)v[j];
+            sum = mod_add(sum, mont_mul(m, vj, radix[j]), q);
+        }
+        res[e] = sum;
+    }
+}
+
+/* Whether K·N = d·I modulo the prime q for the reconstructed adjugate N and determinant d (the last of the
+ * n^2 + 1 digit rows), by K·(N·r) = d·r for a random r. A wrong reconstruction passes with probability
+ * about n / q, unless q happens to divide every entry of K·N - d·I. res holds n^2 + 2n + 1 words. */
+static bool check_reconstruction(int n, const int64_t *k, const int64_t *digits, int stride, const uint64_t *primes,
+                                 int nprimes, uint64_t q, uint64_t *res)
+{
+    struct modulus m;
+    modulus_init(&m, q);
+    size_t count = (size_t)n * n;
+    garner_residues((int)count + 1, digits, stride, primes, nprimes, &m, res);
+    uint64_t d = res[count];
+    uint64_t *r = res + count + 1, *w = r + n;
+
+    /* r in Montgomery form from a fixed splitmix64 sequence: the fresh prime is what changes between runs */
+    uint64_t state = q;
+    for (int j = 0; j < n; j++)
+    {
+        uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        r[j] = to_mont(&m, (z ^ (z >> 31)) % q);
+    }
+
+    /* w = N·r, then y = K·w, both in normal form */
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t sum = 0;
+        for (int j = 0; j < n; j++)
+        {
+            sum = mod_add(sum, mont_mul(&m, res[(size_t)i * n + j], r[j]), q);
+        }
+        w[i] = to_mont(&m, sum);
+    }
+    bool ok = true;
+#pragma omp parallel for schedule(static) reduction(&& : ok)
+    for (int i = 0; i < n; i++)
+    {
+        uint64_t sum = 0;
+        for (int j = 0; j < n; j++)
+        {
+            int64_t v = k[(size_t)i * n + j] % (int64_t)q;
+            sum = mod_add(sum, mont_mul(&m, v < 0 ? (uint64_t)(v + (int64_t)q) : (uint64_t)v, w[j]), q);
+        }
+        ok = ok && sum == mont_mul(&m, d, r[i]);
+    }
+    return ok;
+}
+
+/* x = sum of v_j·p_0 ··· p_j-1 by Horner's rule */
+static void garner_value(struct bigint *x, const int64_t *v, const uint64_t *primes, int nprimes, struct bigint *one,
+                         struct bigint *scratch)
+{
+    x->len = 0;
+    x->neg = false;
+    for (int j = nprimes - 1; j >= 0; j--)
+    {
+        bigint_mul_u64(x, primes[j]);
+        bigint_addmul_i64(x, one, v[j], scratch);
+    }
+}
+
+/* Numerators over a positive denominator, divided by the gcd of all of them */
+static void reduce_fraction(struct exact_inverse *inv, uint64_t scale, int cap)
+{
+    int n = inv->n;
+    size_t count = (size_t)n * n;
+    uint64_t *buf = malloc(2 * (size_t)cap * sizeof(uint64_t));
+    if (!buf)
+    {
+        /* Still a correct inverse, just not in lowest terms */
+        perror("malloc (gcd)");
+        return;
+    }
+    struct bigint g, scratch;
+    bigint_init(&g, buf, cap);
+    bigint_init(&scratch, buf + cap, cap);
+
+    bool flip = inv->denominator.neg;
+    inv->denominator.neg = false;
+    bigint_copy(&g, &inv->denominator);
+    for (size_t e = 0; e < count; e++)
+    {
+        bigint_mul_u64(&inv->numerator[e], scale);
+        inv->numerator[e].neg ^= flip && !bigint_is_zero(&inv->numerator[e]);
+        if (g.len != 1 || g.limb[0] != 1)
+        {
+            bigint_gcd(&g, &inv->numerator[e], &scratch);
+        }
+    }
+
+    if (g.len != 1 || g.limb[0] != 1)
+    {
+#pragma omp parallel
+        {
+            uint64_t limbs[cap];
+            struct bigint local;
+            bigint_init(&local, limbs, cap);
+#pragma omp for schedule(static)
+            for (size_t e = 0; e <= count; e++)
+            {
+                bigint_divexact(e < count ? &inv->numerator[e] : &inv->denominator, &g, &local);
+            }
+        }
+    }
+    free(buf);
+}
+
+bool invert_matrix_exact(int n, const double mat[n][n], struct exact_inverse *inv)
+{
+    memset(inv, 0, sizeof(*inv));
+    inv->n = n;
+    size_t count = (size_t)n * n;
+    int threads = omp_get_max_threads();
+
+    int64_t *k = malloc(count * sizeof(int64_t));
+    if (!k)
+    {
+        perror("malloc (integer matrix)");
+        return false;
+    }
+    if (!integer_matrix(n, mat, k, inv))
+    {
+        free(k);
+        return false;
+    }
+    double bound = hadamard_bits(n, k);
+    if (bound < 0.0)
+    {
+        printf("Matrix is singular.\n");
+        free(k);
+        return false;
+    }
+
+    /* Every prime is above 2^61.99, so this many always pass twice the bound, plus the batch in flight. A rejected
+     * early stop only goes on towards the bound. */
+    int max_primes = (int)((bound + 2.0) / 61.99) + 2 + EXACT_STABLE_PRIMES + threads;
+    int stride = max_primes;
+    uint64_t *primes = malloc(max_primes * sizeof(uint64_t));
+    int64_t *digits = malloc((count + 1) * stride * sizeof(int64_t));
+    /* The images of one batch, later the residues of the reconstruction check */
+    size_t image_words = (size_t)threads * (count + 1);
+    image_words = image_words > count + 2 * (size_t)n + 1 ? image_words : count + 2 * (size_t)n + 1;
+    uint64_t *images = malloc(image_words * sizeof(uint64_t));
+    int *ipiv = malloc((size_t)threads * n * sizeof(int));
+    bool *lucky = malloc(threads * sizeof(bool));
+    if (!primes || !digits || !images || !ipiv || !lucky)
+    {
+        perror("malloc (modular images)");
+        free(lucky);
+        free(ipiv);
+        free(images);
+        free(digits);
+        free(primes);
+        free(k);
+        return false;
+    }
+
+    PROF_BEGIN(PHASE_ELIMINATION);
+    double used_bits = 0.0, lost_bits = 0.0;
+    int stable = 0;
+    bool done = false, singular = false;
+    uint64_t next = EXACT_PRIME_LIMIT;
+    while (!done)
+    {
+        uint64_t batch[threads];
+        for (int s = 0; s < threads; s++)
+        {
+            batch[s] = next = prime_below(next);
+        }
+
+        /* One prime per thread, the images are independent */
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int s = 0; s < threads; s++)
+        {
+            struct modulus m;
+            modulus_init(&m, batch[s]);
+            uint64_t *image = images + (size_t)s * (count + 1);
+            /* adj(K) followed by det(K), the digits are kept in the same order */
+            lucky[s] = adjugate_mod(n, k, &m, (uint64_t (*)[n])image, ipiv + (size_t)s * n, &image[count]);
+        }
+
+        /* Combined in prime order, so the result does not depend on the thread count */
+        for (int s = 0; s < threads && !done; s++)
+        {
+            if (!lucky[s])
+            {
+                inv->skipped++;
+                lost_bits += log2((double)batch[s]);
+                singular = done = lost_bits > bound + 1.0;
+                continue;
+            }
+            primes[inv->primes] = batch[s];
+            const uint64_t *image = images + (size_t)s * (count + 1);
+            long changed = garner_step((int)count + 1, digits, stride, primes, inv->primes, image);
+            inv->primes++;
+            used_bits += log2((double)batch[s]);
+
+            stable = changed == 0 ? stable + 1 : 0;
+            inv->bounded = used_bits > bound + 1.0;
+            done = stable >= EXACT_STABLE_PRIMES || inv->bounded;
+        }
+
+        /* The bound guarantees the result, an early stop is checked modulo a prime the reconstruction did not
+         * use. The images of the batch are no longer needed, the check uses their space. */
+        if (done && !singular && !inv->bounded)
+        {
+            next = prime_below(next);
+            if (!check_reconstruction(n, k, digits, stride, primes, inv->primes, next, images))
+            {
+                inv->rejected++;
+                stable = 0;
+                done = false;
+            }
+        }
+    }
+    PROF_END(PHASE_ELIMINATION);
+
+    /* n^3 multiply-adds per prime */
+    PROF_WORK(PHASE_ELIMINATION, 2.0 * n * n * n * (inv->primes + inv->skipped), 16.0 * n * n * n * (inv->primes + inv->skipped));
+
+    bool ok = !singular;
+    if (singular)
+    {
+        /* Primes whose product exceeds the Hadamard bound all divide det(K) */
+        printf("Matrix is singular.\n");
+    }
+
+    /* Room for the bound, the scale and a spare prime */
+    int cap = (int)((used_bits + 62.0 * 2 + 64.0) / 64.0) + 2;
+    if (ok)
+    {
+        inv->limbs = malloc((count + 1) * cap * sizeof(uint64_t));
+        inv->numerator = malloc(count * sizeof(struct bigint));
+        if (!inv->limbs || !inv->numerator)
+        {
+            perror("malloc (exact inverse)");
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_EXTRACT);
+        bigint_init(&inv->denominator, inv->limbs + count * cap, cap);
+#pragma omp parallel
+        {
+            uint64_t limbs[cap], one_limb = 1;
+            struct bigint scratch, one = {&one_limb, 1, 1, false};
+            bigint_init(&scratch, limbs, cap);
+#pragma omp for schedule(static)
+            for (size_t e = 0; e <= count; e++)
+            {
+                struct bigint *x = e < count ? &inv->numerator[e] : &inv->denominator;
+                if (e < count)
+                {
+                    bigint_init(x, inv->limbs + e * cap, cap);
+                }
+                garner_value(x, digits + e * stride, primes, inv->primes, &one, &scratch);
+            }
+        }
+
+        uint64_t scale = 1;
+        for (int s = 0; s < inv->scale_power; s++)
+        {
+            scale *= (uint64_t)inv->scale_base;
+        }
+        reduce_fraction(inv, scale, cap);
+        PROF_END(PHASE_EXTRACT);
+    }
+
+    free(lucky);
+    free(ipiv);
+    free(images);
+    free(digits);
+    free(primes);
+    free(k);
+    if (!ok)
+    {
+        exact_inverse_free(inv);
+    }
+    return ok;
+}
+
+void exact_inverse_free(struct exact_inverse *inv)
+{
+    free(inv->numerator);
+    free(inv->limbs);
+    inv->numerator = NULL;
+    inv->limbs = NULL;
+}
+
+void exact_inverse_to_double(const struct exact_inverse *inv, int n, double mat_inv[n][n])
+{
+    int exp_den;
+    double den = bigint_frexp(&inv->denominator, &exp_den);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            int exp_num;
+            double num = bigint_frexp(&inv->numerator[(size_t)i * n + j], &exp_num);
+            mat_inv[i][j] = ldexp(num / den, exp_num - exp_den);
+        }
+    }
+}
+
+bool write_exact_inverse(const char *filepath, const struct exact_inverse *inv)
+{
+    FILE *fp = fopen(filepath, "w");
+    uint64_t *limbs = malloc(inv->denominator.cap * sizeof(uint64_t));
+    if (!fp || !limbs)
+    {
+        perror(fp ? "malloc (decimal conversion)" : "Error opening output file");
+        free(limbs);
+        if (fp)
+        {
+            fclose(fp);
+        }
+        return false;
+    }
+    struct bigint scratch;
+    bigint_init(&scratch, limbs, inv->denominator.cap);
+
+    bigint_fprint(fp, &inv->denominator, &scratch);
+    fprintf(fp, "\n");
+    for (int i = 0; i < inv->n; i++)
+    {
+        for (int j = 0; j < inv->n; j++)
+        {
+            bigint_fprint(fp, &inv->numerator[(size_t)i * inv->n + j], &scratch);
+            fprintf(fp, j + 1 < inv->n ? " " : "\n");
+        }
+    }
+    free(limbs);
+
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0 || !ok)
+    {
+        perror("Error writing output file");
+        return false;
+    }
+    return true;
+}
+
+bool benchmark_matrix_inversion_exact(int n, const double mat[n][n], struct exact_inverse *inv)
+{
+    double start = now_ms();
+    if (!invert_matrix_exact(n, mat, inv))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double elapsed_time = now_ms() - start;
+
+    printf("Matrix inversion (Exact) completed in %.3f ms for %dx%d matrix.\n", elapsed_time, n, n);
+    printf("Exact: entries scaled by %d^%d, %d primes of 62 bits (%d skipped), %s, %d early stops rejected, "
+           "denominator of %d bits.\n",
+           inv->scale_base, inv->scale_power, inv->primes, inv->skipped,
+           inv->bounded ? "stopped at the Hadamard bound" : "stopped early and checked modulo a fresh prime",
+           inv->rejected, bigint_bits(&inv->denominator));
+    return true;
+}
@@ -0,0 +1,50 @@
+#ifndef MATRIX_INVERSION_EXACT_H
+#define MATRIX_INVERSION_EXACT_H
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "helpers/bigint.h"
+
+/* Exact rational inversion by multi-modular arithmetic.
+ *
+ * The entries are taken as the decimals they were written as (up to 9
+ * digits after the point), or as the exact binary values of the doubles,
+ * and scaled by a common power of ten or two to an integer matrix K. K is
+ * inverted modulo primes just below 2^62, one prime per thread, and each
+ * image gives det(K) and adj(K) = det(K)·K^-1 modulo that prime. The
+ * images are combined by the Chinese remainder theorem into the integers
+ * adj(K) and det(K), until two primes in a row change none of them or the
+ * product of the primes passes twice the Hadamard bound, which guarantees
+ * the result. An early stop must also pass K·adj(K) = det(K)·I modulo a
+ * fresh prime (by a random projection, O(n^2)), or more primes are added. The inverse is numerator / denominator in lowest terms, with
+ * a positive denominator.
+ */
+struct exact_inverse
+{
+    int n;
+    struct bigint denominator;
+    struct bigint *numerator; /* n x n, row-major */
+    uint64_t *limbs;          /* Storage of all of them */
+    int primes;               /* Primes used, and primes skipped because they divide det(K) */
+    int skipped;
+    bool bounded;             /* Stopped at the Hadamard bound rather than early */
+    int rejected;             /* Early stops that failed the check modulo a fresh prime */
+    int scale_base;           /* K = scale_base^scale_power · A */
+    int scale_power;
+};
+
+/* Invert mat exactly into inv (release with exact_inverse_free). Returns false if mat is singular or
+ * its entries are neither short decimals nor representable as scaled 62-bit integers. */
+bool invert_matrix_exact(int n, const double mat[n][n], struct exact_inverse *inv);
+
+void exact_inverse_free(struct exact_inverse *inv);
+
+/* The inverse rounded to doubles */
+void exact_inverse_to_double(const struct exact_inverse *inv, int n, double mat_inv[n][n]);
+
+/* Write the denominator on the first line, then the n rows of numerators */
+bool write_exact_inverse(const char *filepath, const struct exact_inverse *inv);
+
+bool benchmark_matrix_inversion_exact(int n, const double mat[n][n], struct exact_inverse *inv);
+
+#endif
@@ -0,0 +1,312 @@
+/* Type-generic Gauss-Jordan inversion, instantiated by matrix_inversion_typed.c.
+ *
+ * Define SCALAR_KIND (see helpers/scalar.h) and include this file to get
+ * TYPED(invert_matrix), TYPED(invert_matrix_par) and their benchmark
+ * wrappers for that element type. No include guard, each inclusion
+ * generates one more set of functions. The double instance also gets
+ * invert_matrix_ws_d, and the double engines (matrix_inversion.c and
+ * matrix_inversion_parallel.c) are wrappers over it.
+ *
+ * [A | I] is reduced with partial pivoting through a row permutation
+ * (logical row i lives in physical row perm[i], pos is the inverse), then
+ * the upper triangle is cleared from the bottom up. The identity is placed
+ * in pivot order: the pivot row of step i gets its 1 in column n + i, so
+ * column n + j belongs to column perm[j] of the inverse. The serial and the
+ * OpenMP variant share the code, the loops only fork when parallel is set,
+ * and deal out the same chunks of physical rows with schedule(static,
+ * chunk) so a row stays with the thread that first touched it (see
+ * helpers/placement.h). Each row update only touches the columns that can
+ * still be nonzero, in a unit-stride loop that the compiler vectorizes for
+ * the element type.
+ */
+
+#include "helpers/scalar_template.h"
+
+/* 1-norm of the n x n block of the n x ncol matrix mat starting at column col0 */
+static REAL TYPED(norm1)(int n, int ncol, SCALAR mat[n][ncol], int col0)
+{
+    REAL best = 0;
+    for (int j = col0; j < col0 + n; j++)
+    {
+        REAL sum = 0;
+        for (int i = 0; i < n; i++)
+        {
+            sum += SCALAR_ABS(mat[i][j]);
+        }
+        best = sum > best ? sum : best;
+    }
+    return best;
+}
+
+/* row[j] -= coeff * pivot[j] for j in [from, to) */
+static inline void TYPED(axpy_row)(int from, int to, SCALAR coeff, const SCALAR *restrict pivot, SCALAR *restrict row)
+{
+#pragma omp simd
+    for (int j = from; j < to; j++)
+    {
+        row[j] -= coeff * pivot[j];
+    }
+}
+
+/* Logical row in [i, n) of the largest magnitude in column i, ties go to the lowest row */
+static int TYPED(find_pivot)(int i, int n, SCALAR aug[n][2 * n], const int pos[n], int chunk, bool parallel)
+{
+    int best = i;
+    REAL best_val = -1;
+
+#pragma omp parallel if (parallel && n - i > PIVOT_SEARCH_PAR_MIN)
+    {
+        int local = i;
+        REAL local_val = -1;
+#pragma omp for schedule(static, chunk) nowait
+        for (int p = 0; p < n; p++)
+        {
+            REAL val = SCALAR_ABS1(aug[p][i]);
+            if (pos[p] >= i && (val > local_val || (val == local_val && pos[p] < local)))
+            {
+                local_val = val;
+                local = pos[p];
+            }
+        }
+#pragma omp critical(typed_pivot_search)
+        {
+            if (local_val > best_val || (local_val == best_val && local < best))
+            {
+                best_val = local_val;
+                best = local;
+            }
+        }
+    }
+    return best;
+}
+
+/* Forward elimination with partial pivoting, leaves a unit upper triangle (row permuted) on the left */
+static bool TYPED(eliminate)(int n, SCALAR aug[n][2 * n], int perm[n], int pos[n], REAL tol, int chunk, bool parallel)
+{
+    for (int i = 0; i < n; i++)
+    {
+        perm[i] = i;
+        pos[i] = i;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        int best = TYPED(find_pivot)(i, n, aug, pos, chunk, parallel);
+        if (SCALAR_ABS(aug[perm[best]][i]) <= tol)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            return false;
+        }
+        int tmp = perm[i];
+        perm[i] = perm[best];
+        perm[best] = tmp;
+        pos[perm[i]] = i;
+        pos[perm[best]] = best;
+
+        /* Columns left of i are already zero in every remaining row, and so are those right of
+         * n + i: the pivot row of step i only now gets its identity entry, in column n + i */
+        SCALAR *pivot = aug[perm[i]];
+        pivot[n + i] = 1;
+        SCALAR scale = 1 / pivot[i];
+#pragma omp simd
+        for (int j = i; j <= n + i; j++)
+        {
+            pivot[j] *= scale;
+        }
+
+#pragma omp parallel if (parallel)
+        {
+            PROF_BEGIN(PHASE_ROW_UPDATE);
+#pragma omp for schedule(static, chunk) nowait
+            for (int p = 0; p < n; p++)
+            {
+                if (pos[p] > i)
+                {
+                    TYPED(axpy_row)(i, n + i + 1, aug[p][i], pivot, aug[p]);
+                }
+            }
+            PROF_END(PHASE_ROW_UPDATE);
+        }
+    }
+
+    /* n row scalings plus n(n-1)/2 row updates over the n + 1 live columns */
+    PROF_WORK(PHASE_ELIMINATION, (n + 1.0) * n * n, 2.0 * sizeof(SCALAR) * (n + 1.0) * n * n);
+    return true;
+}
+
+/* Backward elimination. The pivot row of step i is zero left of the diagonal and right of it up to
+ * column n, so a row update is a single entry on the left and the right half. */
+static void TYPED(back_substitute)(int n, SCALAR aug[n][2 * n], const int perm[n], const int pos[n], int chunk, bool parallel)
+{
+    for (int i = n - 1; i > 0; i--)
+    {
+        const SCALAR *pivot = aug[perm[i]];
+
+#pragma omp parallel if (parallel)
+        {
+            PROF_BEGIN(PHASE_ROW_UPDATE);
+#pragma omp for schedule(static, chunk) nowait
+            for (int p = 0; p < n; p++)
+            {
+                if (pos[p] < i)
+                {
+                    TYPED(axpy_row)(n, 2 * n, aug[p][i], pivot, aug[p]);
+                    aug[p][i] = 0;
+                }
+            }
+            PROF_END(PHASE_ROW_UPDATE);
+        }
+    }
+
+    /* n(n-1)/2 row updates over n columns */
+    PROF_WORK(PHASE_RREF, (double)n * n * (n - 1), 1.0 * sizeof(SCALAR) * n * n * (n - 1));
+}
+
+/* Invert mat through the caller's augmented matrix and pivot order buffers. *cond gets the 1-norm condition
+ * number, -1 if not reached, and a matrix above cond_limit (0 for none) is rejected. The double instance
+ * estimates it in work (4n doubles) before the back substitution, the others compute it from the inverse. */
+static bool TYPED(invert_augmented)(int n, SCALAR mat[n][n], SCALAR aug[n][2 * n], int perm[n], int pos[n], double *work, int chunk,
+                                    bool parallel, double cond_limit, double *cond, SCALAR mat_inv[n][n])
+{
+    *cond = -1.0;
+
+    PROF_BEGIN(PHASE_AUGMENT);
+#pragma omp parallel for schedule(static, chunk) if (parallel)
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            aug[i][j] = mat[i][j];
+            aug[i][n + j] = 0;
+        }
+    }
+    PROF_END(PHASE_AUGMENT);
+    REAL anorm = TYPED(norm1)(n, 2 * n, aug, 0);
+
+    PROF_BEGIN(PHASE_ELIMINATION);
+    bool ok = TYPED(eliminate)(n, aug, perm, pos, REAL_EPSILON * anorm, chunk, parallel);
+    PROF_END(PHASE_ELIMINATION);
+    if (!ok)
+    {
+        return false;
+    }
+
+#if SCALAR_KIND == SCALAR_KIND_DOUBLE
+    /* Estimate the condition number from [U | M] before paying for the back substitution */
+    PROF_BEGIN(PHASE_CONDITION);
+    *cond = anorm * cond_estimate_ge_work(n, 2 * n, aug, perm, work);
+    ok = cond_check(*cond, cond_limit);
+    PROF_END(PHASE_CONDITION);
+    if (!ok)
+    {
+        return false;
+    }
+#else
+    (void)work;
+#endif
+
+    PROF_BEGIN(PHASE_RREF);
+    TYPED(back_substitute)(n, aug, perm, pos, chunk, parallel);
+    PROF_END(PHASE_RREF);
+
+    PROF_BEGIN(PHASE_EXTRACT);
+#pragma omp parallel for if (parallel)
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            mat_inv[i][perm[j]] = aug[perm[i]][n + j];
+        }
+    }
+    PROF_END(PHASE_EXTRACT);
+
+#if SCALAR_KIND != SCALAR_KIND_DOUBLE
+    /* The inverse is at hand, so the 1-norm condition number is exact and O(n^2) */
+    PROF_BEGIN(PHASE_CONDITION);
+    *cond = (double)anorm * TYPED(norm1)(n, 2 * n, aug, n);
+    ok = cond_check(*cond, cond_limit);
+    PROF_END(PHASE_CONDITION);
+#endif
+    return ok;
+}
+
+#if SCALAR_KIND == SCALAR_KIND_DOUBLE
+bool TYPED(invert_matrix_ws)(int n, SCALAR mat[n][n], struct inversion_workspace *ws, bool parallel, SCALAR mat_inv[n][n])
+{
+    SCALAR (*aug)[2 * n] = (SCALAR (*)[2 * n])ws->aug;
+    int chunk = ws->chunk > 0 ? ws->chunk : 1;
+    return TYPED(invert_augmented)(n, mat, aug, ws->perm, ws->perm + n, ws->work, chunk, parallel, ws->cond_limit, &ws->cond, mat_inv);
+}
+#endif
+
+static bool TYPED(invert)(int n, SCALAR mat[n][n], SCALAR mat_inv[n][n], bool parallel)
+{
+    /* Untouched (huge) pages, the augmentation places each chunk of rows with its owner */
+    size_t bytes = sizeof(SCALAR[n][2 * n]), page_bytes;
+    SCALAR (*aug)[2 * n] = placement_alloc(bytes, &page_bytes);
+    int *perm = malloc(2 * n * sizeof(int));
+#if SCALAR_KIND == SCALAR_KIND_DOUBLE
+    double *work = malloc(4 * n * sizeof(double));
+#else
+    double *work = NULL; /* Only the double instance estimates the condition number ahead */
+#endif
+    if (!aug || !perm || (SCALAR_KIND == SCALAR_KIND_DOUBLE && !work))
+    {
+        perror("malloc (augmented matrix)");
+        placement_free(aug, bytes, page_bytes);
+        free(perm);
+        free(work);
+        return false;
+    }
+    int chunk = placement_chunk_rows(sizeof(SCALAR[2 * n]), page_bytes);
+
+    if (parallel)
+    {
+        placement_pin_threads();
+    }
+    double cond;
+    bool ok = TYPED(invert_augmented)(n, mat, aug, perm, perm + n, work, chunk, parallel, cond_get_limit(), &cond, mat_inv);
+    if (cond >= 0.0)
+    {
+        cond_record(cond);
+    }
+    free(work);
+    free(perm);
+    placement_free(aug, bytes, page_bytes);
+    return ok;
+}
+
+bool TYPED(invert_matrix)(int n, SCALAR mat[n][n], SCALAR mat_inv[n][n])
+{
+    return TYPED(invert)(n, mat, mat_inv, false);
+}
+
+bool TYPED(invert_matrix_par)(int n, SCALAR mat[n][n], SCALAR mat_inv[n][n])
+{
+    return TYPED(invert)(n, mat, mat_inv, true);
+}
+
+static bool TYPED(benchmark)(int n, SCALAR mat[n][n], SCALAR mat_inv[n][n], bool parallel)
+{
+    double start = now_ms();
+    if (!TYPED(invert)(n, mat, mat_inv, parallel))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double elapsed_time = now_ms() - start;
+
+    printf("Matrix inversion (%s) completed in %.3f ms for %dx%d matrix.\n", parallel ? "Parallel" : "Serial", elapsed_time, n, n);
+    cond_report(stdout);
+    return true;
+}
+
+bool TYPED(benchmark_matrix_inversion)(int n, SCALAR mat[n][n], SCALAR mat_inv[n][n])
+{
+    return TYPED(benchmark)(n, mat, mat_inv, false);
+}
+
+bool TYPED(benchmark_matrix_inversion_parallel)(int n, SCALAR mat[n][n], SCALAR mat_inv[n][n])
+{
+    return TYPED(benchmark)(n, mat, mat_inv, true);
+}
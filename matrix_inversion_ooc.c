@@ -0,0 +1,752 @@
+/**
+ * @file matrix_inversion_ooc.c
+ * @brief Out-of-core matrix inversion with a left-looking tiled LU factorization
+ *
+ * Panel k holds columns k·b .. k·b + w_k - 1 of the n x n matrix as an
+ * n x w_k row-major block at offset k·n·b doubles of the scratch file.
+ *
+ * Factorization: panel k is read, receives the row exchanges of all earlier
+ * panels, and is updated by each factored panel j < k in turn (a unit lower
+ * triangular solve for its U block, then a matrix product for the rows
+ * below). It is then factored with partial pivoting and written back. The
+ * factored panels keep L as it was when they were factored, the row
+ * exchanges of later panels are applied to the streamed copy instead.
+ *
+ * Inversion: column panel c of A^-1 solves A·X = E_c. It starts as P·E_c,
+ * goes through the forward substitution (streaming the L parts of the
+ * panels left to right) and the back substitution (streaming the U parts
+ * right to left), and is handed to the sink.
+ *
+ * One read is always in flight: the next panel of the sequence is fetched
+ * with asynchronous I/O while the current one is being used, and factored
+ * panels are written back asynchronously.
+ * */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "matrix_inversion_ooc.h"
+#include "helpers/tile_io.h"
+#include "helpers/file_reader.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
+
+#include <fcntl.h> /* open */
+#include <float.h> /* DBL_EPSILON */
+#include <math.h>  /* fabs */
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h> /* close */
+
+#define DEFAULT_OOC_MEMORY ((size_t)1 << 30)
+#define MIB (1024.0 * 1024.0)
+
+/* Resident panels: three being factored or written back, two being streamed in */
+#define FACTOR_BUFFERS 3
+#define STREAM_BUFFERS 2
+#define RESIDENT_PANELS (FACTOR_BUFFERS + STREAM_BUFFERS)
+
+/* Narrower panels would turn the updates into matrix-vector products */
+#define MIN_PANEL_WIDTH 16
+
+/* Cache blocking of the panel updates: rows per task, depth and width of a tile of the right operand */
+#define UPDATE_ROWS 32
+#define UPDATE_DEPTH 128
+#define UPDATE_COLS 256
+
+static size_t ooc_memory = DEFAULT_OOC_MEMORY;
+static const char *ooc_scratch_dir = NULL;
+
+/* Traffic of the last inversion, for the benchmark report */
+static struct
+{
+    double read_bytes;
+    double written_bytes;
+    double wait_ms;
+} ooc_stats;
+
+struct ooc_state
+{
+    int n;
+    int b;       /* Panel width, the last panel may be narrower */
+    int npanels;
+    int fd;      /* Scratch file holding the panels */
+    int *ipiv;   /* Row exchanged with row g at step g of the factorization */
+    double tol;  /* Pivots at or below it make the matrix numerically singular */
+    double *factor_buf[FACTOR_BUFFERS];
+    double *stream_buf[STREAM_BUFFERS];
+    struct tile_io write_io[FACTOR_BUFFERS]; /* Write back of factor_buf[i] */
+    int write_panel[FACTOR_BUFFERS];
+};
+
+/* A contiguous range of rows of a panel, read into the same rows of buf */
+struct stream_entry
+{
+    int panel;
+    int row0;
+    int nrows;
+    double *buf;
+};
+
+/* The sequence of panel reads of a phase, with the next one in flight */
+struct panel_stream
+{
+    int phase; /* 1: factorization, 2: substitutions */
+    int k;     /* Phase 1: current step, phase 2: current column panel of the inverse */
+    int j;     /* Position within k */
+    int parity;
+    bool active;
+    struct stream_entry inflight;
+    struct tile_io io;
+};
+
+void ooc_set_memory_limit(size_t bytes)
+{
+    ooc_memory = bytes;
+}
+
+void ooc_set_scratch_dir(const char *dir)
+{
+    ooc_scratch_dir = dir;
+}
+
+int ooc_panel_width(int n)
+{
+    size_t b = ooc_memory / (RESIDENT_PANELS * (size_t)n * sizeof(double));
+    if (b >= (size_t)n)
+    {
+        return n;
+    }
+    if (b < MIN_PANEL_WIDTH)
+    {
+        return 0;
+    }
+
+    /* Same number of panels, widths evened out */
+    int npanels = (n + (int)b - 1) / (int)b;
+    return (n + npanels - 1) / npanels;
+}
+
+static int panel_width(const struct ooc_state *st, int k)
+{
+    int rest = st->n - k * st->b;
+    return rest < st->b ? rest : st->b;
+}
+
+static off_t panel_offset(const struct ooc_state *st, int k, int row)
+{
+    return ((off_t)k * st->n * st->b + (off_t)row * panel_width(st, k)) * (off_t)sizeof(double);
+}
+
+static bool wait_io(struct tile_io *io)
+{
+    if (!io->pending)
+    {
+        return true;
+    }
+    double start = now_ms();
+    PROF_BEGIN(PHASE_TILE_WAIT);
+    bool ok = tile_io_wait(io);
+    PROF_END(PHASE_TILE_WAIT);
+    ooc_stats.wait_ms += now_ms() - start;
+    return ok;
+}
+
+static bool write_async(struct tile_io *io, int fd, double *buf, size_t count, off_t offset)
+{
+    ooc_stats.written_bytes += count * sizeof(double);
+    return tile_io_start(io, fd, buf, count * sizeof(double), offset, true);
+}
+
+/* Apply the row exchanges of steps g0 .. g1 - 1 to the rows of an n x w panel */
+static void apply_swaps(double *panel, int w, const int *ipiv, int g0, int g1)
+{
+    for (int g = g0; g < g1; g++)
+    {
+        if (ipiv[g] != g)
+        {
+            double *a = panel + (size_t)g * w, *b = panel + (size_t)ipiv[g] * w;
+            for (int c = 0; c < w; c++)
+            {
+                double tmp = a[c];
+                a[c] = b[c];
+                b[c] = tmp;
+            }
+        }
+    }
+}
+
+/* C[m x w] -= A[m x kd] · B[kd x w], row-major with leading dimensions lda, ldb and ldc */
+static void panel_update(int m, int kd, int w, const double *a, int lda, const double *b, int ldb, double *c, int ldc)
+{
+#pragma omp parallel for schedule(static)
+    for (int r0 = 0; r0 < m; r0 += UPDATE_ROWS)
+    {
+        int r1 = r0 + UPDATE_ROWS < m ? r0 + UPDATE_ROWS : m;
+        for (int s0 = 0; s0 < kd; s0 += UPDATE_DEPTH)
+        {
+            int s1 = s0 + UPDATE_DEPTH < kd ? s0 + UPDATE_DEPTH : kd;
+            for (int c0 = 0; c0 < w; c0 += UPDATE_COLS)
+            {
+                int c1 = c0 + UPDATE_COLS < w ? c0 + UPDATE_COLS : w;
+                for (int r = r0; r < r1; r++)
+                {
+                    double *crow = c + (size_t)r * ldc;
+                    const double *arow = a + (size_t)r * lda;
+                    for (int s = s0; s < s1; s++)
+                    {
+                        double coeff = arow[s];
+                        const double *brow = b + (size_t)s * ldb;
+                        for (int col = c0; col < c1; col++)
+                        {
+                            crow[col] -= coeff * brow[col];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    PROF_WORK(PHASE_ROW_UPDATE, 2.0 * m * kd * w, 8.0 * ((double)m * kd + 2.0 * m * w));
+}
+
+/* B[kd x w] = L^-1 · B with L unit lower triangular (its strict lower part at l, leading dimension ldl) */
+static void solve_unit_lower(int kd, int w, const double *l, int ldl, double *b, int ldb)
+{
+#pragma omp parallel for schedule(static)
+    for (int c0 = 0; c0 < w; c0 += UPDATE_COLS)
+    {
+        int c1 = c0 + UPDATE_COLS < w ? c0 + UPDATE_COLS : w;
+        for (int t = 1; t < kd; t++)
+        {
+            double *brow = b + (size_t)t * ldb;
+            for (int s = 0; s < t; s++)
+            {
+                double coeff = l[(size_t)t * ldl + s];
+                const double *srow = b + (size_t)s * ldb;
+                for (int col = c0; col < c1; col++)
+                {
+                    brow[col] -= coeff * srow[col];
+                }
+            }
+        }
+    }
+}
+
+/* B[kd x w] = U^-1 · B with U upper triangular at u, leading dimension ldu */
+static void solve_upper(int kd, int w, const double *u, int ldu, double *b, int ldb)
+{
+#pragma omp parallel for schedule(static)
+    for (int c0 = 0; c0 < w; c0 += UPDATE_COLS)
+    {
+        int c1 = c0 + UPDATE_COLS < w ? c0 + UPDATE_COLS : w;
+        for (int t = kd - 1; t >= 0; t--)
+        {
+            double *brow = b + (size_t)t * ldb;
+            for (int s = t + 1; s < kd; s++)
+            {
+                double coeff = u[(size_t)t * ldu + s];
+                const double *srow = b + (size_t)s * ldb;
+                for (int col = c0; col < c1; col++)
+                {
+                    brow[col] -= coeff * srow[col];
+                }
+            }
+            double scale = 1.0 / u[(size_t)t * ldu + t];
+            for (int col = c0; col < c1; col++)
+            {
+                brow[col] *= scale;
+            }
+        }
+    }
+}
+
+/* Apply the L part of factored panel j (rows from j·b down, later exchanges applied) to the n x w panel cur:
+ * its rows j·b .. j·b + w_j - 1 become U (or Y) rows and the rows below are updated */
+static void apply_factored_panel(const struct ooc_state *st, int j, const double *l, double *cur, int w)
+{
+    int n = st->n, jb = j * st->b, wj = panel_width(st, j);
+    solve_unit_lower(wj, w, l + (size_t)jb * wj, wj, cur + (size_t)jb * w, w);
+    panel_update(n - jb - wj, wj, w, l + (size_t)(jb + wj) * wj, wj, cur + (size_t)jb * w, w, cur + (size_t)(jb + wj) * w, w);
+}
+
+/* Factor panel k in memory with partial pivoting, rows above k·b are its finished U part */
+static bool factor_panel(struct ooc_state *st, int k, double *cur)
+{
+    int n = st->n, w = panel_width(st, k), kb = k * st->b;
+
+    for (int c = 0; c < w; c++)
+    {
+        int g = kb + c;
+        int p = g;
+        double best = fabs(cur[(size_t)g * w + c]);
+        for (int r = g + 1; r < n; r++)
+        {
+            double val = fabs(cur[(size_t)r * w + c]);
+            if (val > best)
+            {
+                best = val;
+                p = r;
+            }
+        }
+        if (best <= st->tol)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            return false;
+        }
+
+        st->ipiv[g] = p;
+        apply_swaps(cur, w, st->ipiv, g, g + 1);
+
+        const double *prow = cur + (size_t)g * w;
+        double scale = 1.0 / prow[c];
+#pragma omp parallel for schedule(static)
+        for (int r = g + 1; r < n; r++)
+        {
+            double *row = cur + (size_t)r * w;
+            double coeff = row[c] * scale;
+            row[c] = coeff;
+            for (int col = c + 1; col < w; col++)
+            {
+                row[col] -= coeff * prow[col];
+            }
+        }
+    }
+    return true;
+}
+
+/* Copy the input into the panel file, row block by row block, and sum the absolute column values */
+static bool load_panels(struct ooc_state *st, ooc_source source, void *ctx, double *colsum)
+{
+    int n = st->n, b = st->b;
+    double *rows = st->factor_buf[0]; /* b x n */
+    struct tile_io writes[STREAM_BUFFERS] = {{.pending = false}, {.pending = false}};
+    int parity = 0;
+    bool ok = true;
+
+    for (int row0 = 0; ok && row0 < n; row0 += b)
+    {
+        int nrows = row0 + b < n ? b : n - row0;
+        PROF_BEGIN(PHASE_READ);
+        ok = source(ctx, n, row0, nrows, rows);
+        PROF_END(PHASE_READ);
+
+        for (int r = 0; ok && r < nrows; r++)
+        {
+            for (int c = 0; c < n; c++)
+            {
+                colsum[c] += fabs(rows[(size_t)r * n + c]);
+            }
+        }
+
+        /* Pack the block's part of every panel and write it behind the next one */
+        for (int k = 0; ok && k < st->npanels; k++)
+        {
+            int w = panel_width(st, k);
+            double *pack = st->stream_buf[parity];
+            ok = wait_io(&writes[parity]);
+            for (int r = 0; ok && r < nrows; r++)
+            {
+                memcpy(pack + (size_t)r * w, rows + (size_t)r * n + (size_t)k * b, w * sizeof(double));
+            }
+            ok = ok && write_async(&writes[parity], st->fd, pack, (size_t)nrows * w, panel_offset(st, k, row0));
+            parity ^= 1;
+        }
+    }
+
+    for (int i = 0; i < STREAM_BUFFERS; i++)
+    {
+        ok = wait_io(&writes[i]) && ok;
+    }
+    return ok;
+}
+
+/* Move the stream to its next entry, false past the end of the phase */
+static bool next_entry(const struct ooc_state *st, struct panel_stream *ps, struct stream_entry *e)
+{
+    int n = st->n, b = st->b, np = st->npanels;
+
+    if (ps->phase == 1)
+    {
+        /* Step k reads panels 0 .. k-2 (k-1 is still resident), then the next step's panel */
+        if (ps->j <= ps->k - 2)
+        {
+            int j = ps->j++;
+            *e = (struct stream_entry){j, j * b, n - j * b, st->stream_buf[ps->parity]};
+            ps->parity ^= 1;
+            return true;
+        }
+        if (ps->k + 1 >= np)
+        {
+            return false;
+        }
+        ps->k++;
+        ps->j = 0;
+        *e = (struct stream_entry){ps->k, 0, n, st->factor_buf[ps->k % FACTOR_BUFFERS]};
+        return true;
+    }
+
+    /* Each column panel of the inverse reads the L parts left to right, then the U parts right to left */
+    if (ps->k >= np)
+    {
+        return false;
+    }
+    if (ps->j < np)
+    {
+        int j = ps->j;
+        *e = (struct stream_entry){j, j * b, n - j * b, st->stream_buf[ps->parity]};
+    }
+    else
+    {
+        int j = 2 * np - 1 - ps->j;
+        *e = (struct stream_entry){j, 0, j * b + panel_width(st, j), st->stream_buf[ps->parity]};
+    }
+    ps->parity ^= 1;
+    if (++ps->j == 2 * np)
+    {
+        ps->j = 0;
+        ps->k++;
+    }
+    return true;
+}
+
+/* Queue the read of the stream's next entry once no write back conflicts with it */
+static bool stream_issue(struct ooc_state *st, struct panel_stream *ps)
+{
+    ps->active = next_entry(st, ps, &ps->inflight);
+    if (!ps->active)
+    {
+        return true;
+    }
+
+    struct stream_entry *e = &ps->inflight;
+    for (int i = 0; i < FACTOR_BUFFERS; i++)
+    {
+        if (st->write_io[i].pending && (st->write_panel[i] == e->panel || st->factor_buf[i] == e->buf) &&
+            !wait_io(&st->write_io[i]))
+        {
+            return false;
+        }
+    }
+
+    int w = panel_width(st, e->panel);
+    size_t count = (size_t)e->nrows * w;
+    ooc_stats.read_bytes += count * sizeof(double);
+    return tile_io_start(&ps->io, st->fd, e->buf + (size_t)e->row0 * w, count * sizeof(double),
+                         panel_offset(st, e->panel, e->row0), false);
+}
+
+/* Wait for the entry in flight, queue the one after it and return the finished entry's buffer */
+static double *stream_take(struct ooc_state *st, struct panel_stream *ps)
+{
+    if (!ps->active || !wait_io(&ps->io))
+    {
+        return NULL;
+    }
+    double *buf = ps->inflight.buf;
+    return stream_issue(st, ps) ? buf : NULL;
+}
+
+static bool stream_drain(struct panel_stream *ps)
+{
+    return wait_io(&ps->io);
+}
+
+/* Left-looking LU factorization of all panels */
+static bool factor_panels(struct ooc_state *st)
+{
+    int n = st->n, b = st->b;
+    struct panel_stream ps = {.phase = 1, .k = -1, .j = 0, .parity = 0};
+    bool ok = stream_issue(st, &ps);
+
+    for (int k = 0; ok && k < st->npanels; k++)
+    {
+        int w = panel_width(st, k);
+        double *cur = stream_take(st, &ps);
+        ok = cur != NULL;
+        if (ok)
+        {
+            apply_swaps(cur, w, st->ipiv, 0, k * b);
+        }
+
+        for (int j = 0; ok && j <= k - 2; j++)
+        {
+            double *l = stream_take(st, &ps);
+            ok = l != NULL;
+            if (ok)
+            {
+                apply_swaps(l, panel_width(st, j), st->ipiv, (j + 1) * b, k * b);
+                apply_factored_panel(st, j, l, cur, w);
+            }
+        }
+
+        if (ok && k >= 1)
+        {
+            /* Panel k-1 is still resident and needs no further exchanges */
+            apply_factored_panel(st, k - 1, st->factor_buf[(k - 1) % FACTOR_BUFFERS], cur, w);
+        }
+
+        ok = ok && factor_panel(st, k, cur);
+        if (ok)
+        {
+            int slot = k % FACTOR_BUFFERS;
+            st->write_panel[slot] = k;
+            ok = write_async(&st->write_io[slot], st->fd, cur, (size_t)n * w, panel_offset(st, k, 0));
+        }
+    }
+
+    ok = stream_drain(&ps) && ok;
+    for (int i = 0; i < FACTOR_BUFFERS; i++)
+    {
+        ok = wait_io(&st->write_io[i]) && ok;
+    }
+    return ok;
+}
+
+/* Solve for the inverse one column panel at a time and pass each one to the sink */
+static bool solve_panels(struct ooc_state *st, ooc_sink sink, void *ctx, double *xnorm)
+{
+    int n = st->n, b = st->b, np = st->npanels;
+    double *y = st->factor_buf[0];
+    struct panel_stream ps = {.phase = 2, .k = 0, .j = 0, .parity = 0};
+    bool ok = stream_issue(st, &ps);
+
+    for (int c = 0; ok && c < np; c++)
+    {
+        int w = panel_width(st, c);
+
+        /* Y = P·E_c, the pivoted identity columns */
+        memset(y, 0, (size_t)n * w * sizeof(double));
+        for (int t = 0; t < w; t++)
+        {
+            y[(size_t)(c * b + t) * w + t] = 1.0;
+        }
+        apply_swaps(y, w, st->ipiv, 0, n);
+
+        /* Forward substitution: Y = L^-1·Y */
+        for (int j = 0; ok && j < np; j++)
+        {
+            double *l = stream_take(st, &ps);
+            ok = l != NULL;
+            if (ok)
+            {
+                apply_swaps(l, panel_width(st, j), st->ipiv, (j + 1) * b, n);
+                apply_factored_panel(st, j, l, y, w);
+            }
+        }
+
+        /* Back substitution: X = U^-1·Y */
+        for (int j = np - 1; ok && j >= 0; j--)
+        {
+            double *u = stream_take(st, &ps);
+            ok = u != NULL;
+            if (ok)
+            {
+                int jb = j * b, wj = panel_width(st, j);
+                solve_upper(wj, w, u + (size_t)jb * wj, wj, y + (size_t)jb * w, w);
+                panel_update(jb, wj, w, u, wj, y + (size_t)jb * w, w, y, w);
+            }
+        }
+
+        if (ok)
+        {
+            for (int t = 0; t < w; t++)
+            {
+                double sum = 0.0;
+                for (int r = 0; r < n; r++)
+                {
+                    sum += fabs(y[(size_t)r * w + t]);
+                }
+                *xnorm = sum > *xnorm ? sum : *xnorm;
+            }
+
+            PROF_BEGIN(PHASE_EXTRACT);
+            ok = sink(ctx, n, c * b, w, y);
+            PROF_END(PHASE_EXTRACT);
+        }
+    }
+
+    return stream_drain(&ps) && ok;
+}
+
+bool invert_matrix_ooc(int n, ooc_source source, void *source_ctx, ooc_sink sink, void *sink_ctx)
+{
+    struct ooc_state st = {.n = n, .b = ooc_panel_width(n)};
+    if (st.b == 0)
+    {
+        printf("The out-of-core memory limit of %.1f MB is too small for a %dx%d matrix.\n", ooc_memory / MIB, n, n);
+        return false;
+    }
+    st.npanels = (n + st.b - 1) / st.b;
+    memset(&ooc_stats, 0, sizeof(ooc_stats));
+
+    st.fd = tile_scratch_file(ooc_scratch_dir);
+    if (st.fd < 0)
+    {
+        return false;
+    }
+
+    size_t panel_bytes = (size_t)n * st.b * sizeof(double);
+    bool ok = true;
+    for (int i = 0; i < FACTOR_BUFFERS; i++)
+    {
+        st.factor_buf[i] = malloc(panel_bytes);
+        ok = ok && st.factor_buf[i];
+    }
+    for (int i = 0; i < STREAM_BUFFERS; i++)
+    {
+        st.stream_buf[i] = malloc(panel_bytes);
+        ok = ok && st.stream_buf[i];
+    }
+    st.ipiv = malloc(n * sizeof(int));
+    double *colsum = calloc(n, sizeof(double));
+    if (!ok || !st.ipiv || !colsum)
+    {
+        perror("malloc (out-of-core panels)");
+        ok = false;
+    }
+
+    double anorm = 0.0, xnorm = 0.0;
+    ok = ok && load_panels(&st, source, source_ctx, colsum);
+    if (ok)
+    {
+        for (int c = 0; c < n; c++)
+        {
+            anorm = colsum[c] > anorm ? colsum[c] : anorm;
+        }
+        st.tol = DBL_EPSILON * anorm;
+
+        PROF_BEGIN(PHASE_ELIMINATION);
+        ok = factor_panels(&st);
+        PROF_END(PHASE_ELIMINATION);
+    }
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_RREF);
+        ok = solve_panels(&st, sink, sink_ctx, &xnorm);
+        PROF_END(PHASE_RREF);
+    }
+
+    /* The exact 1-norm condition number comes for free from the column panels of the inverse */
+    ok = ok && cond_accept(anorm * xnorm);
+
+    free(colsum);
+    free(st.ipiv);
+    for (int i = 0; i < STREAM_BUFFERS; i++)
+    {
+        free(st.stream_buf[i]);
+    }
+    for (int i = 0; i < FACTOR_BUFFERS; i++)
+    {
+        free(st.factor_buf[i]);
+    }
+    close(st.fd);
+    return ok;
+}
+
+static bool memory_source(void *ctx, int n, int row0, int nrows, double *rows)
+{
+    const double *mat = ctx;
+    memcpy(rows, mat + (size_t)row0 * n, (size_t)nrows * n * sizeof(double));
+    return true;
+}
+
+static bool memory_sink(void *ctx, int n, int col0, int ncols, const double *panel)
+{
+    double *mat_inv = ctx;
+    for (int r = 0; r < n; r++)
+    {
+        memcpy(mat_inv + (size_t)r * n + col0, panel + (size_t)r * ncols, ncols * sizeof(double));
+    }
+    return true;
+}
+
+bool invert_matrix_ooc_in_memory(int n, double mat[n][n], double mat_inv[n][n])
+{
+    return invert_matrix_ooc(n, memory_source, mat, memory_sink, mat_inv);
+}
+
+bool ooc_open_input(struct ooc_file *file, const char *filepath)
+{
+    int ncol;
+    if (!read_binary_matrix_header(filepath, &file->n, &ncol))
+    {
+        return false;
+    }
+    if (file->n != ncol)
+    {
+        printf("Matrix in %s is not square (%dx%d).\n", filepath, file->n, ncol);
+        return false;
+    }
+
+    file->fd = open(filepath, O_RDONLY);
+    if (file->fd < 0)
+    {
+        perror("Error opening file");
+        return false;
+    }
+    printf("Streaming %dx%d matrix from %s\n", file->n, file->n, filepath);
+    return true;
+}
+
+bool ooc_create_output(struct ooc_file *file, const char *filepath, int n)
+{
+    file->n = n;
+    file->fd = create_binary_matrix_file(filepath, n, n) ? open(filepath, O_WRONLY) : -1;
+    if (file->fd < 0)
+    {
+        perror("Error opening output file");
+        return false;
+    }
+    return true;
+}
+
+void ooc_close(struct ooc_file *file)
+{
+    if (file->fd >= 0)
+    {
+        close(file->fd);
+        file->fd = -1;
+    }
+}
+
+bool ooc_file_source(void *ctx, int n, int row0, int nrows, double *rows)
+{
+    struct ooc_file *file = ctx;
+    off_t offset = BINARY_MATRIX_DATA_OFFSET + (off_t)row0 * n * (off_t)sizeof(double);
+    return tile_pread(file->fd, rows, (size_t)nrows * n * sizeof(double), offset);
+}
+
+bool ooc_file_sink(void *ctx, int n, int col0, int ncols, const double *panel)
+{
+    struct ooc_file *file = ctx;
+    for (int r = 0; r < n; r++)
+    {
+        off_t offset = BINARY_MATRIX_DATA_OFFSET + ((off_t)r * n + col0) * (off_t)sizeof(double);
+        if (!tile_pwrite(file->fd, panel + (size_t)r * ncols, ncols * sizeof(double), offset))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool benchmark_matrix_inversion_ooc(int n, ooc_source source, void *source_ctx, ooc_sink sink, void *sink_ctx)
+{
+    double start = now_ms();
+    if (!invert_matrix_ooc(n, source, source_ctx, sink, sink_ctx))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double elapsed_time = now_ms() - start;
+
+    int b = ooc_panel_width(n);
+    printf("Matrix inversion (Out-of-core) completed in %.3f ms for %dx%d matrix.\n", elapsed_time, n, n);
+    cond_report(stdout);
+    printf("Out-of-core: %d panels of %d columns (%.1f MB resident), %.1f MB read, %.1f MB written, %.3f ms waiting for I/O.\n",
+           (n + b - 1) / b, b, RESIDENT_PANELS * (double)n * b * sizeof(double) / MIB, ooc_stats.read_bytes / MIB,
+           ooc_stats.written_bytes / MIB, ooc_stats.wait_ms);
+    return true;
+}
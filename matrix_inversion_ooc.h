@@ -0,0 +1,52 @@
+#ifndef MATRIX_INVERSION_OOC_H
+#define MATRIX_INVERSION_OOC_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Out-of-core inversion for matrices larger than memory.
+ *
+ * The matrix is copied into a scratch file as column panels ("tile
+ * columns") of b columns, each stored as a contiguous n x b row-major
+ * block. A left-looking LU factorization with partial pivoting then
+ * factors one panel at a time: it reads the panel, applies the updates of
+ * all factored panels to its left while streaming them in, factors it and
+ * writes it back. The inverse is built one column panel at a time by
+ * forward and back substitution, again streaming the factors. Only five
+ * panels are resident, b is chosen to fit the memory limit, and the next
+ * panel is read with asynchronous I/O while the current one is updated.
+ */
+
+/* Fill rows row0 .. row0 + nrows - 1 of the n x n input, row-major, into rows */
+typedef bool (*ooc_source)(void *ctx, int n, int row0, int nrows, double *rows);
+
+/* Take columns col0 .. col0 + ncols - 1 of the inverse, an n x ncols row-major panel */
+typedef bool (*ooc_sink)(void *ctx, int n, int col0, int ncols, const double *panel);
+
+/* Memory for resident panels (default 1 GiB) and directory of the scratch file (NULL: $TMPDIR or /tmp) */
+void ooc_set_memory_limit(size_t bytes);
+void ooc_set_scratch_dir(const char *dir);
+
+/* Columns per panel for an n x n matrix under the memory limit, 0 if it does not fit */
+int ooc_panel_width(int n);
+
+bool invert_matrix_ooc(int n, ooc_source source, void *source_ctx, ooc_sink sink, void *sink_ctx);
+
+/* In-memory input and output, for comparing with the in-core engines */
+bool invert_matrix_ooc_in_memory(int n, double mat[n][n], double mat_inv[n][n]);
+
+/* Binary (.bin) matrix files as source and sink, rows are read and written in place */
+struct ooc_file
+{
+    int fd;
+    int n;
+};
+
+bool ooc_open_input(struct ooc_file *file, const char *filepath);
+bool ooc_create_output(struct ooc_file *file, const char *filepath, int n);
+void ooc_close(struct ooc_file *file);
+bool ooc_file_source(void *ctx, int n, int row0, int nrows, double *rows);
+bool ooc_file_sink(void *ctx, int n, int col0, int ncols, const double *panel);
+
+bool benchmark_matrix_inversion_ooc(int n, ooc_source source, void *source_ctx, ooc_sink sink, void *sink_ctx);
+
+#endif
@@ -0,0 +1,373 @@
+/**
+ * @file matrix_inversion_selected.c
+ * @brief Selected entries of the inverse from an LU factorization with partial pivoting
+ *
+ * Only the left n x n block is factored, in place: logical row k of L\U is
+ * stored in row perm[k] (pos is the inverse), with the multipliers of L left
+ * of the diagonal and U from it on. PA = LU, so column c of the inverse
+ * solves L·y = P·e_c, where P·e_c is 1 in logical row pos[c], and then
+ * U·z = y. The columns of U are those of A, so z[i] is row i of the column.
+ * */
+
+#include "matrix_inversion_selected.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
+#include "helpers/placement.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+/* Below this many candidate rows the pivot search is not worth a parallel region */
+#define PIVOT_SEARCH_PAR_MIN 512
+
+/* One wanted entry of the inverse and where it goes */
+struct selected_target
+{
+    int row, col;
+    double *out;
+};
+
+/* By column, then by row: each column becomes one run that starts with its topmost row */
+static int compare_targets(const void *a, const void *b)
+{
+    const struct selected_target *x = a, *y = b;
+    if (x->col != y->col)
+    {
+        return x->col < y->col ? -1 : 1;
+    }
+    return (x->row > y->row) - (x->row < y->row);
+}
+
+/* Logical row in [i, n) of the largest magnitude in column i, ties go to the lowest row */
+static int find_pivot_lu(int i, int n, const double lu[n][n], const int pos[n], int chunk)
+{
+    int best = i;
+    double best_val = -1.0;
+
+#pragma omp parallel if (n - i > PIVOT_SEARCH_PAR_MIN)
+    {
+        int local = i;
+        double local_val = -1.0;
+#pragma omp for schedule(static, chunk) nowait
+        for (int p = 0; p < n; p++)
+        {
+            double val = fabs(lu[p][i]);
+            if (pos[p] >= i && (val > local_val || (val == local_val && pos[p] < local)))
+            {
+                local_val = val;
+                local = pos[p];
+            }
+        }
+#pragma omp critical(selected_pivot_search)
+        {
+            if (local_val > best_val || (local_val == best_val && local < best))
+            {
+                best_val = local_val;
+                best = local;
+            }
+        }
+    }
+    return best;
+}
+
+/* LU factorization with partial pivoting in place, rows are updated by their owners in chunks of chunk rows */
+static bool factor_lu(int n, double lu[n][n], int perm[n], int pos[n], double tol, int chunk)
+{
+    for (int i = 0; i < n; i++)
+    {
+        perm[i] = i;
+        pos[i] = i;
+    }
+
+    for (int i = 0; i < n; i++)
+    {
+        int best = find_pivot_lu(i, n, lu, pos, chunk);
+        if (fabs(lu[perm[best]][i]) <= tol)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            return false;
+        }
+        int tmp = perm[i];
+        perm[i] = perm[best];
+        perm[best] = tmp;
+        pos[perm[i]] = i;
+        pos[perm[best]] = best;
+
+        /* The multiplier replaces the entry it clears, only the trailing columns are updated */
+        const double *pivot = lu[perm[i]];
+        double scale = 1.0 / pivot[i];
+#pragma omp parallel for schedule(static, chunk)
+        for (int p = 0; p < n; p++)
+        {
+            if (pos[p] > i)
+            {
+                double *row = lu[p];
+                double coeff = row[i] * scale;
+                row[i] = coeff;
+#pragma omp simd
+                for (int j = i + 1; j < n; j++)
+                {
+                    row[j] -= coeff * pivot[j];
+                }
+            }
+        }
+    }
+
+    /* n(n-1)/2 rows updated over their n - i - 1 trailing columns, about n^3 / 3 multiply-adds */
+    PROF_WORK(PHASE_ELIMINATION, 2.0 * n * n * n / 3.0, 16.0 * n * n * n / 3.0);
+    return true;
+}
+
+/* z[row0 .. n) of column col of the inverse: the forward substitution starts at the 1 of P·e_col, the back
+ * substitution runs from the bottom row up and stops at row0 */
+static void solve_column(int n, const double lu[n][n], const int perm[n], const int pos[n], int col, int row0, double z[n])
+{
+    int q = pos[col];
+    for (int k = row0; k < q; k++)
+    {
+        z[k] = 0.0;
+    }
+    z[q] = 1.0;
+    for (int k = q + 1; k < n; k++)
+    {
+        const double *row = lu[perm[k]];
+        double sum = 0.0;
+        for (int m = q; m < k; m++)
+        {
+            sum -= row[m] * z[m];
+        }
+        z[k] = sum;
+    }
+
+    for (int k = n - 1; k >= row0; k--)
+    {
+        const double *row = lu[perm[k]];
+        double sum = z[k];
+        for (int m = k + 1; m < n; m++)
+        {
+            sum -= row[m] * z[m];
+        }
+        z[k] = sum / row[k];
+    }
+}
+
+/* One target per wanted entry, sorted into runs of equal columns. NULL (after printing why) if a block is
+ * outside the matrix or out of memory. */
+static struct selected_target *collect_targets(int n, int count, const struct inverse_block blocks[count], size_t *ntargets)
+{
+    size_t total = 0;
+    for (int b = 0; b < count; b++)
+    {
+        const struct inverse_block *blk = &blocks[b];
+        if (blk->row0 < 0 || blk->col0 < 0 || blk->nrows < 0 || blk->ncols < 0 || blk->row0 > n - blk->nrows ||
+            blk->col0 > n - blk->ncols)
+        {
+            fprintf(stderr, "Selected inversion: block %d is outside the %dx%d matrix.\n", b, n, n);
+            return NULL;
+        }
+        total += (size_t)blk->nrows * blk->ncols;
+    }
+
+    struct selected_target *targets = malloc((total > 0 ? total : 1) * sizeof(*targets));
+    if (!targets)
+    {
+        perror("malloc (selected entries)");
+        return NULL;
+    }
+    size_t t = 0;
+    for (int b = 0; b < count; b++)
+    {
+        const struct inverse_block *blk = &blocks[b];
+        for (int i = 0; i < blk->nrows; i++)
+        {
+            for (int j = 0; j < blk->ncols; j++)
+            {
+                targets[t++] = (struct selected_target){blk->row0 + i, blk->col0 + j, blk->values + (size_t)i * blk->ncols + j};
+            }
+        }
+    }
+    qsort(targets, total, sizeof(*targets), compare_targets);
+    *ntargets = total;
+    return targets;
+}
+
+/* Forward and back substitution of every wanted column, a column per task */
+static bool solve_targets(int n, const double lu[n][n], const int perm[n], const int pos[n], size_t ntargets,
+                          const struct selected_target targets[])
+{
+    /* Start of each run of one column, plus an end marker */
+    size_t *start = malloc((ntargets + 1) * sizeof(size_t));
+    double *scratch = malloc((size_t)omp_get_max_threads() * n * sizeof(double));
+    if (!start || !scratch)
+    {
+        perror("malloc (selected columns)");
+        free(start);
+        free(scratch);
+        return false;
+    }
+    int ncols = 0;
+    double flops = 0.0;
+    for (size_t t = 0; t < ntargets; t++)
+    {
+        if (t == 0 || targets[t].col != targets[t - 1].col)
+        {
+            start[ncols++] = t;
+            int q = pos[targets[t].col], row0 = targets[t].row;
+            flops += (double)(n - q) * (n - q) + (double)(n - row0) * (n - row0);
+        }
+    }
+    start[ncols] = ntargets;
+
+    /* The pivot position and the topmost row decide the cost of a column, dynamic scheduling evens it out */
+#pragma omp parallel
+    {
+        double *z = scratch + (size_t)omp_get_thread_num() * n;
+#pragma omp for schedule(dynamic)
+        for (int c = 0; c < ncols; c++)
+        {
+            const struct selected_target *first = &targets[start[c]];
+            solve_column(n, lu, perm, pos, first->col, first->row, z);
+            for (size_t t = start[c]; t < start[c + 1]; t++)
+            {
+                *targets[t].out = z[targets[t].row];
+            }
+        }
+    }
+    PROF_WORK(PHASE_RREF, flops, 4.0 * flops);
+    free(scratch);
+    free(start);
+    return true;
+}
+
+bool invert_selected_ws(int n, double mat[n][n], struct inversion_workspace *ws, int count, struct inverse_block blocks[count])
+{
+    /* Only the left half of the augmented matrix is needed, as an n x n matrix */
+    double (*lu)[n] = (double (*)[n])ws->aug;
+    int *perm = ws->perm, *pos = ws->perm + n, chunk = ws->chunk;
+    ws->cond = -1.0;
+
+    size_t ntargets;
+    struct selected_target *targets = collect_targets(n, count, blocks, &ntargets);
+    if (!targets)
+    {
+        return false;
+    }
+
+    /* First touch by the owner of each chunk of rows */
+    PROF_BEGIN(PHASE_AUGMENT);
+#pragma omp parallel for schedule(static, chunk)
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = 0; j < n; j++)
+        {
+            lu[i][j] = mat[i][j];
+        }
+    }
+    PROF_END(PHASE_AUGMENT);
+    double anorm = cond_norm1(n, n, lu, 0);
+
+    PROF_BEGIN(PHASE_ELIMINATION);
+    bool ok = factor_lu(n, lu, perm, pos, cond_pivot_tolerance(n, n, lu), chunk);
+    PROF_END(PHASE_ELIMINATION);
+    if (!ok)
+    {
+        printf("LU factorization failed.\n");
+        free(targets);
+        return false;
+    }
+
+    PROF_BEGIN(PHASE_CONDITION);
+    ws->cond = anorm * cond_estimate_lu_work(n, n, lu, perm, ws->work);
+    ok = cond_check(ws->cond, ws->cond_limit);
+    PROF_END(PHASE_CONDITION);
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_RREF);
+        ok = solve_targets(n, lu, perm, pos, ntargets, targets);
+        PROF_END(PHASE_RREF);
+    }
+    free(targets);
+    return ok;
+}
+
+bool invert_selected(int n, double mat[n][n], int count, struct inverse_block blocks[count])
+{
+    size_t bytes = sizeof(double[n][n]), page_bytes;
+    double (*lu)[n] = placement_alloc(bytes, &page_bytes);
+    int *perm = malloc(2 * n * sizeof(int));
+    double *work = malloc(4 * n * sizeof(double));
+    if (!lu || !perm || !work)
+    {
+        perror("malloc (LU factors)");
+        placement_free(lu, bytes, page_bytes);
+        free(perm);
+        free(work);
+        return false;
+    }
+    int chunk = placement_chunk_rows(sizeof(double[n]), page_bytes);
+
+    placement_pin_threads();
+    struct inversion_workspace ws = {&lu[0][0], perm, work, chunk, cond_get_limit(), -1.0};
+    bool ok = invert_selected_ws(n, mat, &ws, count, blocks);
+    if (ws.cond >= 0.0)
+    {
+        cond_record(ws.cond);
+    }
+    free(work);
+    free(perm);
+    placement_free(lu, bytes, page_bytes);
+    return ok;
+}
+
+bool invert_selected_entries(int n, double mat[n][n], int count, const int rows[count], const int cols[count], double values[count])
+{
+    struct inverse_block *blocks = malloc((count > 0 ? count : 1) * sizeof(*blocks));
+    if (!blocks)
+    {
+        perror("malloc (selected entries)");
+        return false;
+    }
+    for (int k = 0; k < count; k++)
+    {
+        blocks[k] = (struct inverse_block){rows[k], 1, cols[k], 1, &values[k]};
+    }
+    bool ok = invert_selected(n, mat, count, blocks);
+    free(blocks);
+    return ok;
+}
+
+bool invert_diagonal(int n, double mat[n][n], double diag[n])
+{
+    struct inverse_block *blocks = malloc(n * sizeof(*blocks));
+    if (!blocks)
+    {
+        perror("malloc (selected entries)");
+        return false;
+    }
+    for (int i = 0; i < n; i++)
+    {
+        blocks[i] = (struct inverse_block){i, 1, i, 1, &diag[i]};
+    }
+    bool ok = invert_selected(n, mat, n, blocks);
+    free(blocks);
+    return ok;
+}
+
+bool benchmark_inversion_diagonal(int n, double mat[n][n], double diag[n])
+{
+    double start = now_ms();
+    if (!invert_diagonal(n, mat, diag))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double elapsed_time = now_ms() - start;
+
+    printf("Matrix inversion (Selected) completed in %.3f ms for %dx%d matrix.\n", elapsed_time, n, n);
+    cond_report(stdout);
+    printf("Selected: %d diagonal entries, %d threads.\n", n, omp_get_max_threads());
+    return true;
+}
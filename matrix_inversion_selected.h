@@ -0,0 +1,45 @@
+#ifndef MATRIX_INVERSION_SELECTED_H
+#define MATRIX_INVERSION_SELECTED_H
+#include <stdbool.h>
+
+#include "inversion_workspace.h"
+
+/* Selected inversion: only the requested entries of A^-1.
+ *
+ * A is factored once as PA = LU with partial pivoting, 2n^3 / 3 flops, in
+ * the left n x n block of the workspace: there is no identity to sweep
+ * along. Column c of A^-1 then takes a forward substitution with L, which
+ * starts at the pivot position q of row c because P·e_c is zero above it,
+ * and a back substitution with U, which runs upwards and stops at the
+ * topmost wanted row i: (n - q)^2 + (n - i)^2 flops, shared by all entries
+ * of the column. A few entries cost a third of a full Gauss-Jordan
+ * inversion, the whole diagonal about two thirds.
+ *
+ * The wanted columns are solved in parallel, one column per task.
+ */
+
+/* Rows row0 .. row0 + nrows - 1 and columns col0 .. col0 + ncols - 1 of the inverse */
+struct inverse_block
+{
+    int row0, nrows;
+    int col0, ncols;
+    double *values; /* Out: nrows x ncols, row-major */
+};
+
+/* Fill every block with its entries of the inverse of the n x n matrix mat, mat is left unchanged.
+ * Blocks may overlap. Only the bookkeeping of the selection is allocated, the factorization runs in
+ * the first n x n doubles of ws->aug and ws->cond gets its condition number estimate. */
+bool invert_selected_ws(int n, double mat[n][n], struct inversion_workspace *ws, int count, struct inverse_block blocks[count]);
+
+/* The same with a workspace of its own, the condition number goes to cond_report */
+bool invert_selected(int n, double mat[n][n], int count, struct inverse_block blocks[count]);
+
+/* values[k] = A^-1[rows[k]][cols[k]] */
+bool invert_selected_entries(int n, double mat[n][n], int count, const int rows[count], const int cols[count], double values[count]);
+
+/* diag[i] = A^-1[i][i] */
+bool invert_diagonal(int n, double mat[n][n], double diag[n]);
+
+bool benchmark_inversion_diagonal(int n, double mat[n][n], double diag[n]);
+
+#endif
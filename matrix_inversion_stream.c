@@ -0,0 +1,366 @@
+/**
+ * @file matrix_inversion_stream.c
+ * @brief Gauss-Jordan inversion overlapped with reading the input
+ *
+ * The elimination runs on [A | I] with complete rows and partial pivoting
+ * over columns: row i takes its largest entry among the columns not yet
+ * pivoted, and that column is exchanged into position i in every row held
+ * so far (later rows are gathered through colperm as they arrive). Once
+ * the block of rows [i0, i1) is done, each of the rows 0 .. i1 - 1 has a 1
+ * in its own position, 0 in the other positions below i1, and its inverse
+ * half is zero from column i1 on. An arriving row therefore only needs
+ *
+ *   row -= sum over k < i0 of row[k]·row_k
+ *
+ * with the coefficients taken from the row as read, since no finished
+ * row has an entry in another finished pivot position. At the end the
+ * left half is the identity, M·A·Q = I with Q the column exchanges, and
+ * A^-1 = Q·M: row i of M is row colperm[i] of the inverse.
+ * */
+
+#include "matrix_inversion_stream.h"
+#include "helpers/bounded_queue.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
+#include <omp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+/* Rows handed over at once, the last block is all the work left after the read */
+#define STREAM_BLOCK_ROWS 64
+
+/* Finished rows applied per pass over a block, about 512 KiB at n = 2000 so they stay in L2 */
+#define STREAM_K_BLOCK 16
+
+/* A block narrower than this many rows times columns is factored on one thread */
+#define STREAM_PAR_MIN_WORK 65536
+
+struct stream_block
+{
+    int row0;
+    int nrows;
+};
+
+struct stream_reader
+{
+    int n;
+    stream_source source;
+    void *ctx;
+    double *mat;
+    struct stream_block *blocks;
+    int nblocks;
+    struct bounded_queue *ready;
+    bool ok;
+    double done_ms; /* When the last row was read */
+};
+
+/* Time the last read finished, for benchmark_matrix_inversion_stream */
+static double last_read_done_ms;
+
+/* Read the blocks in order and hand each one over, a closed queue means the consumer gave up */
+static void *stream_reader_worker(void *arg)
+{
+    struct stream_reader *reader = arg;
+    int n = reader->n;
+
+    PROF_BEGIN(PHASE_READ);
+    for (int b = 0; b < reader->nblocks && reader->ok; b++)
+    {
+        struct stream_block *block = &reader->blocks[b];
+        reader->ok = reader->source(reader->ctx, n, block->row0, block->nrows, reader->mat + (size_t)block->row0 * n) &&
+                     bq_push(reader->ready, block);
+    }
+    PROF_END(PHASE_READ);
+
+    reader->done_ms = now_ms();
+    bq_close(reader->ready);
+    return NULL;
+}
+
+/* Gather the rows [i0, i1) of the input through colperm and reduce them against the finished rows
+ * before them. The passes over the finished rows keep the same static schedule, so each thread
+ * keeps its rows of the block. */
+static void reduce_against_finished(int n, double aug[n][2 * n], const double mat[n][n], const int *colperm, int i0, int i1)
+{
+#pragma omp parallel
+    {
+        PROF_BEGIN(PHASE_ROW_UPDATE);
+#pragma omp for schedule(static) nowait
+        for (int i = i0; i < i1; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                aug[i][j] = mat[i][colperm[j]];
+            }
+            memset(&aug[i][n], 0, n * sizeof(double));
+            aug[i][n + i] = 1.0;
+        }
+
+        for (int kb = 0; kb < i0; kb += STREAM_K_BLOCK)
+        {
+            int kend = kb + STREAM_K_BLOCK < i0 ? kb + STREAM_K_BLOCK : i0;
+#pragma omp for schedule(static) nowait
+            for (int i = i0; i < i1; i++)
+            {
+                double *row = aug[i];
+                for (int k = kb; k < kend; k++)
+                {
+                    double coeff = row[k];
+                    if (coeff == 0.0)
+                    {
+                        continue;
+                    }
+                    const double *done = aug[k];
+#pragma omp simd
+                    for (int j = i0; j < n + i0; j++)
+                    {
+                        row[j] -= coeff * done[j];
+                    }
+                }
+            }
+        }
+
+#pragma omp for schedule(static) nowait
+        for (int i = i0; i < i1; i++)
+        {
+            memset(aug[i], 0, i0 * sizeof(double));
+        }
+        PROF_END(PHASE_ROW_UPDATE);
+    }
+}
+
+/* Gauss-Jordan on the rows [i0, i1) alone, pivoting on the columns from i0 on. The exchanges reach
+ * the finished rows too, min_pivot receives the smallest pivot magnitude. */
+static bool factor_block(int n, double aug[n][2 * n], int *colperm, int i0, int i1, double *min_pivot)
+{
+    for (int t = i0; t < i1; t++)
+    {
+        double *prow = aug[t];
+        int c = t;
+        for (int j = t + 1; j < n; j++)
+        {
+            if (fabs(prow[j]) > fabs(prow[c]))
+            {
+                c = j;
+            }
+        }
+        if (prow[c] == 0.0)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            return false;
+        }
+
+        if (c != t)
+        {
+            for (int r = 0; r < i1; r++)
+            {
+                double tmp = aug[r][c];
+                aug[r][c] = aug[r][t];
+                aug[r][t] = tmp;
+            }
+            int tmp = colperm[c];
+            colperm[c] = colperm[t];
+            colperm[t] = tmp;
+        }
+        *min_pivot = fmin(*min_pivot, fabs(prow[t]));
+
+        // Only columns past t and the inverse half up to i1 can be nonzero
+        double scale = 1.0 / prow[t];
+        prow[t] = 1.0;
+        for (int j = t + 1; j < n + i1; j++)
+        {
+            prow[j] *= scale;
+        }
+
+#pragma omp parallel for schedule(static) if ((i1 - i0) * n >= STREAM_PAR_MIN_WORK)
+        for (int u = i0; u < i1; u++)
+        {
+            double *row = aug[u];
+            double coeff = row[t];
+            if (u == t || coeff == 0.0)
+            {
+                continue;
+            }
+            row[t] = 0.0;
+#pragma omp simd
+            for (int j = t + 1; j < n + i1; j++)
+            {
+                row[j] -= coeff * prow[j];
+            }
+        }
+    }
+    return true;
+}
+
+/* Eliminate the pivot columns [i0, i1) of the new block from the finished rows before it */
+static void eliminate_from_finished(int n, double aug[n][2 * n], int i0, int i1)
+{
+#pragma omp parallel
+    {
+        PROF_BEGIN(PHASE_ROW_UPDATE);
+        for (int tb = i0; tb < i1; tb += STREAM_K_BLOCK)
+        {
+            int tend = tb + STREAM_K_BLOCK < i1 ? tb + STREAM_K_BLOCK : i1;
+#pragma omp for schedule(static) nowait
+            for (int k = 0; k < i0; k++)
+            {
+                double *row = aug[k];
+                for (int t = tb; t < tend; t++)
+                {
+                    double coeff = row[t];
+                    if (coeff == 0.0)
+                    {
+                        continue;
+                    }
+                    const double *prow = aug[t];
+#pragma omp simd
+                    for (int j = i1; j < n + i1; j++)
+                    {
+                        row[j] -= coeff * prow[j];
+                    }
+                }
+            }
+        }
+
+#pragma omp for schedule(static) nowait
+        for (int k = 0; k < i0; k++)
+        {
+            memset(&aug[k][i0], 0, (i1 - i0) * sizeof(double));
+        }
+        PROF_END(PHASE_ROW_UPDATE);
+    }
+}
+
+bool invert_matrix_stream(int n, stream_source source, void *source_ctx, double mat[n][n], double mat_inv[n][n])
+{
+    int nblocks = (n + STREAM_BLOCK_ROWS - 1) / STREAM_BLOCK_ROWS;
+    double (*aug)[2 * n] = malloc(sizeof(double[n][2 * n]));
+    int *colperm = malloc(n * sizeof(int));
+    struct stream_block *blocks = malloc(nblocks * sizeof(struct stream_block));
+    struct bounded_queue ready;
+    if (!aug || !colperm || !blocks || !bq_init(&ready, nblocks))
+    {
+        perror("malloc (streaming inversion)");
+        free(blocks);
+        free(colperm);
+        free(aug);
+        return false;
+    }
+
+    for (int b = 0; b < nblocks; b++)
+    {
+        int row0 = b * STREAM_BLOCK_ROWS;
+        blocks[b] = (struct stream_block){row0, n - row0 < STREAM_BLOCK_ROWS ? n - row0 : STREAM_BLOCK_ROWS};
+    }
+    for (int j = 0; j < n; j++)
+    {
+        colperm[j] = j;
+    }
+
+    /* The queue holds every block, so the reader never waits for the elimination */
+    struct stream_reader reader = {n, source, source_ctx, &mat[0][0], blocks, nblocks, &ready, true, 0.0};
+    pthread_t reader_thread;
+    if (pthread_create(&reader_thread, NULL, stream_reader_worker, &reader) != 0)
+    {
+        perror("pthread_create (matrix reader)");
+        bq_destroy(&ready);
+        free(blocks);
+        free(colperm);
+        free(aug);
+        return false;
+    }
+
+    bool ok = true;
+    double min_pivot = INFINITY;
+    void *item;
+    for (;;)
+    {
+        PROF_BEGIN(PHASE_TILE_WAIT);
+        bool arrived = bq_pop(&ready, &item);
+        PROF_END(PHASE_TILE_WAIT);
+        if (!arrived)
+        {
+            break;
+        }
+
+        const struct stream_block *block = item;
+        int i0 = block->row0, i1 = block->row0 + block->nrows;
+        PROF_BEGIN(PHASE_ELIMINATION);
+        reduce_against_finished(n, aug, mat, colperm, i0, i1);
+        ok = factor_block(n, aug, colperm, i0, i1, &min_pivot);
+        if (ok)
+        {
+            eliminate_from_finished(n, aug, i0, i1);
+        }
+        PROF_END(PHASE_ELIMINATION);
+
+        if (!ok)
+        {
+            /* Stops the reader at its next block */
+            bq_close(&ready);
+            break;
+        }
+    }
+    pthread_join(reader_thread, NULL);
+    last_read_done_ms = reader.done_ms;
+    ok = ok && reader.ok;
+
+    /* 2n^3 flops, and each block streams the finished rows twice */
+    PROF_WORK(PHASE_ELIMINATION, 2.0 * n * n * n, 16.0 * n * n * nblocks);
+
+    /* The threshold needs the norm of the whole input, so the pivots are judged once it is read */
+    double anorm = 0.0;
+    if (ok)
+    {
+        anorm = cond_norm1(n, n, mat, 0);
+        if (min_pivot <= DBL_EPSILON * anorm)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            ok = false;
+        }
+    }
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_EXTRACT);
+#pragma omp parallel for schedule(static)
+        for (int i = 0; i < n; i++)
+        {
+            memcpy(mat_inv[colperm[i]], &aug[i][n], n * sizeof(double));
+        }
+        PROF_END(PHASE_EXTRACT);
+
+        /* The inverse is at hand, so the 1-norm condition number is exact */
+        PROF_BEGIN(PHASE_CONDITION);
+        ok = cond_accept(anorm * cond_norm1(n, n, mat_inv, 0));
+        PROF_END(PHASE_CONDITION);
+    }
+
+    bq_destroy(&ready);
+    free(blocks);
+    free(colperm);
+    free(aug);
+    return ok;
+}
+
+bool benchmark_matrix_inversion_stream(int n, stream_source source, void *source_ctx, double mat[n][n], double mat_inv[n][n])
+{
+    double start = now_ms();
+    if (!invert_matrix_stream(n, source, source_ctx, mat, mat_inv))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double end = now_ms();
+
+    printf("Matrix inversion (Streaming) completed in %.3f ms for %dx%d matrix.\n", end - start, n, n);
+    cond_report(stdout);
+    printf("Streaming: input read in %.3f ms, %.3f ms of elimination after the last row, %d-row blocks, %d threads.\n",
+           last_read_done_ms - start, end - last_read_done_ms, STREAM_BLOCK_ROWS, omp_get_max_threads());
+    return true;
+}
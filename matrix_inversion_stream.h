@@ -0,0 +1,27 @@
+#ifndef MATRIX_INVERSION_STREAM_H
+#define MATRIX_INVERSION_STREAM_H
+#include <stdbool.h>
+
+/* Gauss-Jordan inversion that runs while the input is still being read.
+ *
+ * A reader thread pulls the rows from the source in blocks and hands each
+ * block over as soon as it is complete. The elimination pivots on columns
+ * instead of rows, so a row can be finished without looking at the rows
+ * after it: an arriving block is reduced against all the rows before it
+ * (left-looking, one product with the finished rows), factored on its own,
+ * and its pivot columns are then eliminated from the earlier rows. When
+ * the last block arrives, only its own share of the 2n^3 flops is left,
+ * and the time to an inverse approaches the larger of reading and
+ * computing instead of their sum.
+ */
+
+/* Fill rows row0 .. row0 + nrows - 1 of the n x n input, row-major, into rows. The rows are asked for in order. */
+typedef bool (*stream_source)(void *ctx, int n, int row0, int nrows, double *rows);
+
+/* Invert the matrix delivered by source into mat_inv. The input is left in mat. */
+bool invert_matrix_stream(int n, stream_source source, void *source_ctx, double mat[n][n], double mat_inv[n][n]);
+
+/* Time from the first row requested to the inverse, and how much of it came after the last row was read */
+bool benchmark_matrix_inversion_stream(int n, stream_source source, void *source_ctx, double mat[n][n], double mat_inv[n][n]);
+
+#endif
@@ -0,0 +1,364 @@
+/**
+ * @file matrix_inversion_structured.c
+ * @brief Levinson and Gohberg-Semencul inversion of Toeplitz matrices, FFT inversion of circulant ones
+ *
+ * With t(k) = T[k][0] for k >= 0 and T[0][-k] for k < 0, the forward and
+ * backward solutions of the leading m x m submatrix, T_m·f = e_1 and
+ * T_m·b = e_m, grow by
+ *
+ *   ef = sum_i t(m - i)·f_i,   eb = sum_i t(-1 - i)·b_i
+ *   f' = ([f; 0] - ef·[0; b]) / (1 - ef·eb)
+ *   b' = ([0; b] - eb·[f; 0]) / (1 - ef·eb)
+ *
+ * since T_(m+1)·[f; 0] = e_1 + ef·e_(m+1) and T_(m+1)·[0; b] = eb·e_1 + e_(m+1).
+ * A denominator near zero means a nearly singular leading submatrix, where
+ * the recursion loses its accuracy even if T itself is well conditioned.
+ * */
+
+#include "matrix_inversion_structured.h"
+#include "matrix_inversion_parallel.h"
+#include "helpers/fft.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
+#include <omp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h> /* strcasecmp */
+#include <math.h>
+#include <float.h>
+
+/* Levinson denominators below this mean more than half the digits are lost */
+#define LEVINSON_MIN_DENOM 1.5e-8
+
+/* The inverse is filled in bands of TOEPLITZ_ROWS rows, TOEPLITZ_DIAGS diagonals (2 KB of each row) per task */
+#define TOEPLITZ_ROWS 64
+#define TOEPLITZ_DIAGS 256
+
+static const char *structure_names[STRUCTURE_COUNT] = {
+    [STRUCTURE_AUTO] = "auto",
+    [STRUCTURE_GENERAL] = "general",
+    [STRUCTURE_TOEPLITZ] = "toeplitz",
+    [STRUCTURE_CIRCULANT] = "circulant",
+};
+
+static enum matrix_structure structure_hint = STRUCTURE_AUTO;
+
+/* Structure the last inversion used, for benchmark_matrix_inversion_structured */
+static enum matrix_structure last_structure = STRUCTURE_GENERAL;
+
+bool parse_matrix_structure(const char *name, enum matrix_structure *structure)
+{
+    for (int s = 0; s < STRUCTURE_COUNT; s++)
+    {
+        if (strcasecmp(name, structure_names[s]) == 0)
+        {
+            *structure = (enum matrix_structure)s;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *matrix_structure_name(enum matrix_structure structure)
+{
+    return (structure >= 0 && structure < STRUCTURE_COUNT) ? structure_names[structure] : "unknown";
+}
+
+void structured_set_hint(enum matrix_structure hint)
+{
+    structure_hint = hint;
+}
+
+enum matrix_structure detect_structure(int n, const double mat[n][n])
+{
+    bool toeplitz = true;
+#pragma omp parallel for schedule(static) reduction(&& : toeplitz)
+    for (int i = 1; i < n; i++)
+    {
+        for (int j = 1; j < n && toeplitz; j++)
+        {
+            toeplitz = mat[i][j] == mat[i - 1][j - 1];
+        }
+    }
+    if (!toeplitz)
+    {
+        return STRUCTURE_GENERAL;
+    }
+
+    /* Each column wraps around: the first column is the first row turned backwards */
+    for (int i = 1; i < n; i++)
+    {
+        if (mat[i][0] != mat[0][n - i])
+        {
+            return STRUCTURE_TOEPLITZ;
+        }
+    }
+    return STRUCTURE_CIRCULANT;
+}
+
+/* T·x = e_1 and T·z = e_n, false if a denominator gets too small */
+static bool levinson(int n, const double col[n], const double row[n], double x[n], double z[n])
+{
+    if (col[0] == 0.0)
+    {
+        return false;
+    }
+    x[0] = z[0] = 1.0 / col[0];
+    for (int m = 1; m < n; m++)
+    {
+        double ef = 0.0, eb = 0.0;
+        for (int i = 0; i < m; i++)
+        {
+            ef += col[m - i] * x[i];
+            eb += row[i + 1] * z[i];
+        }
+        double denom = 1.0 - ef * eb;
+        if (fabs(denom) < LEVINSON_MIN_DENOM)
+        {
+            return false;
+        }
+
+        /* New x[i] and z[i] both come from the old x[i] and z[i - 1], so downwards in place */
+        double scale = 1.0 / denom;
+        for (int i = m; i >= 0; i--)
+        {
+            double xi = i < m ? x[i] : 0.0;
+            double zp = i > 0 ? z[i - 1] : 0.0;
+            x[i] = (xi - ef * zp) * scale;
+            z[i] = (zp - eb * xi) * scale;
+        }
+    }
+    return true;
+}
+
+/* The inverse from its first and last columns. Each entry needs the one before it on its diagonal d = j - i, so
+ * within a band of rows the diagonals are independent, and a band only needs the last row of the one above. */
+static void gohberg_semencul_fill(int n, const double x[n], const double z[n], double mat_inv[n][n])
+{
+    double x0 = x[0];
+#pragma omp parallel
+    for (int i0 = 0; i0 < n; i0 += TOEPLITZ_ROWS)
+    {
+        int i1 = i0 + TOEPLITZ_ROWS < n ? i0 + TOEPLITZ_ROWS : n;
+#pragma omp for schedule(static)
+        for (int d0 = -(i1 - 1); d0 < n - i0; d0 += TOEPLITZ_DIAGS)
+        {
+            int d1 = d0 + TOEPLITZ_DIAGS;
+            for (int i = i0; i < i1; i++)
+            {
+                int dlo = d0 > -i ? d0 : -i;
+                int dhi = d1 < n - i ? d1 : n - i;
+                for (int d = dlo; d < dhi; d++)
+                {
+                    int j = i + d;
+                    if (i == 0)
+                    {
+                        mat_inv[0][j] = z[n - 1 - j];
+                    }
+                    else if (j == 0)
+                    {
+                        mat_inv[i][0] = x[i];
+                    }
+                    else
+                    {
+                        mat_inv[i][j] = mat_inv[i - 1][j - 1] + (x[i] * z[n - 1 - j] - z[i - 1] * x[n - j]) / x0;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool invert_toeplitz(int n, const double col[n], const double row[n], double mat_inv[n][n])
+{
+    double *x = malloc(2 * (size_t)n * sizeof(double));
+    if (!x)
+    {
+        perror("malloc (Levinson vectors)");
+        return false;
+    }
+    double *z = x + n;
+
+    PROF_BEGIN(PHASE_ELIMINATION);
+    bool ok = levinson(n, col, row, x, z);
+    PROF_END(PHASE_ELIMINATION);
+    PROF_WORK(PHASE_ELIMINATION, 8.0 * n * n, 8.0 * 4 * n * n);
+
+    if (ok)
+    {
+        PROF_BEGIN(PHASE_EXTRACT);
+        gohberg_semencul_fill(n, x, z, mat_inv);
+        PROF_END(PHASE_EXTRACT);
+        PROF_WORK(PHASE_EXTRACT, 4.0 * n * n, 16.0 * n * n);
+    }
+    free(x);
+    return ok;
+}
+
+bool invert_circulant(int n, const double col[n], double inv_col[n])
+{
+    double complex *lambda = malloc(n * sizeof(double complex));
+    if (!lambda)
+    {
+        perror("malloc (circulant eigenvalues)");
+        return false;
+    }
+
+    double norm = 0.0;
+    for (int i = 0; i < n; i++)
+    {
+        lambda[i] = col[i];
+        norm += fabs(col[i]);
+    }
+
+    /* The eigenvalues, singular if one is at the pivot tolerance of the other engines */
+    PROF_BEGIN(PHASE_ELIMINATION);
+    bool ok = fft(n, lambda, false);
+    for (int k = 0; ok && k < n; k++)
+    {
+        if (cabs(lambda[k]) <= DBL_EPSILON * norm)
+        {
+            printf("Matrix is singular or nearly singular.\n");
+            ok = false;
+        }
+        lambda[k] = 1.0 / lambda[k];
+    }
+    ok = ok && fft(n, lambda, true);
+    PROF_END(PHASE_ELIMINATION);
+
+    if (ok)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            inv_col[i] = creal(lambda[i]);
+        }
+    }
+    free(lambda);
+    return ok;
+}
+
+void expand_circulant(int n, const double col[n], double mat[n][n])
+{
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < n; i++)
+    {
+        /* Row i is col[i], col[i - 1], ..., col[0], col[n - 1], ..., col[i + 1] */
+        for (int j = 0; j <= i; j++)
+        {
+            mat[i][j] = col[i - j];
+        }
+        for (int j = i + 1; j < n; j++)
+        {
+            mat[i][j] = col[n + i - j];
+        }
+    }
+}
+
+/* 1-norm of the Toeplitz matrix in O(n): column j sums |t(k)| for k = -j .. n - 1 - j, a window of prefix sums */
+static double toeplitz_norm1(int n, const double col[n], const double row[n])
+{
+    /* prefix[k + n - 1] = sum of |t(l)| for -(n - 1) <= l < k, over k = -(n - 1) .. n */
+    double *prefix = malloc(2 * (size_t)n * sizeof(double));
+    if (!prefix)
+    {
+        return INFINITY;
+    }
+    prefix[0] = 0.0;
+    for (int k = -(n - 1); k < n; k++)
+    {
+        prefix[k + n] = prefix[k + n - 1] + fabs(k >= 0 ? col[k] : row[-k]);
+    }
+    double norm = 0.0;
+    for (int j = 0; j < n; j++)
+    {
+        norm = fmax(norm, prefix[2 * n - 1 - j] - prefix[n - 1 - j]);
+    }
+    free(prefix);
+    return norm;
+}
+
+bool invert_matrix_structured(int n, double mat[n][n], double mat_inv[n][n])
+{
+    enum matrix_structure structure = structure_hint;
+    if (structure == STRUCTURE_AUTO)
+    {
+        PROF_BEGIN(PHASE_PARTITION);
+        structure = detect_structure(n, mat);
+        PROF_END(PHASE_PARTITION);
+    }
+
+    double *col = malloc(2 * (size_t)n * sizeof(double));
+    if (!col)
+    {
+        perror("malloc (first column)");
+        return false;
+    }
+    double *inv_col = col + n;
+    for (int i = 0; i < n; i++)
+    {
+        col[i] = mat[i][0];
+    }
+
+    bool ok = false;
+    if (structure == STRUCTURE_CIRCULANT)
+    {
+        ok = invert_circulant(n, col, inv_col);
+        if (ok)
+        {
+            PROF_BEGIN(PHASE_EXTRACT);
+            expand_circulant(n, inv_col, mat_inv);
+            PROF_END(PHASE_EXTRACT);
+
+            /* Every column of a circulant holds the same entries, so both 1-norms are exact in O(n) */
+            double anorm = 0.0, inorm = 0.0;
+            for (int i = 0; i < n; i++)
+            {
+                anorm += fabs(col[i]);
+                inorm += fabs(inv_col[i]);
+            }
+            ok = cond_accept(anorm * inorm);
+        }
+    }
+    else if (structure == STRUCTURE_TOEPLITZ)
+    {
+        ok = invert_toeplitz(n, col, mat[0], mat_inv);
+        if (ok)
+        {
+            PROF_BEGIN(PHASE_CONDITION);
+            ok = cond_accept(toeplitz_norm1(n, col, mat[0]) * cond_norm1(n, n, mat_inv, 0));
+            PROF_END(PHASE_CONDITION);
+        }
+        else
+        {
+            printf("Toeplitz: a leading submatrix is nearly singular, falling back to the OpenMP engine.\n");
+            structure = STRUCTURE_GENERAL;
+        }
+    }
+
+    if (structure == STRUCTURE_GENERAL)
+    {
+        ok = invert_matrix_par(n, n, mat, mat_inv);
+    }
+    last_structure = structure;
+    free(col);
+    return ok;
+}
+
+bool benchmark_matrix_inversion_structured(int n, double mat[n][n], double mat_inv[n][n])
+{
+    double start = now_ms();
+    if (!invert_matrix_structured(n, mat, mat_inv))
+    {
+        printf("Matrix inversion failed during benchmarking.\n");
+        return false;
+    }
+    double elapsed_time = now_ms() - start;
+
+    printf("Matrix inversion (Structured) completed in %.3f ms for %dx%d matrix.\n", elapsed_time, n, n);
+    cond_report(stdout);
+    printf("Structured: %s matrix (%s), %d threads.\n", matrix_structure_name(last_structure),
+           structure_hint == STRUCTURE_AUTO ? "detected" : "as hinted", omp_get_max_threads());
+    return true;
+}
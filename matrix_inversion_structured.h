@@ -0,0 +1,61 @@
+#ifndef MATRIX_INVERSION_STRUCTURED_H
+#define MATRIX_INVERSION_STRUCTURED_H
+#include <stdbool.h>
+
+/* O(n^2) inversion of Toeplitz and O(n log n) inversion of circulant matrices.
+ *
+ * A Toeplitz matrix is constant along its diagonals, T[i][j] = t(i - j).
+ * The Levinson recursion solves T·x = e_1 and T·z = e_n in O(n^2) by
+ * growing both solutions one leading submatrix at a time. T^-1 is
+ * persymmetric, so its first row is z reversed and its last row x
+ * reversed, and the Gohberg-Semencul relation
+ *
+ *   T^-1[i][j] = T^-1[i-1][j-1] + (x[i]·z[n-1-j] - z[i-1]·x[n-j]) / x[0]
+ *
+ * fills the rest along the diagonals. The recursion needs every leading
+ * submatrix to be well away from singular: when one is not, the inversion
+ * falls back to the OpenMP engine.
+ *
+ * A circulant matrix C[i][j] = c((i - j) mod n) is diagonalized by the
+ * discrete Fourier transform: its eigenvalues are the transform of c, and
+ * C^-1 is the circulant whose first column is the inverse transform of
+ * their reciprocals. Only that column is computed, expanding it to the
+ * dense inverse is a separate O(n^2) copy.
+ */
+enum matrix_structure
+{
+    STRUCTURE_AUTO,      /* Detect it */
+    STRUCTURE_GENERAL,
+    STRUCTURE_TOEPLITZ,
+    STRUCTURE_CIRCULANT,
+    STRUCTURE_COUNT
+};
+
+/* Parse "auto", "general", "toeplitz" or "circulant", returns false for anything else */
+bool parse_matrix_structure(const char *name, enum matrix_structure *structure);
+
+const char *matrix_structure_name(enum matrix_structure structure);
+
+/* Structure assumed by invert_matrix_structured: STRUCTURE_AUTO (the default) checks every entry, the others
+ * are trusted and only the first row and column of the matrix are read */
+void structured_set_hint(enum matrix_structure hint);
+
+/* Exact comparison of the diagonals, O(n^2): circulant, Toeplitz or general */
+enum matrix_structure detect_structure(int n, const double mat[n][n]);
+
+/* Inverse of the Toeplitz matrix with first column col and first row row (row[0] == col[0]). Returns false
+ * without printing if the Levinson recursion breaks down, so the caller can use another engine. */
+bool invert_toeplitz(int n, const double col[n], const double row[n], double mat_inv[n][n]);
+
+/* First column of the inverse of the circulant matrix with first column col, false if it is singular */
+bool invert_circulant(int n, const double col[n], double inv_col[n]);
+
+/* The dense circulant matrix with first column col */
+void expand_circulant(int n, const double col[n], double mat[n][n]);
+
+/* Invert the n x n matrix mat into mat_inv by its structure, mat is left unchanged */
+bool invert_matrix_structured(int n, double mat[n][n], double mat_inv[n][n]);
+
+bool benchmark_matrix_inversion_structured(int n, double mat[n][n], double mat_inv[n][n]);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef MATRIX_INVERSION_TILED_H
+#define MATRIX_INVERSION_TILED_H
+#include <stdbool.h>
+
+/* Blocked in-place Gauss-Jordan inversion on a tile-major copy of the matrix.
+ *
+ * The matrix is converted to b x b tiles (see helpers/tile_layout.h) and
+ * inverted in place, one column of tiles per step: the panel of column K
+ * is reduced with partial pivoting, then every other tile (I, J) receives
+ * tile (I, K) times tile (K, J) and the tiles of row K are multiplied by
+ * the inverted pivot tile. Almost all of the work is in those tile
+ * products, which run unit-stride in cache, and only the n x n matrix is
+ * stored instead of the n x 2n augmented one. The row exchanges turn into
+ * a column permutation, applied when the inverse is copied back.
+ */
+
+/* Rows and columns of the tiles used for an n x n matrix */
+int tiled_tile_size(int n);
+
+/* Invert the n x n matrix mat into mat_inv, mat is left unchanged */
+bool invert_matrix_tiled(int n, double mat[n][n], double mat_inv[n][n]);
+
+bool benchmark_matrix_inversion_tiled(int n, double mat[n][n], double mat_inv[n][n]);
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ * @file matrix_inversion_typed.c
+ * @brief Float, double and complex double instances of the type-generic inversion
+ */
+
+#include "matrix_inversion_typed.h"
+#include "matrix_inversion.h"
+#include "matrix_inversion_parallel.h"
+#include "helpers/timer.h"
+#include "helpers/profiler.h"
+#include "helpers/condition.h"
+#include "helpers/placement.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Below this many candidate rows the pivot search is not worth a parallel region */
+#define PIVOT_SEARCH_PAR_MIN 512
+
+#define SCALAR_KIND SCALAR_KIND_FLOAT
+#include "matrix_inversion_generic.h"
+#undef SCALAR_KIND
+
+#define SCALAR_KIND SCALAR_KIND_DOUBLE
+#include "matrix_inversion_generic.h"
+#undef SCALAR_KIND
+
+#define SCALAR_KIND SCALAR_KIND_COMPLEX
+#include "matrix_inversion_generic.h"
+#undef SCALAR_KIND
+
+bool invert_matrix_typed(enum scalar_type type, bool parallel, int n, void *mat, void *mat_inv)
+{
+    switch (type)
+    {
+    case SCALAR_FLOAT:
+        return parallel ? invert_matrix_par_f(n, mat, mat_inv) : invert_matrix_f(n, mat, mat_inv);
+    case SCALAR_COMPLEX:
+        return parallel ? invert_matrix_par_z(n, mat, mat_inv) : invert_matrix_z(n, mat, mat_inv);
+    default:
+        return parallel ? invert_matrix_par(n, n, mat, mat_inv) : invert_matrix(n, n, mat, mat_inv);
+    }
+}
+
+bool benchmark_matrix_inversion_typed(enum scalar_type type, bool parallel, int n, void *mat, void *mat_inv)
+{
+    switch (type)
+    {
+    case SCALAR_FLOAT:
+        return parallel ? benchmark_matrix_inversion_parallel_f(n, mat, mat_inv) : benchmark_matrix_inversion_f(n, mat, mat_inv);
+    case SCALAR_COMPLEX:
+        return parallel ? benchmark_matrix_inversion_parallel_z(n, mat, mat_inv) : benchmark_matrix_inversion_z(n, mat, mat_inv);
+    default:
+        return parallel ? benchmark_matrix_inversion_parallel(n, n, mat, mat_inv) : benchmark_matrix_inversion(n, n, mat, mat_inv);
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef MATRIX_INVERSION_TYPED_H
+#define MATRIX_INVERSION_TYPED_H
+
+#include <complex.h>
+#include <stdbool.h>
+
+#include "helpers/scalar.h"
+#include "inversion_workspace.h"
+
+/* Gauss-Jordan inversion in single precision (suffix _f), double (suffix _d)
+ * and complex double (suffix _z), generated from matrix_inversion_generic.h.
+ * The _par variants use OpenMP. The benchmark wrappers print the same
+ * timing line as the double engines, which wrap the _d functions.
+ */
+#define DECLARE_TYPED_INVERSION(suffix, T)                                                  \
+    bool invert_matrix_##suffix(int n, T mat[n][n], T mat_inv[n][n]);                       \
+    bool invert_matrix_par_##suffix(int n, T mat[n][n], T mat_inv[n][n]);                   \
+    bool benchmark_matrix_inversion_##suffix(int n, T mat[n][n], T mat_inv[n][n]);          \
+    bool benchmark_matrix_inversion_parallel_##suffix(int n, T mat[n][n], T mat_inv[n][n]);
+
+DECLARE_TYPED_INVERSION(f, float)
+DECLARE_TYPED_INVERSION(d, double)
+DECLARE_TYPED_INVERSION(z, double complex)
+
+/* Double inversion through the caller's workspace, with OpenMP if parallel. Behind invert_matrix_ws and
+ * invert_matrix_par_ws. */
+bool invert_matrix_ws_d(int n, double mat[n][n], struct inversion_workspace *ws, bool parallel, double mat_inv[n][n]);
+
+/* Dispatch on the element type, mat and mat_inv are n x n arrays of that
+ * type. SCALAR_DOUBLE goes to the double engines (matrix_inversion.h and
+ * matrix_inversion_parallel.h).
+ */
+bool invert_matrix_typed(enum scalar_type type, bool parallel, int n, void *mat, void *mat_inv);
+bool benchmark_matrix_inversion_typed(enum scalar_type type, bool parallel, int n, void *mat, void *mat_inv);
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * @file mpi_comm_profiler.c
+ * @brief Per-rank, per-collective communication profile of the MPI engine
+ *
+ * Each rank keeps call counts, bytes and times per call site. At the end
+ * the records are reduced over the communicator and rank 0 prints the
+ * min/avg/max time per site, the effective bandwidth and the compute load
+ * imbalance between ranks.
+ */
+
+#include "mpi_comm_profiler.h"
+#include "helpers/timer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct site_record
+{
+    double calls;
+    double bytes;
+    double ms;      /* Total time in the call, including the wait */
+    double wait_ms; /* Time in the synchronizing barrier (sync mode only) */
+};
+
+static const char *site_names[COMM_SITE_COUNT] = {
+    [COMM_MATRIX_BCAST] = "matrix bcast",
+    [COMM_PIVOT_BCAST] = "pivot bcast",
+    [COMM_NODE_SYNC] = "node sync",
+    [COMM_SCALAR_BCAST] = "scalar bcast",
+    [COMM_SINGULAR_REDUCE] = "singular reduce",
+    [COMM_INVERSE_GATHER] = "inverse gather",
+};
+
+static bool comm_prof_on = false;
+static bool comm_prof_sync = false;
+static struct site_record records[COMM_SITE_COUNT];
+static double engine_ms = 0.0;
+static double engine_start = 0.0;
+
+void comm_prof_enable(bool sync)
+{
+    comm_prof_on = true;
+    comm_prof_sync = sync;
+}
+
+bool comm_prof_enabled(void)
+{
+    return comm_prof_on;
+}
+
+/* Start timing a call, in sync mode after waiting for every rank of comm */
+static double site_begin(struct site_record *rec, MPI_Comm comm)
+{
+    double start = now_ms();
+    if (comm_prof_sync)
+    {
+        MPI_Barrier(comm);
+        rec->wait_ms += now_ms() - start;
+    }
+    return start;
+}
+
+static void site_end(struct site_record *rec, double start, int count, MPI_Datatype type)
+{
+    int type_size;
+    MPI_Type_size(type, &type_size);
+    rec->ms += now_ms() - start;
+    rec->calls += 1;
+    rec->bytes += (double)count * type_size;
+}
+
+int comm_prof_bcast(enum comm_site site, void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm)
+{
+    if (!comm_prof_on)
+    {
+        return MPI_Bcast(buf, count, type, root, comm);
+    }
+
+    double start = site_begin(&records[site], comm);
+    int err = MPI_Bcast(buf, count, type, root, comm);
+    site_end(&records[site], start, count, type);
+    return err;
+}
+
+int comm_prof_barrier(enum comm_site site, MPI_Comm comm)
+{
+    if (!comm_prof_on)
+    {
+        return MPI_Barrier(comm);
+    }
+
+    /* The barrier is nothing but the wait for the other ranks */
+    struct site_record *rec = &records[site];
+    double start = now_ms();
+    int err = MPI_Barrier(comm);
+    double ms = now_ms() - start;
+    rec->ms += ms;
+    rec->wait_ms += ms;
+    rec->calls += 1;
+    return err;
+}
+
+int comm_prof_allreduce(enum comm_site site, const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op,
+                        MPI_Comm comm)
+{
+    if (!comm_prof_on)
+    {
+        return MPI_Allreduce(sendbuf, recvbuf, count, type, op, comm);
+    }
+
+    double start = site_begin(&records[site], comm);
+    int err = MPI_Allreduce(sendbuf, recvbuf, count, type, op, comm);
+    site_end(&records[site], start, count, type);
+    return err;
+}
+
+int comm_prof_gatherv(enum comm_site site, const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf,
+                      const int recvcounts[], const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+    if (!comm_prof_on)
+    {
+        return MPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    }
+
+    /* Bytes are what this rank contributes */
+    double start = site_begin(&records[site], comm);
+    int err = MPI_Gatherv(sendbuf, sendcount, sendtype, recvbuf, recvcounts, displs, recvtype, root, comm);
+    site_end(&records[site], start, sendcount, sendtype);
+    return err;
+}
+
+void comm_prof_engine_begin(void)
+{
+    if (comm_prof_on)
+    {
+        engine_start = now_ms();
+    }
+}
+
+void comm_prof_engine_end(void)
+{
+    if (comm_prof_on)
+    {
+        engine_ms += now_ms() - engine_start;
+    }
+}
+
+/* Reduce one value to min, sum and max on rank 0 of comm */
+static void reduce_stats(double value, double *min, double *sum, double *max, MPI_Comm comm)
+{
+    MPI_Reduce(&value, min, 1, MPI_DOUBLE, MPI_MIN, 0, comm);
+    MPI_Reduce(&value, sum, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+    MPI_Reduce(&value, max, 1, MPI_DOUBLE, MPI_MAX, 0, comm);
+}
+
+void comm_prof_report(MPI_Comm comm)
+{
+    if (!comm_prof_on)
+    {
+        return;
+    }
+
+    int rank, size;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+
+    if (rank == 0)
+    {
+        printf("\n********** MPI communication profile (%d ranks%s) **********\n", size, comm_prof_sync ? ", synchronized" : "");
+        printf("%-16s %10s %14s %30s %12s %14s\n", "site", "calls/rank", "MB/rank", "time min/avg/max (ms)", "wait avg", "bandwidth");
+    }
+
+    double comm_ms = 0.0;
+    for (int s = 0; s < COMM_SITE_COUNT; s++)
+    {
+        struct site_record *rec = &records[s];
+        double calls, bytes, tmin, tsum, tmax, wmin, wsum, wmax;
+        comm_ms += rec->ms;
+
+        MPI_Reduce(&rec->calls, &calls, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+        MPI_Reduce(&rec->bytes, &bytes, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+        reduce_stats(rec->ms, &tmin, &tsum, &tmax, comm);
+        reduce_stats(rec->wait_ms, &wmin, &wsum, &wmax, comm);
+
+        if (rank == 0 && calls > 0)
+        {
+            double tavg = tsum / size, wavg = wsum / size;
+            double transfer_ms = tavg - wavg;
+            double mbps = transfer_ms > 0.0 ? (bytes / size) / (transfer_ms * 1000.0) : 0.0;
+            printf("%-16s %10.0f %14.3f %10.3f/%9.3f/%9.3f %12.3f ", site_names[s], calls / size, bytes / size / 1e6, tmin,
+                   tavg, tmax, wavg);
+            if (bytes > 0.0)
+            {
+                printf("%9.1f MB/s\n", mbps);
+            }
+            else
+            {
+                printf("%14s\n", "-");
+            }
+        }
+    }
+
+    /* Compute is whatever the engine did outside the collectives */
+    double compute_ms = engine_ms - comm_ms;
+    double cmin, csum, cmax;
+    reduce_stats(compute_ms, &cmin, &csum, &cmax, comm);
+
+    double *per_rank = NULL;
+    if (rank == 0)
+    {
+        per_rank = malloc(2 * size * sizeof(double));
+    }
+    double mine[2] = {compute_ms, comm_ms};
+    MPI_Gather(mine, 2, MPI_DOUBLE, per_rank, 2, MPI_DOUBLE, 0, comm);
+
+    if (rank == 0)
+    {
+        double cavg = csum / size;
+        printf("%-16s %10s %14s %10.3f/%9.3f/%9.3f\n", "compute", "", "", cmin, cavg, cmax);
+        printf("Load imbalance (max/avg compute): %.3f\n", cavg > 0.0 ? cmax / cavg : 1.0);
+        for (int r = 0; r < size; r++)
+        {
+            printf("  rank %3d: compute %10.3f ms, communication %10.3f ms\n", r, per_rank[2 * r], per_rank[2 * r + 1]);
+        }
+        fflush(stdout);
+        free(per_rank);
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef MPI_COMM_PROFILER_H
+#define MPI_COMM_PROFILER_H
+
+#include <mpi.h>
+#include <stdbool.h>
+
+/* Communication call sites of the MPI engine that are profiled separately */
+enum comm_site
+{
+    COMM_MATRIX_BCAST,    /* Initial broadcast of the augmented matrix */
+    COMM_PIVOT_BCAST,     /* Per-step broadcast of the pivot row */
+    COMM_NODE_SYNC,       /* Barrier of the ranks sharing a node's window */
+    COMM_SCALAR_BCAST,    /* Broadcast of the input norm and of the verdict */
+    COMM_SINGULAR_REDUCE, /* Reduction of the singular pivot flags */
+    COMM_INVERSE_GATHER,  /* Gather of the inverse rows on rank 0 */
+    COMM_SITE_COUNT
+};
+
+/* Opt-in profiler for the MPI engine.
+ *
+ * The engine routes its collectives through the comm_prof_* wrappers, which
+ * count calls and bytes and time each call per rank. With sync, a barrier
+ * before each collective separates the time spent waiting for late ranks
+ * from the transfer itself (at the cost of the extra barrier). A barrier
+ * site is all wait, so it gets no extra barrier and reports no bandwidth.
+ * When disabled the wrappers call straight through to MPI.
+ */
+void comm_prof_enable(bool sync);
+bool comm_prof_enabled(void);
+
+int comm_prof_bcast(enum comm_site site, void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm);
+int comm_prof_barrier(enum comm_site site, MPI_Comm comm);
+int comm_prof_allreduce(enum comm_site site, const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op,
+                        MPI_Comm comm);
+int comm_prof_gatherv(enum comm_site site, const void *sendbuf, int sendcount, MPI_Datatype sendtype, void *recvbuf,
+                      const int recvcounts[], const int displs[], MPI_Datatype recvtype, int root, MPI_Comm comm);
+
+/* Bracket one engine call, everything inside that is not communication counts as compute */
+void comm_prof_engine_begin(void);
+void comm_prof_engine_end(void);
+
+/* Reduce the per-rank records over comm and print the report on its rank 0 */
+void comm_prof_report(MPI_Comm comm);
+
+#endif // MPI_COMM_PROFILER_H
@@ -0,0 +1,577 @@
+/*
+ * @file mpi_farm.c
+ * @brief Master-worker farm of MPI teams over a batch of matrices
+ *
+ * The master (world rank 0) sends a team leader the indices of its next
+ * share, the leader broadcasts them to its team, the team inverts them one
+ * after the other and the leader answers with one farm_result per matrix.
+ * That answer is also the request for more work; an empty share tells the
+ * team to stop.
+ */
+
+#include "mpi_farm.h"
+#include "matrix_inverse_mpi.h"
+#include "helpers/common.h"
+#include "helpers/file_reader.h"
+#include "helpers/batch_pipeline.h"
+#include "helpers/condition.h"
+
+#include <mpi.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define FARM_TAG_WORK 1
+#define FARM_TAG_RESULT 2
+#define FARM_TAG_TEAM 3
+
+/* Most matrices in one share, and the work (about 2n^3 flops per matrix) a share of small ones adds up to.
+ * Sized teams also get one rank per that much work of their matrix. */
+#define FARM_MAX_GROUP 64
+#define FARM_GROUP_FLOPS 2e8
+
+/* A matrix of the batch, as the master schedules it */
+struct farm_task
+{
+    int index; /* Into paths */
+    int n;
+};
+
+/* What a team leader reports about one matrix */
+struct farm_result
+{
+    int index;
+    int n;
+    bool inverted;               /* The engine succeeded */
+    bool ok;                     /* ... and so did the verification and the write-back */
+    double ms;                   /* Inversion only */
+    double busy_ms;              /* Reading, inverting, verifying and writing */
+    double cond;
+    struct verify_result verify; /* Mode VERIFY_NONE unless verified */
+};
+
+/* Largest first, in file order among equals */
+static int compare_tasks(const void *a, const void *b)
+{
+    const struct farm_task *x = a, *y = b;
+    if (x->n != y->n)
+    {
+        return x->n > y->n ? -1 : 1;
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+/* Invert one file on the ranks of team, the result is only complete on its rank 0 */
+static struct farm_result farm_invert(const char *path, int index, MPI_Comm team, const struct farm_config *cfg)
+{
+    int rank;
+    MPI_Comm_rank(team, &rank);
+    struct farm_result res = {index, 0, false, false, 0.0, 0.0, -1.0, {.mode = VERIFY_NONE}};
+    double start = MPI_Wtime();
+
+    /* Only the leader reads the file, the engine only reads the matrix on rank 0 */
+    int n = 0;
+    double **mat = NULL;
+    if (rank == 0)
+    {
+        int nrow, ncol;
+        if (!read_matrix_from_file(path, &nrow, &ncol, &mat))
+        {
+            fprintf(stderr, "Failed to read matrix from file %s\n", path);
+        }
+        else if (nrow != ncol)
+        {
+            fprintf(stderr, "Matrix in %s is not square (%dx%d).\n", path, nrow, ncol);
+            free_matrix(mat, nrow);
+        }
+        else
+        {
+            n = nrow;
+        }
+    }
+    MPI_Bcast(&n, 1, MPI_INT, 0, team);
+    res.n = n;
+    if (n == 0)
+    {
+        res.busy_ms = (MPI_Wtime() - start) * 1000.0;
+        return res;
+    }
+
+    double (*mat_inv)[n] = NULL;
+    double **inv_rows = NULL;
+    if (rank == 0)
+    {
+        mat_inv = malloc(sizeof(double[n][n]));
+        inv_rows = malloc(n * sizeof(double *));
+        if (!mat_inv || !inv_rows)
+        {
+            perror("malloc (inverse)");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+        for (int i = 0; i < n; i++)
+        {
+            inv_rows[i] = mat_inv[i];
+        }
+    }
+
+    double inv_start = MPI_Wtime();
+    res.inverted = inverse_matrix_mpi(mat, n, n, inv_rows);
+    res.ms = (MPI_Wtime() - inv_start) * 1000.0;
+
+    if (rank == 0)
+    {
+        bool ok = res.inverted;
+        if (ok)
+        {
+            res.cond = cond_last_recorded();
+        }
+        if (ok && cfg->verify != VERIFY_NONE)
+        {
+            double (*mat_cp)[n] = malloc(sizeof(double[n][n]));
+            if (!mat_cp)
+            {
+                perror("malloc (matrix copy)");
+                ok = false;
+            }
+            else
+            {
+                copy_matrix(n, n, mat, mat_cp);
+                ok = verify_inverse(cfg->verify, n, mat_cp, mat_inv, &res.verify);
+                free(mat_cp);
+            }
+        }
+        if (ok && cfg->out_dir)
+        {
+            ok = write_batch_inverse(cfg->out_dir, path, n, n, mat_inv);
+        }
+        res.ok = ok;
+        free(inv_rows);
+        free(mat_inv);
+        free_matrix(mat, n);
+    }
+    res.busy_ms = (MPI_Wtime() - start) * 1000.0;
+    return res;
+}
+
+/* Print what came back for one matrix, one call per report */
+static void farm_report(const struct farm_result *res, char **paths, int team, int ranks)
+{
+    const char *path = paths[res->index];
+    if (res->inverted)
+    {
+        printf("Matrix inversion (MPI farm) completed in %.3f ms for %dx%d matrix.\n"
+               "Condition number estimate (1-norm): %.3e\nTeam %d (%d rank%s) for %s\n",
+               res->ms, res->n, res->n, res->cond, team, ranks, ranks == 1 ? "" : "s", path);
+    }
+    if (res->verify.mode != VERIFY_NONE)
+    {
+        print_verify_result(stdout, "MPI farm", &res->verify);
+    }
+    if (!res->ok)
+    {
+        fprintf(stderr, "Farm: %s failed on team %d.\n", path, team);
+    }
+}
+
+/* The next share, largest matrices first: one matrix, or small ones up to FARM_GROUP_FLOPS of work. Guided
+ * self-scheduling caps it at half of what is left per team, so the last shares still spread over every team.
+ * msg[0] is the share size, 0 once the list is exhausted, then the file indices. */
+static int farm_next_share(const struct farm_task *tasks, int count, int *next, int teams, int msg[FARM_MAX_GROUP + 1])
+{
+    int left = count - *next;
+    int limit = (left + 2 * teams - 1) / (2 * teams);
+    limit = limit > FARM_MAX_GROUP ? FARM_MAX_GROUP : limit;
+
+    int k = 0;
+    double flops = 0.0;
+    while (*next < count && (k == 0 || (k < limit && flops < FARM_GROUP_FLOPS)))
+    {
+        double n = tasks[*next].n;
+        flops += 2.0 * n * n * n;
+        msg[1 + k++] = tasks[(*next)++].index;
+    }
+    msg[0] = k;
+    return k;
+}
+
+/* Ranks of team t: team_size, except for a smaller last team when team_size does not divide the workers */
+static int farm_team_ranks(int team, int team_size, int workers)
+{
+    int left = workers - team * team_size;
+    return left < team_size ? left : team_size;
+}
+
+/* The work list, largest first. Only the dimensions are needed to schedule, files whose dimensions cannot be
+ * had fail right away and are counted in *failures. */
+static struct farm_task *farm_tasks(char **paths, int count, int *queued, int *failures)
+{
+    struct farm_task *tasks = malloc((count > 0 ? count : 1) * sizeof(*tasks));
+    if (!tasks)
+    {
+        perror("malloc (farm)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    *queued = 0;
+    *failures = 0;
+    for (int i = 0; i < count; i++)
+    {
+        int nrow, ncol;
+        if (!read_matrix_dimensions(paths[i], &nrow, &ncol) || nrow != ncol || nrow < 1)
+        {
+            fprintf(stderr, "Farm: cannot invert %s.\n", paths[i]);
+            (*failures)++;
+            continue;
+        }
+        tasks[(*queued)++] = (struct farm_task){i, nrow};
+    }
+    qsort(tasks, *queued, sizeof(*tasks), compare_tasks);
+    return tasks;
+}
+
+/* Rank 0: schedule the batch over the teams and collect their results. Returns the number of failures. */
+static int farm_master(char **paths, int count, int teams, int team_size, int workers)
+{
+    int queued, failures;
+    struct farm_task *tasks = farm_tasks(paths, count, &queued, &failures);
+    struct farm_result *results = malloc(FARM_MAX_GROUP * sizeof(*results));
+    if (!results)
+    {
+        perror("malloc (farm)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    double start = MPI_Wtime(), busy_ms = 0.0;
+    int next = 0, msg[FARM_MAX_GROUP + 1];
+    int active = 0;
+    for (int t = 0; t < teams; t++)
+    {
+        active += farm_next_share(tasks, queued, &next, teams, msg) > 0;
+        MPI_Send(msg, 1 + msg[0], MPI_INT, 1 + t * team_size, FARM_TAG_WORK, MPI_COMM_WORLD);
+    }
+
+    while (active > 0)
+    {
+        MPI_Status status;
+        int bytes;
+        MPI_Recv(results, FARM_MAX_GROUP * sizeof(*results), MPI_BYTE, MPI_ANY_SOURCE, FARM_TAG_RESULT, MPI_COMM_WORLD,
+                 &status);
+        MPI_Get_count(&status, MPI_BYTE, &bytes);
+
+        /* Hand out the next share first, the team should not wait for the printing */
+        int leader = status.MPI_SOURCE, team = (leader - 1) / team_size;
+        active -= farm_next_share(tasks, queued, &next, teams, msg) == 0;
+        MPI_Send(msg, 1 + msg[0], MPI_INT, leader, FARM_TAG_WORK, MPI_COMM_WORLD);
+
+        int ranks = farm_team_ranks(team, team_size, workers);
+        for (int r = 0; r < bytes / (int)sizeof(*results); r++)
+        {
+            farm_report(&results[r], paths, team, ranks);
+            failures += !results[r].ok;
+            busy_ms += results[r].busy_ms * ranks;
+        }
+    }
+
+    /* Busy time is weighed by the ranks of each team, so a smaller last team counts for less */
+    double elapsed_ms = (MPI_Wtime() - start) * 1000.0;
+    int last = farm_team_ranks(teams - 1, team_size, workers);
+    char layout[64];
+    int full = last == team_size ? teams : teams - 1;
+    int len = snprintf(layout, sizeof(layout), "%d team%s of %d rank%s", full, full == 1 ? "" : "s", team_size,
+                       team_size == 1 ? "" : "s");
+    if (last != team_size)
+    {
+        snprintf(layout + len, sizeof(layout) - len, " and 1 of %d rank%s", last, last == 1 ? "" : "s");
+    }
+    printf("MPI farm: %d matrices on %s in %.3f ms (%.1f matrices/s), ranks busy %.1f%% of the time, %d failed.\n",
+           count, layout, elapsed_ms, elapsed_ms > 0.0 ? 1000.0 * count / elapsed_ms : 0.0,
+           elapsed_ms > 0.0 ? 100.0 * busy_ms / (workers * elapsed_ms) : 0.0, failures);
+    free(results);
+    free(tasks);
+    return failures;
+}
+
+/* Worker ranks of a farm whose teams are sized per share, as the master sees them */
+struct farm_pool
+{
+    int workers;
+    int *idle;       /* World ranks of the idle workers, the lowest last */
+    int idle_count;
+    int *leader_of;  /* Per world rank, the leader of its current team */
+    int *team_ranks; /* Per leader, the ranks of its team */
+    int largest;     /* Largest team so far */
+};
+
+/* Highest first, so the lowest idle ranks are taken first and a team stays on as few nodes as it can */
+static int compare_ranks_desc(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x < y) - (x > y);
+}
+
+/* Ranks for a share: one for several small matrices. A single matrix gets one rank per FARM_GROUP_FLOPS of its
+ * work, but no more than its part of the workers over the matrices still queued (as long as there are more
+ * matrices than ranks, they are better off side by side) and than are idle right now. */
+static int farm_share_ranks(const struct farm_task *task, int k, int queued_before, const struct farm_pool *pool)
+{
+    if (k != 1)
+    {
+        return 1;
+    }
+    double n = task->n;
+    double ranks = 2.0 * n * n * n / FARM_GROUP_FLOPS;
+    int fair = pool->workers / queued_before;
+    ranks = ranks < fair ? ranks : fair;
+    ranks = ranks < pool->idle_count ? ranks : pool->idle_count;
+    return ranks < 1.0 ? 1 : (int)ranks;
+}
+
+/* Hand out shares as long as there are matrices and idle ranks. A worker gets the indices of the share and the
+ * world ranks of its team, msg[0] is the share size, msg[1 + k] the team size. Returns the shares sent. */
+static int farm_dispatch(const struct farm_task *tasks, int queued, int *next, struct farm_pool *pool, int *msg)
+{
+    int sent = 0;
+    while (*next < queued && pool->idle_count > 0)
+    {
+        int queued_before = queued - *next;
+        int k = farm_next_share(tasks, queued, next, pool->workers, msg);
+        int m = farm_share_ranks(&tasks[*next - 1], k, queued_before, pool);
+
+        int *members = msg + 2 + k;
+        msg[1 + k] = m;
+        for (int r = 0; r < m; r++)
+        {
+            members[r] = pool->idle[--pool->idle_count];
+        }
+        for (int r = 0; r < m; r++)
+        {
+            pool->leader_of[members[r]] = members[0];
+            MPI_Send(msg, 2 + k + m, MPI_INT, members[r], FARM_TAG_WORK, MPI_COMM_WORLD);
+        }
+        pool->team_ranks[members[0]] = m;
+        pool->largest = m > pool->largest ? m : pool->largest;
+        sent++;
+    }
+    return sent;
+}
+
+/* Rank 0 when teams are sized per share: every worker waits on its own, the ranks of a team come back to the
+ * pool once its leader reports. Returns the number of failures. */
+static int farm_sized_master(char **paths, int count, int workers)
+{
+    int queued, failures;
+    struct farm_task *tasks = farm_tasks(paths, count, &queued, &failures);
+    struct farm_result *results = malloc(FARM_MAX_GROUP * sizeof(*results));
+    int *msg = malloc((FARM_MAX_GROUP + 2 + workers) * sizeof(int));
+    struct farm_pool pool = {workers, malloc(workers * sizeof(int)), workers, calloc(workers + 1, sizeof(int)),
+                             calloc(workers + 1, sizeof(int)), 1};
+    if (!results || !msg || !pool.idle || !pool.leader_of || !pool.team_ranks)
+    {
+        perror("malloc (farm)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int r = 0; r < workers; r++)
+    {
+        pool.idle[r] = workers - r;
+    }
+
+    double start = MPI_Wtime(), busy_ms = 0.0;
+    int next = 0;
+    int active = farm_dispatch(tasks, queued, &next, &pool, msg);
+
+    while (active > 0)
+    {
+        MPI_Status status;
+        int bytes;
+        MPI_Recv(results, FARM_MAX_GROUP * sizeof(*results), MPI_BYTE, MPI_ANY_SOURCE, FARM_TAG_RESULT, MPI_COMM_WORLD,
+                 &status);
+        MPI_Get_count(&status, MPI_BYTE, &bytes);
+
+        /* The team's ranks are idle again, hand out the next shares before printing */
+        int leader = status.MPI_SOURCE, ranks = pool.team_ranks[leader];
+        for (int r = 1; r <= workers; r++)
+        {
+            if (pool.leader_of[r] == leader)
+            {
+                pool.leader_of[r] = 0;
+                pool.idle[pool.idle_count++] = r;
+            }
+        }
+        qsort(pool.idle, pool.idle_count, sizeof(int), compare_ranks_desc);
+        active += farm_dispatch(tasks, queued, &next, &pool, msg) - 1;
+
+        for (int r = 0; r < bytes / (int)sizeof(*results); r++)
+        {
+            farm_report(&results[r], paths, leader - 1, ranks);
+            failures += !results[r].ok;
+            busy_ms += results[r].busy_ms * ranks;
+        }
+    }
+
+    msg[0] = 0;
+    for (int r = 1; r <= workers; r++)
+    {
+        MPI_Send(msg, 1, MPI_INT, r, FARM_TAG_WORK, MPI_COMM_WORLD);
+    }
+
+    double elapsed_ms = (MPI_Wtime() - start) * 1000.0;
+    printf("MPI farm: %d matrices on %d ranks in teams sized per matrix (largest %d) in %.3f ms (%.1f matrices/s), "
+           "ranks busy %.1f%% of the time, %d failed.\n",
+           count, workers, pool.largest, elapsed_ms, elapsed_ms > 0.0 ? 1000.0 * count / elapsed_ms : 0.0,
+           elapsed_ms > 0.0 ? 100.0 * busy_ms / (workers * elapsed_ms) : 0.0, failures);
+    free(pool.team_ranks);
+    free(pool.leader_of);
+    free(pool.idle);
+    free(msg);
+    free(results);
+    free(tasks);
+    return failures;
+}
+
+/* Worker ranks: invert the shares the master sends the team until it sends an empty one */
+static void farm_worker(char **paths, MPI_Comm team, const struct farm_config *cfg)
+{
+    int rank;
+    MPI_Comm_rank(team, &rank);
+    int msg[FARM_MAX_GROUP + 1];
+    struct farm_result results[FARM_MAX_GROUP];
+
+    for (;;)
+    {
+        if (rank == 0)
+        {
+            MPI_Recv(msg, FARM_MAX_GROUP + 1, MPI_INT, 0, FARM_TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        }
+        MPI_Bcast(msg, FARM_MAX_GROUP + 1, MPI_INT, 0, team);
+        if (msg[0] == 0)
+        {
+            break;
+        }
+
+        for (int k = 0; k < msg[0]; k++)
+        {
+            results[k] = farm_invert(paths[msg[1 + k]], msg[1 + k], team, cfg);
+        }
+        if (rank == 0)
+        {
+            MPI_Send(results, msg[0] * sizeof(*results), MPI_BYTE, 0, FARM_TAG_RESULT, MPI_COMM_WORLD);
+        }
+    }
+}
+
+/* Worker ranks when teams are sized per share: one rank runs the engine on MPI_COMM_SELF, a larger team gets
+ * a communicator of its own from the ranks the master names, created by them alone */
+static void farm_sized_worker(char **paths, int workers, const struct farm_config *cfg)
+{
+    int *msg = malloc((FARM_MAX_GROUP + 2 + workers) * sizeof(int));
+    struct farm_result results[FARM_MAX_GROUP];
+    if (!msg)
+    {
+        perror("malloc (farm)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    MPI_Group world;
+    MPI_Comm_group(MPI_COMM_WORLD, &world);
+    mpi_set_engine_comm(MPI_COMM_SELF);
+
+    for (;;)
+    {
+        MPI_Recv(msg, FARM_MAX_GROUP + 2 + workers, MPI_INT, 0, FARM_TAG_WORK, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        int k = msg[0];
+        if (k == 0)
+        {
+            break;
+        }
+
+        int m = msg[1 + k];
+        MPI_Comm team = MPI_COMM_SELF;
+        if (m > 1)
+        {
+            MPI_Group group;
+            MPI_Group_incl(world, m, msg + 2 + k, &group);
+            MPI_Comm_create_group(MPI_COMM_WORLD, group, FARM_TAG_TEAM, &team);
+            MPI_Group_free(&group);
+            mpi_set_engine_comm(team);
+        }
+
+        for (int j = 0; j < k; j++)
+        {
+            results[j] = farm_invert(paths[msg[1 + j]], msg[1 + j], team, cfg);
+        }
+        int rank;
+        MPI_Comm_rank(team, &rank);
+        if (rank == 0)
+        {
+            MPI_Send(results, k * sizeof(*results), MPI_BYTE, 0, FARM_TAG_RESULT, MPI_COMM_WORLD);
+        }
+
+        /* Every rank of the team lets go of it here, before the master can hand them out apart */
+        if (m > 1)
+        {
+            mpi_set_engine_comm(MPI_COMM_SELF);
+            MPI_Comm_free(&team);
+        }
+    }
+
+    mpi_set_engine_comm(MPI_COMM_NULL);
+    MPI_Group_free(&world);
+    free(msg);
+}
+
+int run_mpi_farm(char **paths, int count, const struct farm_config *cfg)
+{
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int failures = 0;
+    if (size == 1)
+    {
+        /* No workers: the master inverts everything itself, in file order */
+        double start = MPI_Wtime();
+        for (int i = 0; i < count; i++)
+        {
+            struct farm_result res = farm_invert(paths[i], i, MPI_COMM_WORLD, cfg);
+            farm_report(&res, paths, 0, 1);
+            failures += !res.ok;
+        }
+        double elapsed_ms = (MPI_Wtime() - start) * 1000.0;
+        printf("MPI farm: %d matrices on 1 rank in %.3f ms (%.1f matrices/s), %d failed.\n", count, elapsed_ms,
+               elapsed_ms > 0.0 ? 1000.0 * count / elapsed_ms : 0.0, failures);
+        return failures;
+    }
+
+    int workers = size - 1;
+    if (cfg->team_size == 0)
+    {
+        if (rank == 0)
+        {
+            failures = farm_sized_master(paths, count, workers);
+        }
+        else
+        {
+            farm_sized_worker(paths, workers, cfg);
+        }
+        MPI_Bcast(&failures, 1, MPI_INT, 0, MPI_COMM_WORLD);
+        return failures;
+    }
+
+    int team_size = cfg->team_size > workers ? workers : cfg->team_size;
+    int teams = (workers + team_size - 1) / team_size;
+
+    /* World rank 1 + t * team_size leads team t */
+    MPI_Comm team;
+    MPI_Comm_split(MPI_COMM_WORLD, rank == 0 ? MPI_UNDEFINED : (rank - 1) / team_size, rank, &team);
+    if (rank == 0)
+    {
+        failures = farm_master(paths, count, teams, team_size, workers);
+    }
+    else
+    {
+        mpi_set_engine_comm(team);
+        farm_worker(paths, team, cfg);
+        mpi_set_engine_comm(MPI_COMM_NULL);
+        MPI_Comm_free(&team);
+    }
+
+    MPI_Bcast(&failures, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    return failures;
+}
@@ -0,0 +1,42 @@
+#ifndef MPI_FARM_H
+#define MPI_FARM_H
+
+#include <stdbool.h>
+
+#include "helpers/verify.h"
+
+/* Master-worker farm for batches of independent matrices.
+ *
+ * One inversion across all ranks pays a pivot broadcast per row, which
+ * small and mid-size matrices cannot amortize. A batch gets more done by
+ * inverting different matrices side by side: rank 0 keeps the work list
+ * and hands it to teams of the other ranks, each running the MPI engine on
+ * a communicator of its own. By default a team is put together per share:
+ * small matrices get one rank, a large one up to a rank per fixed amount of
+ * its work when there are ranks to spare. With team_size set, the workers
+ * are split once into teams of that many ranks (the last one may be
+ * smaller).
+ *
+ * Scheduling is dynamic: the master reads only the dimensions of every
+ * file, orders them largest first, and hands a team its next share as soon
+ * as it reports the last one, so teams that drew small matrices simply
+ * take more of them. A share is one matrix, or several small ones adding up
+ * to a fixed amount of work, never more than half of what is left per team.
+ * Every team leader reads its own input (the files must be visible to all
+ * ranks, as for -path=) and writes the inverse; only the indices and a
+ * short result per matrix go through the master.
+ *
+ * With a single rank the master inverts everything itself.
+ */
+struct farm_config
+{
+    int team_size;           /* Ranks per matrix, 0 to size the team of every share from its work */
+    const char *out_dir;     /* Where to write the inverses, NULL to discard them */
+    enum verify_mode verify; /* Checked by the team leader, reported by the master */
+};
+
+/* Inverts every file of paths over the ranks of MPI_COMM_WORLD. Collective, paths must be the same on every
+ * rank. Returns the number of files that failed, on every rank. */
+int run_mpi_farm(char **paths, int count, const struct farm_config *cfg);
+
+#endif // MPI_FARM_H
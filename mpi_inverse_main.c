@@ -3,8 +3,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include "matrix_inverse_mpi.h"
+#include "mpi_comm_profiler.h"
+#include "mpi_farm.h"
 #include "helpers/common.h"
 #include "helpers/file_reader.h"
+#include "helpers/cli_options.h"
+#include "helpers/profiler.h"
+#include "helpers/tracer.h"
+#include "helpers/verify.h"
+#include "helpers/condition.h"
+#include "helpers/matrix_gen.h"
+#include "helpers/batch_pipeline.h"
 #include <string.h>
 #include <stdbool.h>
 #include <stddef.h>
@@ -12,38 +21,101 @@
 #define EPSILON 1e-10
 
 double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol);
+double **load_input_matrix(const struct cli_options *opts, int *nrow, int *ncol);
 bool invert_matrix_from_file(const char *filepath);
+bool invert_input_matrix(const struct cli_options *opts);
+bool invert_input_matrix_typed(const struct cli_options *opts);
+bool invert_matrices_in_farm(const struct cli_options *opts);
+void report_profile_by_rank(void);
+bool write_trace_by_rank(const char *path);
+bool verify_on_root(int n, double **mat, double mat_inv[n][n], enum verify_mode verify);
 
 /* Main function to perform matrix inversion */
 int main(int argc, char *argv[])
 {
     MPI_Init(&argc, &argv); // Initializes the MPI environment and sets up communication between processes.
 
-    if (argc < 2)
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    struct cli_options opts;
+    init_cli_options(&opts);
+    if (argc < 2 || !parse_cli_options(argc, argv, &opts))
     {
-        fprintf(stderr, "Usage: %s -path=<file_path>\n", argv[0]);
+        if (rank == 0)
+        {
+            print_usage(argv[0]);
+        }
+        MPI_Finalize();
         return 1;
     }
 
-    const char *filepath = NULL;
-
-    // Parse command-line arguments
-    for (int i = 1; i < argc; i++)
+    if (is_batch_mode(&opts) && opts.concurrent_cores != 0)
     {
-        if (strncmp(argv[i], "-path=", 6) == 0)
+        if (rank == 0)
         {
-            filepath = argv[i] + 6; // Extract file path
+            fprintf(stderr, "Error: -concurrent is for the OpenMP program, the MPI program farms a batch out with -team=<ranks>.\n");
         }
+        MPI_Finalize();
+        return 1;
     }
 
-    if (!filepath)
+    if (opts.profile)
     {
-        fprintf(stderr, "Error: File path not specified. Use -path=<file_path>.\n");
-        return 1;
+        prof_enable(opts.profile_counters);
+    }
+    if (opts.mpi_profile)
+    {
+        comm_prof_enable(opts.mpi_profile_sync);
+    }
+    cond_set_limit(opts.cond_limit);
+    if (opts.trace_path)
+    {
+        /* Start every rank's timeline at (roughly) the same instant */
+        MPI_Barrier(MPI_COMM_WORLD);
+        trace_enable(0);
+    }
+
+    bool ok;
+    if (is_batch_mode(&opts))
+    {
+        ok = invert_matrices_in_farm(&opts);
     }
+    else
+    {
+        ok = opts.precision == SCALAR_DOUBLE ? invert_input_matrix(&opts) : invert_input_matrix_typed(&opts);
+    }
+
+    report_profile_by_rank();
+    comm_prof_report(MPI_COMM_WORLD);
+    ok = (!opts.trace_path || write_trace_by_rank(opts.trace_path)) && ok;
+
+    MPI_Finalize(); // Clean up all resources allocated
+
+    return ok ? 0 : 1;
+}
+
+/* Invert every matrix of a directory or manifest, rank 0 handing them out to teams of the other ranks */
+bool invert_matrices_in_farm(const struct cli_options *opts)
+{
+    char **paths;
+    int count;
+    if (!list_batch_files(opts->dirpath, opts->manifest, &paths, &count))
+    {
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    struct farm_config cfg = {opts->team_ranks, opts->out_dir, opts->verify};
+    int failures = run_mpi_farm(paths, count, &cfg);
+    free_batch_files(paths, count);
+    return failures == 0;
+}
 
+/* Invert the double matrix of -path= or -generate=, every rank loads (or generates, identically) the whole matrix */
+bool invert_input_matrix(const struct cli_options *opts)
+{
     int nrow, ncol;
-    double **mat = allocate_and_read_matrix(filepath, &nrow, &ncol);
+    double **mat = load_input_matrix(opts, &nrow, &ncol);
 
     // printf("\n********** Matrix Original start**********\n\n");
 
@@ -53,20 +125,98 @@ int main(int argc, char *argv[])
 
     if (!mat)
     {
-        return false;
+        MPI_Abort(MPI_COMM_WORLD, 1);
     }
 
-    benchmark_inversion(mat, nrow, ncol);
+    /* Contiguous storage behind the row pointers so the inverse can be verified as a whole */
+    int n = nrow;
+    double (*mat_inv)[n] = malloc(sizeof(double[n][n]));
+    double **mat_inv_rows = malloc(n * sizeof(double *));
+    if (!mat_inv || !mat_inv_rows)
+    {
+        perror("malloc (inverse)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    for (int i = 0; i < n; i++)
+    {
+        mat_inv_rows[i] = mat_inv[i];
+    }
 
+    bool ok = benchmark_inversion(mat, nrow, ncol, mat_inv_rows);
+    if (ok && opts->verify != VERIFY_NONE)
+    {
+        ok = verify_on_root(n, mat, mat_inv, opts->verify);
+    }
+
+    free(mat_inv_rows);
+    free(mat_inv);
     for (int i = 0; i < nrow; i++)
     {
         free(mat[i]);
     }
     free(mat);
+    return ok;
+}
 
-    MPI_Finalize(); // Clean up all resources allocated
+/* Invert a float or complex matrix, only rank 0 loads (or generates) it */
+bool invert_input_matrix_typed(const struct cli_options *opts)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    enum scalar_type type = opts->precision;
+    int n = 0;
+    void *mat = NULL;
+    if (rank == 0)
+    {
+        mat = load_typed_input_matrix(opts, &n);
+    }
+    MPI_Bcast(&n, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    if (n == 0)
+    {
+        return false;
+    }
+
+    void *mat_inv = rank == 0 ? malloc((size_t)n * n * scalar_size(type)) : NULL;
+    if (rank == 0 && !mat_inv)
+    {
+        perror("malloc (inverse)");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    bool ok = benchmark_inversion_typed(type, n, mat, mat_inv);
+    if (ok && opts->verify != VERIFY_NONE)
+    {
+        if (rank == 0)
+        {
+            struct verify_result res;
+            ok = verify_inverse_typed(type, opts->verify, n, mat, mat_inv, &res);
+            print_verify_result(stdout, "MPI", &res);
+        }
+        MPI_Bcast(&ok, 1, MPI_C_BOOL, 0, MPI_COMM_WORLD);
+    }
 
-    return 0;
+    free(mat_inv);
+    free(mat);
+    return ok;
+}
+
+/* The input matrix: generated in memory with -generate=, read from -path= otherwise */
+double **load_input_matrix(const struct cli_options *opts, int *nrow, int *ncol)
+{
+    if (!opts->generate)
+    {
+        return allocate_and_read_matrix(opts->filepath, nrow, ncol);
+    }
+
+    double **mat;
+    if (!generate_matrix_rows(&opts->generate_spec, &mat))
+    {
+        fprintf(stderr, "Failed to generate the matrix\n");
+        return NULL;
+    }
+    *nrow = *ncol = opts->generate_spec.n;
+    return mat;
 }
 
 /* Helper function to allocate and read a matrix */
@@ -80,3 +230,116 @@ double **allocate_and_read_matrix(const char *filepath, int *nrow, int *ncol)
     }
     return mat;
 }
+
+/* Verify the inverse gathered on rank 0 and share the verdict with every rank */
+bool verify_on_root(int n, double **mat, double mat_inv[n][n], enum verify_mode verify)
+{
+    int rank;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    bool ok = true;
+    if (rank == 0)
+    {
+        double (*mat_cp)[n] = malloc(sizeof(double[n][n]));
+        if (!mat_cp)
+        {
+            perror("malloc (matrix copy)");
+            ok = false;
+        }
+        else
+        {
+            struct verify_result res;
+            copy_matrix(n, n, mat, mat_cp);
+            ok = verify_inverse(verify, n, mat_cp, mat_inv, &res);
+            print_verify_result(stdout, "MPI", &res);
+            free(mat_cp);
+        }
+    }
+    MPI_Bcast(&ok, 1, MPI_C_BOOL, 0, MPI_COMM_WORLD);
+    return ok;
+}
+
+/* Print the phase breakdown of every rank, in rank order */
+void report_profile_by_rank(void)
+{
+    if (!prof_enabled())
+    {
+        return;
+    }
+
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    char label[32];
+    snprintf(label, sizeof(label), "rank %d", rank);
+    for (int r = 0; r < size; r++)
+    {
+        if (r == rank)
+        {
+            prof_report(stdout, label);
+        }
+        MPI_Barrier(MPI_COMM_WORLD);
+    }
+}
+
+/* Gather the timeline of every rank on rank 0 and write it as one trace, one pid per rank */
+bool write_trace_by_rank(const char *path)
+{
+    int rank, size;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    char label[32];
+    snprintf(label, sizeof(label), "rank %d", rank);
+    char *fragment = trace_serialize(rank, label);
+    int len = fragment ? (int)strlen(fragment) + 1 : 0;
+
+    int *lens = NULL, *displs = NULL;
+    char *all = NULL;
+    if (rank == 0)
+    {
+        lens = malloc(size * sizeof(int));
+        displs = malloc(size * sizeof(int));
+    }
+    MPI_Gather(&len, 1, MPI_INT, lens, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    int total = 0;
+    if (rank == 0)
+    {
+        for (int r = 0; r < size; r++)
+        {
+            displs[r] = total;
+            total += lens[r];
+        }
+        all = malloc(total > 0 ? total : 1);
+    }
+    MPI_Gatherv(fragment, len, MPI_CHAR, all, lens, displs, MPI_CHAR, 0, MPI_COMM_WORLD);
+    free(fragment);
+
+    bool ok = true;
+    if (rank == 0)
+    {
+        /* Ranks whose serialization failed sent nothing and are left out */
+        char **fragments = malloc(size * sizeof(char *));
+        int count = 0;
+        for (int r = 0; r < size; r++)
+        {
+            if (lens[r] > 0)
+            {
+                fragments[count++] = all + displs[r];
+            }
+        }
+        ok = count == size && trace_write_fragments(path, fragments, count);
+        if (ok)
+        {
+            printf("Trace of %d ranks written to %s\n", size, path);
+        }
+        free(fragments);
+        free(all);
+        free(lens);
+        free(displs);
+    }
+    MPI_Bcast(&ok, 1, MPI_C_BOOL, 0, MPI_COMM_WORLD);
+    return ok;
+}